@@ -0,0 +1,204 @@
+#ifndef CLUSTERED_LIGHTING_H
+#define CLUSTERED_LIGHTING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <engine/JobSystem.h>
+#include <engine/StreamBuffer.h>
+
+/**
+ * @struct GPULight
+ * @brief One light as the shaders read it: three RGBA32F texels in view space.
+ *
+ * Directional lights have a range of 0. Point lights have cos(outer) = -2, so the spot falloff
+ * is always 1 for them.
+ */
+struct GPULight {
+    glm::vec4 positionRange{0.0f};     ///< xyz = view-space position, w = range
+    glm::vec4 colorInnerCos{0.0f};     ///< rgb = color * intensity, w = cos(inner cone angle)
+    glm::vec4 directionOuterCos{0.0f}; ///< xyz = view-space direction, w = cos(outer cone angle)
+};
+
+/**
+ * @struct LightGridData
+ * @brief CPU mirror of the std140 "LightGrid" uniform block.
+ */
+struct LightGridData {
+    glm::ivec4 gridSize{0};      ///< xyz = clusters per axis, w = directional light count
+    glm::vec4 gridScale{0.0f};   ///< xy = clusters per pixel, z/w = depth slice scale/bias
+    glm::vec4 ambient{1.0f};     ///< rgb = ambient term added to every fragment
+};
+
+/**
+ * @struct LightFrame
+ * @brief Everything the shaders need for one frame of lighting, produced on the CPU.
+ *
+ * Directional lights come first in @p lights; clusters only reference the lights after them.
+ */
+struct LightFrame {
+    LightGridData grid;
+    std::vector<GPULight> lights;
+    std::vector<uint32_t> clusters; ///< (offset into indices, count) per cluster
+    std::vector<uint32_t> indices;  ///< Light indices of every cluster, back to back
+    int shadowLight{-1};             ///< Index in lights of the shadowed directional light
+    glm::vec3 shadowDirection{0.0f}; ///< World-space direction of that light
+};
+
+/**
+ * @class LightClusterGrid
+ * @brief Bins view-space point and spot lights into a froxel grid (clustered forward shading).
+ *
+ * The view frustum is split into GRID_X x GRID_Y screen tiles and GRID_Z depth slices spaced
+ * exponentially between the near and far planes. Each cluster keeps the list of lights whose
+ * volume touches its view-space box, so a fragment only shades the lights of its own cluster.
+ *
+ * Depth slices are assigned in parallel over a JobSystem. Within a slice, the lights overlapping
+ * its depth range are stored structure-of-arrays and tested eight (AVX) or four (SSE2/NEON) at a
+ * time, first against each row of tiles and then against the row's clusters: sphere vs box for
+ * the light range, plus a cone vs bounding sphere test for spot lights. No GL is involved.
+ */
+class LightClusterGrid {
+  public:
+    static constexpr int GRID_X = 16;
+    static constexpr int GRID_Y = 9;
+    static constexpr int GRID_Z = 24;
+    static constexpr int CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+    static constexpr size_t LANES = 8; ///< Padding granularity, covers every SIMD width used
+
+    /**
+     * @brief Set the camera projection; cluster boxes are only rebuilt when it changes.
+     * @param projection Perspective projection matrix.
+     * @param nearPlane Near plane distance the projection was built with.
+     * @param farPlane Far plane distance; the last slice ends there.
+     */
+    void setProjection(const glm::mat4& projection, float nearPlane, float farPlane);
+
+    /**
+     * @brief Build the light list of every cluster.
+     * @param lights View-space lights; those with a range of 0 (directional) are skipped.
+     * @param clusters Receives CLUSTER_COUNT (offset, count) pairs into @p indices.
+     * @param indices Receives the indices into @p lights of each cluster, back to back.
+     * @param jobs Pool the depth slices are spread over; nullptr runs them on this thread.
+     */
+    void assign(const std::vector<GPULight>& lights,
+                std::vector<uint32_t>& clusters,
+                std::vector<uint32_t>& indices,
+                JobSystem* jobs);
+
+    /// Slice of a view-space depth d is floor(log(d) * getSliceScale() + getSliceBias())
+    float getSliceScale() const {
+        return sliceScale;
+    }
+
+    float getSliceBias() const {
+        return sliceBias;
+    }
+
+  private:
+    struct ClusterBounds {
+        glm::vec3 min;
+        glm::vec3 max;
+        glm::vec3 center; ///< Bounding sphere, used by the cone test
+        float radius;
+    };
+
+    /// Point/spot lights structure-of-arrays, padded to LANES with lights that never hit
+    struct LightColumns {
+        std::vector<float> x, y, z, range;
+        std::vector<float> dirX, dirY, dirZ;
+        std::vector<float> cosAngle, sinAngle; ///< Outer cone; cos -1 / sin 0 for point lights
+        std::vector<float> back;     ///< Back face cull slack, infinite when the cone is wide
+        std::vector<uint32_t> ids;   ///< Index into the lights given to assign()
+        size_t count{0};
+
+        void clear();
+        void push(const LightColumns& from, size_t index);
+        void pad();
+    };
+
+    struct SliceWork {
+        LightColumns candidates;    ///< Lights reaching the slice's depth range
+        LightColumns rowCandidates; ///< Subset touching the current row of tiles
+        std::vector<uint32_t> hits; ///< Scratch output of testCluster()
+        uint32_t counts[GRID_X * GRID_Y];
+        std::vector<uint32_t> indices;
+    };
+
+    glm::mat4 projection{0.0f};
+    float nearPlane{0.0f};
+    float farPlane{0.0f};
+    float sliceScale{0.0f};
+    float sliceBias{0.0f};
+    std::vector<ClusterBounds> bounds;
+    std::vector<ClusterBounds> rowBounds; ///< Union of each row of clusters within a slice
+    std::vector<float> sliceDepths; ///< GRID_Z + 1 view-space depths bounding the slices
+    LightColumns lightColumns;
+    std::vector<SliceWork> slices;
+
+    void assignSlice(int slice);
+
+    /// Write the positions in @p lights of those touching @p cluster; returns how many
+    static size_t testCluster(const ClusterBounds& cluster,
+                              const LightColumns& lights,
+                              uint32_t* out);
+};
+
+/**
+ * @class LightBuffers
+ * @brief GPU copy of a LightFrame: three buffer textures plus the LightGrid uniform block.
+ *
+ * GL 3.3 buffer textures can only view a whole buffer (glTexBufferRange is 4.3), so the texture
+ * data streams in Orphan mode, which always writes from offset 0. The small uniform block uses
+ * the default mode. Programs get the sampler units and block binding in the Shader constructor.
+ */
+class LightBuffers {
+  public:
+    static constexpr unsigned int BINDING = 1;
+    static constexpr const char* BLOCK_NAME = "LightGrid";
+
+    static constexpr unsigned int CLUSTER_UNIT = 1;
+    static constexpr unsigned int INDEX_UNIT = 2;
+    static constexpr unsigned int LIGHT_UNIT = 3;
+    static constexpr const char* CLUSTER_SAMPLER = "lightClusters";
+    static constexpr const char* INDEX_SAMPLER = "lightIndices";
+    static constexpr const char* LIGHT_SAMPLER = "lights";
+
+    LightBuffers() = default;
+    LightBuffers(const LightBuffers&) = delete;
+    LightBuffers& operator=(const LightBuffers&) = delete;
+
+    /// Upload @p frame and bind it for the following draws
+    void update(const LightFrame& frame);
+
+    /// Delete the buffers and textures; call on the context thread
+    void release();
+
+  private:
+    struct BufferTexture {
+        StreamBuffer stream;
+        GLenum format;
+        unsigned int unit;
+        unsigned int texture{0};
+        unsigned int attached{0}; ///< Buffer the texture currently views
+
+        void upload(const void* data, GLsizeiptr size);
+        void release();
+    };
+
+    BufferTexture clusters{{GL_TEXTURE_BUFFER, 32 * 1024, StreamBuffer::Mode::Orphan},
+                           GL_RG32UI,
+                           CLUSTER_UNIT};
+    BufferTexture indices{{GL_TEXTURE_BUFFER, 64 * 1024, StreamBuffer::Mode::Orphan},
+                          GL_R32UI,
+                          INDEX_UNIT};
+    BufferTexture lights{{GL_TEXTURE_BUFFER, 64 * 1024, StreamBuffer::Mode::Orphan},
+                         GL_RGBA32F,
+                         LIGHT_UNIT};
+    StreamBuffer gridUniforms{GL_UNIFORM_BUFFER, 512};
+    GLsizeiptr alignment{0}; ///< GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, queried on first use
+};
+
+#endif
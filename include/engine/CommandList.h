@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <engine/RenderQueue.h>
+
+/**
+ * @class CommandList
+ * @brief Draw packets recorded by one worker, with no GL calls involved.
+ *
+ * Workers each fill their own list in parallel; the GL thread then merges the lists into a
+ * RenderQueue, sorts it and replays it. A list only holds sort keys and DrawItems, so recording
+ * is independent of the backend that eventually executes the packets.
+ */
+class CommandList {
+  public:
+    static constexpr int MAX_LOD_LEVELS = 4;
+
+    void clear() {
+        keys.clear();
+        items.clear();
+        for (uint32_t& count : lodLevels) {
+            count = 0;
+        }
+    }
+
+    void reserve(size_t count) {
+        keys.reserve(count);
+        items.reserve(count);
+    }
+
+    void push(uint64_t key, const DrawItem& item) {
+        keys.push_back(key);
+        items.push_back(item);
+    }
+
+    size_t size() const {
+        return items.size();
+    }
+
+    const std::vector<uint64_t>& getKeys() const {
+        return keys;
+    }
+
+    const std::vector<DrawItem>& getItems() const {
+        return items;
+    }
+
+    /// Per-level MeshLOD counts recorded alongside the packets, merged into the frame stats
+    uint32_t lodLevels[MAX_LOD_LEVELS] = {};
+
+  private:
+    std::vector<uint64_t> keys;
+    std::vector<DrawItem> items;
+};
@@ -0,0 +1,348 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+#include <glm/glm.hpp>
+#include <engine/JobSystem.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/**
+ * @struct AABB
+ * @brief Axis-aligned bounding box given by its corners.
+ */
+struct AABB {
+    glm::vec3 min{0.0f};
+    glm::vec3 max{0.0f};
+};
+
+/**
+ * @enum CullingMode
+ * @brief Where the camera frustum test runs.
+ */
+enum class CullingMode : uint8_t {
+    Cpu, ///< FrustumCuller, before the draws are recorded
+    Gpu  ///< GpuCuller, per instanced run at submit time; needs batching
+};
+
+/**
+ * @struct Frustum
+ * @brief Six inward-facing planes (left, right, bottom, top, near, far).
+ *
+ * Each plane is stored as (normal.xyz, distance) so that a point p is inside when
+ * dot(normal, p) + distance >= 0.
+ */
+struct Frustum {
+    glm::vec4 planes[6];
+
+    /// Extract the planes of a view-projection matrix (Gribb/Hartmann), normalized
+    static Frustum fromMatrix(const glm::mat4& viewProj) {
+        // glm is column-major: m[col][row]; rows of the matrix give the clip-space inequalities
+        glm::vec4 row0(viewProj[0][0], viewProj[1][0], viewProj[2][0], viewProj[3][0]);
+        glm::vec4 row1(viewProj[0][1], viewProj[1][1], viewProj[2][1], viewProj[3][1]);
+        glm::vec4 row2(viewProj[0][2], viewProj[1][2], viewProj[2][2], viewProj[3][2]);
+        glm::vec4 row3(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+
+        Frustum frustum;
+        frustum.planes[0] = row3 + row0;
+        frustum.planes[1] = row3 - row0;
+        frustum.planes[2] = row3 + row1;
+        frustum.planes[3] = row3 - row1;
+        frustum.planes[4] = row3 + row2;
+        frustum.planes[5] = row3 - row2;
+        for (auto& plane : frustum.planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+        return frustum;
+    }
+
+    /// Scalar test of one box given by center and half extents
+    bool intersects(const glm::vec3& center, const glm::vec3& extents) const {
+        for (const auto& plane : planes) {
+            glm::vec3 normal(plane);
+            float distance = glm::dot(normal, center) + plane.w;
+            float radius = glm::dot(glm::abs(normal), extents);
+            if (distance + radius < 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief World-space center and half extents of a local box under an affine transform (Arvo).
+ */
+inline void transformBounds(const glm::mat4& model,
+                            const AABB& local,
+                            glm::vec3& center,
+                            glm::vec3& extents) {
+    glm::vec3 localCenter = (local.min + local.max) * 0.5f;
+    glm::vec3 localExtents = (local.max - local.min) * 0.5f;
+    center = glm::vec3(model * glm::vec4(localCenter, 1.0f));
+    glm::mat3 absolute(glm::abs(glm::vec3(model[0])),
+                       glm::abs(glm::vec3(model[1])),
+                       glm::abs(glm::vec3(model[2])));
+    extents = absolute * localExtents;
+}
+
+/**
+ * @class FrustumCuller
+ * @brief Frustum test over world boxes stored structure-of-arrays.
+ *
+ * Boxes are tested eight (AVX) or four (SSE2/NEON) at a time, with a scalar fallback on other
+ * targets. The arrays are padded with boxes that can never be visible, so the SIMD loops don't
+ * need a scalar tail.
+ */
+class FrustumCuller {
+  public:
+    static constexpr size_t LANES = 8; ///< Padding granularity, covers every SIMD width used
+
+    void clear() {
+        count = 0;
+        forEachColumn([](std::vector<float>& column) { column.clear(); });
+    }
+
+    void reserve(size_t boxes) {
+        forEachColumn([&](std::vector<float>& column) { column.reserve(boxes + LANES); });
+    }
+
+    void add(const glm::vec3& center, const glm::vec3& extents) {
+        cx.push_back(center.x);
+        cy.push_back(center.y);
+        cz.push_back(center.z);
+        ex.push_back(extents.x);
+        ey.push_back(extents.y);
+        ez.push_back(extents.z);
+        ++count;
+    }
+
+    /// Set the box count up front so set() can fill slots from several threads
+    void resize(size_t boxes) {
+        count = boxes;
+        forEachColumn([&](std::vector<float>& column) { column.resize(boxes); });
+    }
+
+    void set(size_t index, const glm::vec3& center, const glm::vec3& extents) {
+        cx[index] = center.x;
+        cy[index] = center.y;
+        cz[index] = center.z;
+        ex[index] = extents.x;
+        ey[index] = extents.y;
+        ez[index] = extents.z;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    /**
+     * @brief Test every box on the calling thread.
+     * @param frustum Planes to test against.
+     * @param visible Receives the indices of intersecting boxes, ascending.
+     */
+    void cull(const Frustum& frustum, std::vector<uint32_t>& visible) {
+        pad();
+        visible.resize(count);
+        size_t written = cullRange(frustum, 0, count, visible.data());
+        visible.resize(written);
+    }
+
+    /**
+     * @brief Same as cull(), split into chunks across a JobSystem.
+     * @param chunkSize Boxes per chunk, rounded up to a multiple of LANES.
+     */
+    void cullParallel(const Frustum& frustum,
+                      std::vector<uint32_t>& visible,
+                      JobSystem& jobs,
+                      size_t chunkSize = 16384) {
+        pad();
+        chunkSize = (std::max<size_t>(chunkSize, LANES) + LANES - 1) / LANES * LANES;
+        size_t chunks = JobSystem::chunkCount(count, chunkSize);
+        visible.resize(count);
+        chunkVisible.assign(chunks, 0);
+
+        // Each chunk compacts into its own slice of the output, then the slices are joined
+        jobs.parallelFor(count, chunkSize, [&](size_t begin, size_t end) {
+            chunkVisible[begin / chunkSize] = cullRange(frustum, begin, end, &visible[begin]);
+        });
+
+        size_t written = 0;
+        for (size_t chunk = 0; chunk < chunks; ++chunk) {
+            size_t begin = chunk * chunkSize;
+            std::copy(&visible[begin], &visible[begin] + chunkVisible[chunk], &visible[written]);
+            written += chunkVisible[chunk];
+        }
+        visible.resize(written);
+    }
+
+  private:
+    size_t count{0};
+    std::vector<float> cx, cy, cz; ///< Centers
+    std::vector<float> ex, ey, ez; ///< Half extents
+    std::vector<size_t> chunkVisible;
+
+    template <typename Fn> void forEachColumn(Fn&& fn) {
+        for (auto* column : {&cx, &cy, &cz, &ex, &ey, &ez}) {
+            fn(*column);
+        }
+    }
+
+    // Padding boxes sit infinitely far behind every plane, so they are always rejected
+    void pad() {
+        size_t padded = (count + LANES - 1) / LANES * LANES;
+        forEachColumn([&](std::vector<float>& column) { column.resize(count); });
+        cx.resize(padded, NAN);
+        cy.resize(padded, NAN);
+        cz.resize(padded, NAN);
+        ex.resize(padded, 0.0f);
+        ey.resize(padded, 0.0f);
+        ez.resize(padded, 0.0f);
+    }
+
+    /// Test boxes [begin, end) and write visible indices to @p out; returns how many were written
+    size_t cullRange(const Frustum& frustum, size_t begin, size_t end, uint32_t* out) const {
+        size_t written = 0;
+
+#if defined(__AVX__)
+        __m256 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+        for (int p = 0; p < 6; ++p) {
+            const glm::vec4& plane = frustum.planes[p];
+            planeX[p] = _mm256_set1_ps(plane.x);
+            planeY[p] = _mm256_set1_ps(plane.y);
+            planeZ[p] = _mm256_set1_ps(plane.z);
+            planeW[p] = _mm256_set1_ps(plane.w);
+            absX[p] = _mm256_set1_ps(std::fabs(plane.x));
+            absY[p] = _mm256_set1_ps(std::fabs(plane.y));
+            absZ[p] = _mm256_set1_ps(std::fabs(plane.z));
+        }
+
+        for (size_t i = begin; i < end; i += 8) {
+            __m256 x = _mm256_loadu_ps(&cx[i]);
+            __m256 y = _mm256_loadu_ps(&cy[i]);
+            __m256 z = _mm256_loadu_ps(&cz[i]);
+            __m256 hx = _mm256_loadu_ps(&ex[i]);
+            __m256 hy = _mm256_loadu_ps(&ey[i]);
+            __m256 hz = _mm256_loadu_ps(&ez[i]);
+            int outsideMask = 0;
+            for (int p = 0; p < 6 && outsideMask != 0xFF; ++p) {
+                __m256 distance = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(x, planeX[p]), _mm256_mul_ps(y, planeY[p])),
+                    _mm256_add_ps(_mm256_mul_ps(z, planeZ[p]), planeW[p]));
+                __m256 radius = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(hx, absX[p]), _mm256_mul_ps(hy, absY[p])),
+                    _mm256_mul_ps(hz, absZ[p]));
+                // "not >=" is true for NaN, so padding boxes count as outside
+                outsideMask |= _mm256_movemask_ps(_mm256_cmp_ps(
+                    _mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_NGE_UQ));
+            }
+            if (outsideMask != 0xFF) {
+                written += emitMask(~outsideMask & 0xFF, i, end, out + written);
+            }
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        __m128 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+        for (int p = 0; p < 6; ++p) {
+            const glm::vec4& plane = frustum.planes[p];
+            planeX[p] = _mm_set1_ps(plane.x);
+            planeY[p] = _mm_set1_ps(plane.y);
+            planeZ[p] = _mm_set1_ps(plane.z);
+            planeW[p] = _mm_set1_ps(plane.w);
+            absX[p] = _mm_set1_ps(std::fabs(plane.x));
+            absY[p] = _mm_set1_ps(std::fabs(plane.y));
+            absZ[p] = _mm_set1_ps(std::fabs(plane.z));
+        }
+
+        for (size_t i = begin; i < end; i += 4) {
+            __m128 x = _mm_loadu_ps(&cx[i]);
+            __m128 y = _mm_loadu_ps(&cy[i]);
+            __m128 z = _mm_loadu_ps(&cz[i]);
+            __m128 hx = _mm_loadu_ps(&ex[i]);
+            __m128 hy = _mm_loadu_ps(&ey[i]);
+            __m128 hz = _mm_loadu_ps(&ez[i]);
+            int outsideMask = 0;
+            for (int p = 0; p < 6 && outsideMask != 0xF; ++p) {
+                __m128 distance =
+                    _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, planeX[p]), _mm_mul_ps(y, planeY[p])),
+                               _mm_add_ps(_mm_mul_ps(z, planeZ[p]), planeW[p]));
+                __m128 radius =
+                    _mm_add_ps(_mm_add_ps(_mm_mul_ps(hx, absX[p]), _mm_mul_ps(hy, absY[p])),
+                               _mm_mul_ps(hz, absZ[p]));
+                // "not >=" is true for NaN, so padding boxes count as outside
+                outsideMask |=
+                    _mm_movemask_ps(_mm_cmpnge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+            }
+            if (outsideMask != 0xF) {
+                written += emitMask(~outsideMask & 0xF, i, end, out + written);
+            }
+        }
+#elif defined(__ARM_NEON)
+        for (size_t i = begin; i < end; i += 4) {
+            uint32x4_t inside = vdupq_n_u32(~0u);
+            float32x4_t x = vld1q_f32(&cx[i]);
+            float32x4_t y = vld1q_f32(&cy[i]);
+            float32x4_t z = vld1q_f32(&cz[i]);
+            float32x4_t hx = vld1q_f32(&ex[i]);
+            float32x4_t hy = vld1q_f32(&ey[i]);
+            float32x4_t hz = vld1q_f32(&ez[i]);
+            for (const auto& plane : frustum.planes) {
+                float32x4_t distance = vmlaq_n_f32(
+                    vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(plane.w), x, plane.x), y, plane.y),
+                    z,
+                    plane.z);
+                float32x4_t radius = vmlaq_n_f32(
+                    vmlaq_n_f32(vmulq_n_f32(hx, std::fabs(plane.x)), hy, std::fabs(plane.y)),
+                    hz,
+                    std::fabs(plane.z));
+                // ">=" is false for NaN, so padding boxes drop out
+                inside = vandq_u32(inside, vcgeq_f32(vaddq_f32(distance, radius), vdupq_n_f32(0)));
+            }
+            int visibleMask = (vgetq_lane_u32(inside, 0) & 1) | (vgetq_lane_u32(inside, 1) & 2) |
+                              (vgetq_lane_u32(inside, 2) & 4) | (vgetq_lane_u32(inside, 3) & 8);
+            written += emitMask(visibleMask, i, end, out + written);
+        }
+#else
+        for (size_t i = begin; i < end; ++i) {
+            glm::vec3 center(cx[i], cy[i], cz[i]);
+            if (frustum.intersects(center, glm::vec3(ex[i], ey[i], ez[i]))) {
+                out[written++] = static_cast<uint32_t>(i);
+            }
+        }
+#endif
+        return written;
+    }
+
+    /// Append the indices of the set bits of @p mask (lane 0 = @p base), ignoring lanes past end
+    static size_t emitMask(int mask, size_t base, size_t end, uint32_t* out) {
+        size_t written = 0;
+        while (mask != 0) {
+            int lane = countTrailingZeros(static_cast<unsigned int>(mask));
+            mask &= mask - 1;
+            size_t index = base + lane;
+            if (index < end) {
+                out[written++] = static_cast<uint32_t>(index);
+            }
+        }
+        return written;
+    }
+
+    static int countTrailingZeros(unsigned int value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctz(value);
+#else
+        int bits = 0;
+        while ((value & 1u) == 0u) {
+            value >>= 1;
+            ++bits;
+        }
+        return bits;
+#endif
+    }
+};
@@ -1,5 +1,5 @@
 #pragma once
-#include <GLFW/glfw3.h>
+#include <chrono>
 
 struct Time {
     float deltaTime;
@@ -14,15 +14,19 @@ class DeltaTime { // rename to avoid collisions
         return time;
     }
 
+    // steady_clock rather than glfwGetTime, so headless runs work without initializing GLFW
     void calculateDeltaTime() {
-        currentFrame = static_cast<float>(glfwGetTime());
+        currentFrame = std::chrono::duration<float>(Clock::now() - start).count();
         time.deltaTime = currentFrame - lastFrame;
         time.elapsedTime += time.deltaTime;
         lastFrame = currentFrame;
     }
 
   private:
+    using Clock = std::chrono::steady_clock;
+
     Time time{0.0f, 0.0f};
+    Clock::time_point start{Clock::now()};
     float currentFrame = 0.0f;
     float lastFrame = 0.0f;
 };
@@ -0,0 +1,80 @@
+#ifndef DEPTH_PREPASS_H
+#define DEPTH_PREPASS_H
+
+#include <cstdint>
+
+/**
+ * @enum DepthPrepassMode
+ * @brief Whether opaque geometry lays down depth before it is shaded.
+ *
+ * With a prepass, opaque items are first drawn depth-only, then shaded with GL_EQUAL so every
+ * pixel runs the fragment shader once. It costs a second trip through the vertex stage.
+ */
+enum class DepthPrepassMode : uint8_t {
+    Off,
+    On,
+    Auto ///< Decided from the overdraw OverdrawMonitor measures
+};
+
+/**
+ * @class OverdrawMonitor
+ * @brief Measures how many times each pixel is shaded by the opaque pass, using occlusion queries.
+ *
+ * Every frame counts the samples passing the depth test while opaque geometry is drawn with
+ * GL_LESS (the prepass itself when it runs, so the measure doesn't collapse to 1 once it is on)
+ * and divides by the pixel count. Results are read a few frames late, never waiting on the GPU,
+ * and smoothed. The prepass is preferred above an enable threshold and dropped again below a
+ * lower one, so it doesn't flip on and off around a single value.
+ */
+class OverdrawMonitor {
+  public:
+    static constexpr int LATENCY = 3; ///< Queries in flight; older results are read first
+
+    OverdrawMonitor() = default;
+    OverdrawMonitor(const OverdrawMonitor&) = delete;
+    OverdrawMonitor& operator=(const OverdrawMonitor&) = delete;
+
+    /// Shaded fragments per pixel to start using the prepass, and to stop using it again
+    void setThresholds(float enable, float disable) {
+        enableThreshold = enable;
+        disableThreshold = disable < enable ? disable : enable;
+    }
+
+    /// Collect finished results, then start counting this frame's opaque samples
+    void begin();
+
+    /// Stop counting; @p pixels is the area the samples were drawn over
+    void end(uint64_t pixels);
+
+    /// Smoothed samples per pixel, 0 until the first result arrives
+    float getOverdraw() const {
+        return overdraw;
+    }
+
+    bool prefersPrepass() const {
+        return prepass;
+    }
+
+    /// Delete the queries; call on the context thread
+    void release();
+
+  private:
+    struct Slot {
+        unsigned int query{0};
+        uint64_t pixels{0};
+        bool pending{false};
+    };
+
+    Slot slots[LATENCY];
+    int next{0};
+    bool active{false}; ///< A query was started by begin() and awaits end()
+    float overdraw{0.0f};
+    bool measured{false};
+    bool prepass{false};
+    float enableThreshold{1.6f};
+    float disableThreshold{1.3f};
+
+    void collect();
+};
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @class GpuFrameTimer
+ * @brief GPU time of whole frames, from GL_TIME_ELAPSED queries read back a few frames late.
+ *
+ * Lives on the thread that owns the GL context; the latest result can be read from any thread.
+ * A frame whose query slot is still busy simply isn't measured, nothing ever waits on the GPU.
+ */
+class GpuFrameTimer {
+  public:
+    static constexpr int LATENCY = 3; ///< Queries in flight
+
+    GpuFrameTimer() = default;
+    GpuFrameTimer(const GpuFrameTimer&) = delete;
+    GpuFrameTimer& operator=(const GpuFrameTimer&) = delete;
+
+    /// Collect finished results, then start timing this frame
+    void begin();
+
+    void end();
+
+    /// GPU time of the most recently finished frame in milliseconds, 0 before the first
+    float getMilliseconds() const {
+        return milliseconds.load(std::memory_order_relaxed);
+    }
+
+    /// Grows by one with every result, so readers can tell a new one from a repeat
+    uint32_t getResultCount() const {
+        return results.load(std::memory_order_acquire);
+    }
+
+    /// Delete the queries; call on the context thread
+    void release();
+
+  private:
+    struct Slot {
+        unsigned int query{0};
+        bool pending{false};
+    };
+
+    Slot slots[LATENCY];
+    int next{0};
+    bool active{false};
+    std::atomic<float> milliseconds{0.0f};
+    std::atomic<uint32_t> results{0};
+};
+
+/**
+ * @class ResolutionController
+ * @brief Picks the render scale from measured GPU frame times; derive to change the policy.
+ */
+class ResolutionController {
+  public:
+    virtual ~ResolutionController() = default;
+
+    /**
+     * @brief Pick the scale to render the coming frames at.
+     * @param gpuMilliseconds GPU time of a recent frame.
+     * @param scale Scale currently in use.
+     * @return New scale; DynamicResolution clamps it to its range.
+     */
+    virtual float update(float gpuMilliseconds, float scale) = 0;
+};
+
+/**
+ * @class FrameBudgetController
+ * @brief Keeps GPU frame time under a budget, dropping resolution at once and raising it slowly.
+ *
+ * GPU time mostly follows the pixel count, i.e. the square of the scale, so the scale that
+ * would land on the target is the current one times the square root of target over measured
+ * time. Over budget it jumps there; well under it, it only moves part of the way each result,
+ * and in between it holds, so measurement noise doesn't make the resolution pump.
+ */
+class FrameBudgetController : public ResolutionController {
+  public:
+    explicit FrameBudgetController(float budgetMilliseconds = 16.0f)
+        : budget(std::max(budgetMilliseconds, 0.1f)) {}
+
+    float update(float gpuMilliseconds, float scale) override;
+
+  private:
+    float budget;
+};
+
+/**
+ * @class DynamicResolution
+ * @brief Render scale of the scene, driven by a ResolutionController.
+ *
+ * Configured and updated on the thread that records frames; the only thing shared with the
+ * render thread is the GpuFrameTimer result it reads. The controller runs once per new result.
+ */
+class DynamicResolution {
+  public:
+    DynamicResolution() : controller(std::make_unique<FrameBudgetController>()) {}
+
+    /// Disabled, every frame renders at the maximum scale
+    void setEnabled(bool value) {
+        enabled = value;
+    }
+
+    bool isEnabled() const {
+        return enabled;
+    }
+
+    /// Fractions of the back buffer size the scale stays between, e.g. 0.5 and 1
+    void setScaleRange(float minimum, float maximum) {
+        maxScale = std::max(0.1f, std::min(maximum, 1.0f));
+        minScale = std::max(0.1f, std::min(minimum, maxScale));
+        scale = std::max(minScale, std::min(scale, maxScale));
+    }
+
+    void setController(std::unique_ptr<ResolutionController> policy) {
+        if (policy != nullptr) {
+            controller = std::move(policy);
+        }
+    }
+
+    /// Feed the latest result of @p timer to the controller, if it is new; returns the scale
+    /// to render this frame at
+    float update(const GpuFrameTimer& timer);
+
+    float getScale() const {
+        return enabled ? scale : maxScale;
+    }
+
+  private:
+    std::unique_ptr<ResolutionController> controller;
+    bool enabled{false};
+    float minScale{0.5f};
+    float maxScale{1.0f};
+    float scale{1.0f};
+    uint32_t seenResults{0};
+};
+
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <engine/RenderDevice.h>
+#include <engine/StreamBuffer.h>
+
+/**
+ * @struct FrameData
+ * @brief CPU mirror of the std140 "FrameData" uniform block declared by the shaders.
+ *
+ * Only mat4 and vec4 members, so the C++ layout matches std140 without padding fields.
+ */
+struct FrameData {
+    glm::mat4 view{1.0f};
+    glm::mat4 projection{1.0f};
+    glm::vec4 cameraPosition{0.0f}; ///< xyz = world position, w unused
+    glm::vec4 time{0.0f};           ///< x = elapsed seconds, y = delta seconds
+};
+
+/**
+ * @class FrameUniformBuffer
+ * @brief UBO holding FrameData, written once per frame through a StreamBuffer.
+ *
+ * Each frame takes a fresh range of the stream, so the CPU never overwrites data the GPU may
+ * still be reading from the previous frames, and binds that range at BINDING for every shader.
+ */
+class FrameUniformBuffer {
+  public:
+    static constexpr unsigned int BINDING = 0;
+    static constexpr const char* BLOCK_NAME = "FrameData";
+
+    FrameUniformBuffer() = default;
+    FrameUniformBuffer(const FrameUniformBuffer&) = delete;
+    FrameUniformBuffer& operator=(const FrameUniformBuffer&) = delete;
+
+    /// Delete the buffer. Not done by the destructor: owners tend to outlive the GL context.
+    void release() {
+        stream.release();
+    }
+
+    /// Upload this frame's data into a new range of the stream and bind it at BINDING
+    void update(const FrameData& data) {
+        RenderDevice& device = RenderDevice::current();
+        if (alignment == 0) {
+            alignment = std::max(device.getInteger(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT), 1);
+        }
+
+        stream.beginFrame(sizeof(FrameData) + alignment); // Worst case padding included
+        StreamAllocation allocation = stream.allocate(sizeof(FrameData), alignment);
+        if (!allocation) {
+            return;
+        }
+        std::memcpy(allocation.data, &data, sizeof(FrameData));
+        stream.flush();
+        device.bindBufferRange(
+            GL_UNIFORM_BUFFER, BINDING, allocation.buffer, allocation.offset, sizeof(FrameData));
+    }
+
+  private:
+    static constexpr GLsizeiptr STREAM_CAPACITY = 512; ///< Grown if the alignment needs more
+
+    StreamBuffer stream{GL_UNIFORM_BUFFER, STREAM_CAPACITY};
+    GLsizeiptr alignment{0}; ///< GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, queried on first use
+};
@@ -0,0 +1,395 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+
+/**
+ * @struct GLStateStats
+ * @brief Counts of state calls forwarded to GL versus skipped because nothing changed.
+ */
+struct GLStateStats {
+    uint32_t issued{0}; ///< Calls that reached the driver
+    uint32_t elided{0}; ///< Redundant calls that were skipped
+};
+
+/**
+ * @class GLState
+ * @brief Shadow copy of the GL state the engine touches, used to skip redundant calls.
+ *
+ * All engine binds and fixed-function state changes go through here. The shadow assumes nobody
+ * else changes GL state behind its back; call invalidate() after code that does (third party
+ * libraries, a new context) so the next call of each kind is forwarded again.
+ *
+ * Objects must be deleted through the delete* helpers, otherwise a recycled GL name could be
+ * mistaken for the still-bound old object.
+ */
+class GLState {
+  public:
+    static constexpr int MAX_TEXTURE_UNITS = 16;
+    static constexpr int MAX_UNIFORM_BINDINGS = 16;
+
+    static void useProgram(unsigned int program) {
+        if (track(currentProgram, program)) {
+            glUseProgram(program);
+        }
+    }
+
+    static void bindVertexArray(unsigned int vao) {
+        if (track(currentVAO, vao)) {
+            glBindVertexArray(vao);
+        }
+    }
+
+    /**
+     * @brief Bind a buffer to a non-VAO binding point.
+     *
+     * GL_ELEMENT_ARRAY_BUFFER belongs to the bound VAO, so it is always forwarded.
+     */
+    static void bindBuffer(GLenum target, unsigned int buffer) {
+        int slot = bufferSlot(target);
+        if (slot < 0) {
+            ++stats.issued;
+            glBindBuffer(target, buffer);
+            return;
+        }
+        if (track(currentBuffers[slot], buffer)) {
+            glBindBuffer(target, buffer);
+        }
+    }
+
+    /**
+     * @brief Bind a range of a buffer to an indexed binding point (uniform blocks).
+     *
+     * Like glBindBufferRange, this also replaces the generic binding of @p target.
+     */
+    static void bindBufferRange(GLenum target,
+                                unsigned int index,
+                                unsigned int buffer,
+                                GLintptr offset,
+                                GLsizeiptr size) {
+        int slot = bufferSlot(target);
+        if (target != GL_UNIFORM_BUFFER || index >= MAX_UNIFORM_BINDINGS) {
+            ++stats.issued;
+            glBindBufferRange(target, index, buffer, offset, size);
+            if (slot >= 0) {
+                currentBuffers[slot] = buffer;
+            }
+            return;
+        }
+
+        IndexedBinding requested{buffer, offset, size};
+        if (track(currentUniformBindings[index], requested)) {
+            glBindBufferRange(target, index, buffer, offset, size);
+            currentBuffers[slot] = buffer;
+        }
+    }
+
+    static void activeTexture(unsigned int unit) {
+        if (track(currentUnit, unit)) {
+            glActiveTexture(GL_TEXTURE0 + unit);
+        }
+    }
+
+    /// Bind @p texture to @p target on texture unit @p unit, switching the active unit if needed
+    static void bindTexture(unsigned int unit, GLenum target, unsigned int texture) {
+        int slot = textureSlot(target);
+        if (slot < 0 || unit >= MAX_TEXTURE_UNITS) {
+            activeTexture(unit);
+            ++stats.issued;
+            glBindTexture(target, texture);
+            return;
+        }
+        if (track(currentTextures[unit][slot], texture)) {
+            activeTexture(unit);
+            glBindTexture(target, texture);
+        }
+    }
+
+    static void bindFramebuffer(unsigned int framebuffer) {
+        bool changed = track(currentReadFramebuffer, framebuffer);
+        changed = track(currentDrawFramebuffer, framebuffer) || changed;
+        if (changed) {
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        }
+    }
+
+    static void bindFramebuffer(GLenum target, unsigned int framebuffer) {
+        if (target == GL_FRAMEBUFFER) {
+            bindFramebuffer(framebuffer);
+            return;
+        }
+        unsigned int& current =
+            target == GL_READ_FRAMEBUFFER ? currentReadFramebuffer : currentDrawFramebuffer;
+        if (track(current, framebuffer)) {
+            glBindFramebuffer(target, framebuffer);
+        }
+    }
+
+    /**
+     * @brief Framebuffer that stands in for the window's back buffer.
+     *
+     * 0 for a windowed context. Headless contexts render into an FBO and register it here, so
+     * passes that finish on the back buffer should bind defaultFramebuffer() rather than 0.
+     */
+    static void setDefaultFramebuffer(unsigned int framebuffer) {
+        currentDefaultFramebuffer = framebuffer;
+    }
+
+    static unsigned int defaultFramebuffer() {
+        return currentDefaultFramebuffer;
+    }
+
+    /// Enable or disable one of GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE; others are forwarded
+    static void setEnabled(GLenum capability, bool enabled) {
+        unsigned int value = enabled ? 1u : 0u;
+        unsigned int* current = capabilitySlot(capability);
+        if (current != nullptr && !track(*current, value)) {
+            return;
+        }
+        if (current == nullptr) {
+            ++stats.issued;
+        }
+        if (enabled) {
+            glEnable(capability);
+        } else {
+            glDisable(capability);
+        }
+    }
+
+    static void depthMask(bool write) {
+        if (track(currentDepthMask, write ? 1u : 0u)) {
+            glDepthMask(write ? GL_TRUE : GL_FALSE);
+        }
+    }
+
+    static void colorMask(bool write) {
+        if (track(currentColorMask, write ? 1u : 0u)) {
+            GLboolean value = write ? GL_TRUE : GL_FALSE;
+            glColorMask(value, value, value, value);
+        }
+    }
+
+    static void depthFunc(GLenum func) {
+        if (track(currentDepthFunc, func)) {
+            glDepthFunc(func);
+        }
+    }
+
+    static void blendFunc(GLenum src, GLenum dst) {
+        blendFuncSeparate(src, dst, src, dst);
+    }
+
+    static void
+    blendFuncSeparate(GLenum srcColor, GLenum dstColor, GLenum srcAlpha, GLenum dstAlpha) {
+        if (track(currentBlend, BlendFunc{srcColor, dstColor, srcAlpha, dstAlpha})) {
+            glBlendFuncSeparate(srcColor, dstColor, srcAlpha, dstAlpha);
+        }
+    }
+
+    static void viewport(int x, int y, int width, int height) {
+        bool changed = track(currentViewport[0], x);
+        changed = track(currentViewport[1], y) || changed;
+        changed = track(currentViewport[2], width) || changed;
+        changed = track(currentViewport[3], height) || changed;
+        if (changed) {
+            glViewport(x, y, width, height);
+        }
+    }
+
+    static void deleteProgram(unsigned int program) {
+        if (program == currentProgram) {
+            currentProgram = 0;
+        }
+        glDeleteProgram(program);
+    }
+
+    static void deleteVertexArray(unsigned int vao) {
+        if (vao == currentVAO) {
+            currentVAO = 0;
+        }
+        glDeleteVertexArrays(1, &vao);
+    }
+
+    static void deleteBuffer(unsigned int buffer) {
+        for (unsigned int& bound : currentBuffers) {
+            if (bound == buffer) {
+                bound = 0;
+            }
+        }
+        for (IndexedBinding& binding : currentUniformBindings) {
+            if (binding.buffer == buffer) {
+                binding = IndexedBinding{};
+            }
+        }
+        glDeleteBuffers(1, &buffer);
+    }
+
+    static void deleteTexture(unsigned int texture) {
+        for (auto& unit : currentTextures) {
+            for (unsigned int& bound : unit) {
+                if (bound == texture) {
+                    bound = 0;
+                }
+            }
+        }
+        glDeleteTextures(1, &texture);
+    }
+
+    static void deleteFramebuffer(unsigned int framebuffer) {
+        if (framebuffer == currentReadFramebuffer) {
+            currentReadFramebuffer = 0;
+        }
+        if (framebuffer == currentDrawFramebuffer) {
+            currentDrawFramebuffer = 0;
+        }
+        if (framebuffer == currentDefaultFramebuffer) {
+            currentDefaultFramebuffer = 0;
+        }
+        glDeleteFramebuffers(1, &framebuffer);
+    }
+
+    /// Forget the shadowed state; the next call of every kind is forwarded to GL
+    static void invalidate() {
+        currentProgram = UNKNOWN;
+        currentVAO = UNKNOWN;
+        currentUnit = UNKNOWN;
+        for (unsigned int& buffer : currentBuffers) {
+            buffer = UNKNOWN;
+        }
+        for (auto& unit : currentTextures) {
+            for (unsigned int& texture : unit) {
+                texture = UNKNOWN;
+            }
+        }
+        for (IndexedBinding& binding : currentUniformBindings) {
+            binding = IndexedBinding{UNKNOWN, 0, 0};
+        }
+        currentReadFramebuffer = UNKNOWN;
+        currentDrawFramebuffer = UNKNOWN;
+        for (unsigned int& capability : currentCapabilities) {
+            capability = UNKNOWN;
+        }
+        currentDepthMask = UNKNOWN;
+        currentColorMask = UNKNOWN;
+        currentDepthFunc = UNKNOWN;
+        currentBlend = BlendFunc{UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN};
+        for (int& value : currentViewport) {
+            value = -1;
+        }
+    }
+
+    static unsigned int boundProgram() {
+        return currentProgram;
+    }
+
+    static const GLStateStats& frameStats() {
+        return stats;
+    }
+
+    /// Call once per frame, before rendering starts
+    static void resetFrameStats() {
+        stats = GLStateStats{};
+    }
+
+  private:
+    enum BufferSlot { ARRAY_BUFFER, UNIFORM_BUFFER, TEXTURE_BUFFER, BUFFER_SLOT_COUNT };
+    enum TextureSlot { TEXTURE_2D, TEXTURE_2D_ARRAY, TEXTURE_BUFFER_TARGET, TEXTURE_SLOT_COUNT };
+    enum CapabilitySlot { DEPTH_TEST, BLEND, CULL_FACE, CAPABILITY_COUNT };
+
+    static constexpr unsigned int UNKNOWN = ~0u; ///< Matches no real value, forces a call
+
+    // No member initializers: value-initialization already zeroes it, and GCC rejects them in
+    // the static array below before the enclosing class is complete
+    struct IndexedBinding {
+        unsigned int buffer;
+        GLintptr offset;
+        GLsizeiptr size;
+
+        bool operator==(const IndexedBinding& other) const {
+            return buffer == other.buffer && offset == other.offset && size == other.size;
+        }
+    };
+
+    struct BlendFunc {
+        GLenum srcColor;
+        GLenum dstColor;
+        GLenum srcAlpha;
+        GLenum dstAlpha;
+
+        bool operator==(const BlendFunc& other) const {
+            return srcColor == other.srcColor && dstColor == other.dstColor &&
+                   srcAlpha == other.srcAlpha && dstAlpha == other.dstAlpha;
+        }
+    };
+
+    static inline GLStateStats stats;
+
+    static inline unsigned int currentProgram = UNKNOWN;
+    static inline unsigned int currentVAO = UNKNOWN;
+    static inline unsigned int currentUnit = UNKNOWN;
+    static inline unsigned int currentBuffers[BUFFER_SLOT_COUNT] = {UNKNOWN, UNKNOWN, UNKNOWN};
+    // A fresh context has nothing bound on any unit, so zero is the correct starting shadow
+    static inline unsigned int currentTextures[MAX_TEXTURE_UNITS][TEXTURE_SLOT_COUNT] = {};
+    static inline IndexedBinding currentUniformBindings[MAX_UNIFORM_BINDINGS] = {};
+    static inline unsigned int currentReadFramebuffer = UNKNOWN;
+    static inline unsigned int currentDrawFramebuffer = UNKNOWN;
+    static inline unsigned int currentDefaultFramebuffer = 0;
+    static inline unsigned int currentCapabilities[CAPABILITY_COUNT] = {UNKNOWN, UNKNOWN, UNKNOWN};
+    static inline unsigned int currentDepthMask = UNKNOWN;
+    static inline unsigned int currentColorMask = UNKNOWN;
+    static inline unsigned int currentDepthFunc = UNKNOWN;
+    static inline BlendFunc currentBlend = {UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN};
+    static inline int currentViewport[4] = {-1, -1, -1, -1};
+
+    /**
+     * @brief Update a shadowed value and count the call.
+     * @return True if the call must be forwarded to GL.
+     */
+    template <typename T> static bool track(T& current, const T& value) {
+        if (current == value) {
+            ++stats.elided;
+            return false;
+        }
+        current = value;
+        ++stats.issued;
+        return true;
+    }
+
+    static int bufferSlot(GLenum target) {
+        switch (target) {
+        case GL_ARRAY_BUFFER:
+            return ARRAY_BUFFER;
+        case GL_UNIFORM_BUFFER:
+            return UNIFORM_BUFFER;
+        case GL_TEXTURE_BUFFER:
+            return TEXTURE_BUFFER;
+        default:
+            return -1;
+        }
+    }
+
+    static int textureSlot(GLenum target) {
+        switch (target) {
+        case GL_TEXTURE_2D:
+            return TEXTURE_2D;
+        case GL_TEXTURE_2D_ARRAY:
+            return TEXTURE_2D_ARRAY;
+        case GL_TEXTURE_BUFFER:
+            return TEXTURE_BUFFER_TARGET;
+        default:
+            return -1;
+        }
+    }
+
+    static unsigned int* capabilitySlot(GLenum capability) {
+        switch (capability) {
+        case GL_DEPTH_TEST:
+            return &currentCapabilities[DEPTH_TEST];
+        case GL_BLEND:
+            return &currentCapabilities[BLEND];
+        case GL_CULL_FACE:
+            return &currentCapabilities[CULL_FACE];
+        default:
+            return nullptr;
+        }
+    }
+};
@@ -0,0 +1,103 @@
+#ifndef GPU_CULLING_H
+#define GPU_CULLING_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <engine/RenderDevice.h>
+
+/**
+ * @struct InstanceStreams
+ * @brief Where per-instance data sits in a GL buffer.
+ *
+ * Either separate tightly packed arrays (stride 0), instance i being i elements into each, or
+ * one interleaved record per instance, @p stride bytes apart.
+ */
+struct InstanceStreams {
+    unsigned int buffer{0};
+    GLintptr matrices{0};
+    GLintptr layers{0};
+    GLintptr uvTransforms{0};
+    GLintptr bounds{0}; ///< Mesh-space min and max (vec3 each); only GpuCuller reads them
+    GLsizei stride{0};
+};
+
+/**
+ * @class GpuCuller
+ * @brief Frustum culling of instance data on the GPU through transform feedback, for GL 3.3.
+ *
+ * Each run of instances is drawn as points with rasterization off: the vertex shader tests
+ * the instance's box against the frustum, the geometry shader emits only the visible ones,
+ * and transform feedback packs their matrix, uvTransform and layer into the run's slice of
+ * an output buffer. A GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN query per run gives the
+ * instance count of the draw reading that slice. GL 3.3 can't take that count from the GPU
+ * directly (glDrawTransformFeedback is GL 4.0 and counts vertices, not instances), so the
+ * first draw of a run waits for its query; every run is queued before the first draw, so
+ * the wait overlaps the other culling work.
+ *
+ * Must be used on the thread that owns the GL context.
+ */
+class GpuCuller {
+  public:
+    /// Output record of one visible instance: matrix, uvTransform, then layer
+    static constexpr GLsizei OUTPUT_STRIDE = sizeof(glm::mat4) + sizeof(glm::vec4) + sizeof(float);
+
+    /// Shader files, compiled by prepare() or the first beginFrame()
+    void setSources(const std::string& vertex, const std::string& geometry);
+
+    /// Build the program unless that was tried already; false if beginFrame() couldn't cull
+    bool prepare();
+
+    /**
+     * @brief Start culling @p count instances of @p input against @p viewProj.
+     * @return false if the program couldn't be built; nothing is culled then.
+     */
+    bool beginFrame(const InstanceStreams& input, size_t count, const glm::mat4& viewProj);
+
+    /// Queue the test of instances [first, first + count), which become one run
+    void cull(size_t first, size_t count);
+
+    void endFrame();
+
+    /// Run starting at instance @p first, -1 if none was queued this frame
+    int findRun(size_t first) const;
+
+    /// Visible instances of @p run; waits for the GPU the first time it is asked
+    GLsizei getVisibleCount(int run);
+
+    /// Visible instance data of @p run, packed from its first record
+    InstanceStreams getOutput(int run) const;
+
+    /// Instances found outside the frustum this frame, over the runs counted so far
+    size_t getCulledCount() const {
+        return culledCount;
+    }
+
+    /// Delete the program, buffer, vertex array and queries; call on the context thread
+    void release();
+
+  private:
+    struct Run {
+        size_t first;
+        size_t count;
+        unsigned int query;
+        GLsizei visible{-1}; ///< -1 until the query was read
+    };
+
+    std::string vertexPath;
+    std::string geometryPath;
+    unsigned int program{0};
+    bool failed{false}; ///< Building the program failed; don't retry every frame
+    int planeLocations[6] = {-1, -1, -1, -1, -1, -1};
+    unsigned int vertexArray{0};
+    unsigned int output{0};
+    GLsizeiptr outputCapacity{0};
+    std::vector<Run> runs; ///< This frame's, by first instance
+    std::vector<unsigned int> queries;
+    size_t culledCount{0};
+
+    bool build();
+};
+
+#endif
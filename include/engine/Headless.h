@@ -0,0 +1,89 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @class HeadlessContext
+ * @brief Window-less GL 3.3 core context rendering into an offscreen framebuffer.
+ *
+ * Uses a surfaceless EGL display, which Mesa serves with llvmpipe on machines without a GPU.
+ * The framebuffer is registered as GLState::defaultFramebuffer(), so the rest of the engine
+ * renders into it exactly as it would into a window.
+ *
+ * The EGL code is only compiled with ENGINE_HEADLESS defined (link with -lEGL); without it
+ * create() reports the missing support and fails.
+ */
+class HeadlessContext {
+  public:
+    HeadlessContext() = default;
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+    ~HeadlessContext() {
+        destroy();
+    }
+
+    /**
+     * @brief Create the context, load GL and allocate the framebuffer.
+     * @param width Framebuffer width in pixels.
+     * @param height Framebuffer height in pixels.
+     * @return False if any step failed; the reason is printed.
+     */
+    bool create(int width, int height);
+
+    /// Release the framebuffer and the context
+    void destroy();
+
+    /**
+     * @brief Read back the color buffer and write it as a binary PPM (P6).
+     * @param path Output file.
+     * @return False if the file couldn't be written.
+     */
+    bool saveImage(const std::string& path) const;
+
+    int getWidth() const {
+        return width;
+    }
+
+    int getHeight() const {
+        return height;
+    }
+
+  private:
+    int width{0};
+    int height{0};
+    void* display{nullptr}; ///< EGLDisplay, kept opaque so EGL headers stay out of the engine
+    void* context{nullptr}; ///< EGLContext
+    unsigned int framebuffer{0};
+    unsigned int colorBuffer{0};
+    unsigned int depthBuffer{0};
+
+    bool createFramebuffer();
+};
+
+/**
+ * @class FrameTimeStats
+ * @brief Collects per-frame times and reports their distribution.
+ */
+class FrameTimeStats {
+  public:
+    void add(double milliseconds) {
+        samples.push_back(milliseconds);
+    }
+
+    size_t count() const {
+        return samples.size();
+    }
+
+    /// Print frame count, mean, min, max, percentiles and average FPS
+    void report(std::ostream& out) const;
+
+  private:
+    std::vector<double> samples;
+};
+
+#endif
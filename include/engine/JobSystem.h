@@ -0,0 +1,158 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class JobSystem
+ * @brief Fixed pool of worker threads for data-parallel loops.
+ *
+ * parallelFor splits a range into chunks that the workers and the calling thread pull from a
+ * shared counter, and returns once every chunk has run. Jobs must not touch GL.
+ */
+class JobSystem {
+  public:
+    /**
+     * @brief Start the workers.
+     * @param workerCount Number of threads besides the caller; defaults to one less than the
+     * hardware thread count.
+     */
+    explicit JobSystem(unsigned int workerCount = defaultWorkerCount()) {
+        for (unsigned int i = 0; i < workerCount; ++i) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    ~JobSystem() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    /// Process-wide pool shared by the engine systems
+    static JobSystem& shared() {
+        static JobSystem instance;
+        return instance;
+    }
+
+    size_t workerCount() const {
+        return workers.size();
+    }
+
+    /// Number of chunks parallelFor will use for @p count items with chunks of @p grain
+    static size_t chunkCount(size_t count, size_t grain) {
+        grain = std::max<size_t>(grain, 1);
+        return (count + grain - 1) / grain;
+    }
+
+    /**
+     * @brief Run fn(begin, end) over [0, count) in chunks of @p grain items.
+     *
+     * Chunk i covers [i * grain, min((i + 1) * grain, count)), so callers can index per-chunk
+     * outputs with begin / grain. Blocks until all chunks are done; the caller runs chunks too.
+     */
+    template <typename Fn> void parallelFor(size_t count, size_t grain, Fn&& fn) {
+        grain = std::max<size_t>(grain, 1);
+        size_t chunks = chunkCount(count, grain);
+        if (chunks == 0) {
+            return;
+        }
+        if (chunks == 1 || workers.empty()) {
+            for (size_t begin = 0; begin < count; begin += grain) {
+                fn(begin, std::min(begin + grain, count));
+            }
+            return;
+        }
+
+        // Shared with helpers that may only get scheduled after this call returned; they then
+        // find no chunk left and never touch the body
+        auto loop = std::make_shared<ParallelLoop>();
+        loop->count = count;
+        loop->grain = grain;
+        loop->chunks = chunks;
+        loop->body = [&fn](size_t begin, size_t end) { fn(begin, end); };
+
+        size_t helpers = std::min(workers.size(), chunks - 1);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 0; i < helpers; ++i) {
+                tasks.emplace_back([loop] { loop->run(); });
+            }
+        }
+        wake.notify_all();
+
+        loop->run();
+        std::unique_lock<std::mutex> lock(loop->doneMutex);
+        loop->doneCondition.wait(lock, [&] { return loop->finished == loop->chunks; });
+    }
+
+  private:
+    struct ParallelLoop {
+        size_t count{0};
+        size_t grain{1};
+        size_t chunks{0};
+        std::function<void(size_t, size_t)> body;
+        std::atomic<size_t> next{0};
+        size_t finished{0}; ///< Guarded by doneMutex
+        std::mutex doneMutex;
+        std::condition_variable doneCondition;
+
+        void run() {
+            size_t done = 0;
+            for (size_t chunk = next++; chunk < chunks; chunk = next++) {
+                size_t begin = chunk * grain;
+                body(begin, std::min(begin + grain, count));
+                ++done;
+            }
+            if (done > 0) {
+                std::lock_guard<std::mutex> lock(doneMutex);
+                finished += done;
+                if (finished == chunks) {
+                    doneCondition.notify_all();
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping{false};
+
+    static unsigned int defaultWorkerCount() {
+        unsigned int hardware = std::thread::hardware_concurrency();
+        return hardware > 1 ? hardware - 1 : 0;
+    }
+
+    void workerLoop() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (stopping && tasks.empty()) {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+};
@@ -0,0 +1,90 @@
+#ifndef OCCLUSION_CULLING_H
+#define OCCLUSION_CULLING_H
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @class OcclusionBuffer
+ * @brief Low-resolution CPU depth buffer for software occlusion culling.
+ *
+ * Occluder triangles are rasterized into the buffer keeping the nearest depth per pixel, then
+ * candidate boxes are tested by comparing their nearest depth against the pixels their screen
+ * rectangle covers. A per-tile maximum depth lets most tests finish without touching pixels.
+ *
+ * Depth is NDC z remapped to [0, 1], 0 at the near plane. Everything runs on the CPU with no GL
+ * involvement, so results are identical with or without a GPU.
+ */
+class OcclusionBuffer {
+  public:
+    static constexpr int TILE_WIDTH = 8;
+    static constexpr int TILE_HEIGHT = 8;
+
+    /**
+     * @brief Allocate the buffer.
+     * @param width Width in pixels, rounded up to a multiple of TILE_WIDTH.
+     * @param height Height in pixels, rounded up to a multiple of TILE_HEIGHT.
+     */
+    OcclusionBuffer(int width = 256, int height = 128);
+
+    /**
+     * @brief Reset every pixel to the far plane and set the camera for this frame.
+     * @param viewProj View-projection matrix used for rasterization and tests.
+     */
+    void begin(const glm::mat4& viewProj);
+
+    /**
+     * @brief Rasterize a triangle list.
+     * @param model Object-to-world matrix.
+     * @param vertices Mesh-space positions, three per triangle.
+     * @param count Number of vertices.
+     *
+     * Triangles crossing the near plane are skipped; dropping an occluder is always safe.
+     */
+    void rasterize(const glm::mat4& model, const glm::vec3* vertices, size_t count);
+
+    /**
+     * @brief Build the per-tile max depth. Call after the last rasterize() of the frame.
+     */
+    void finish();
+
+    /**
+     * @brief Test a world-space box against the buffer.
+     * @param center Box center.
+     * @param extents Box half extents.
+     * @return False only if every covered pixel has an occluder in front of the box.
+     */
+    bool isVisible(const glm::vec3& center, const glm::vec3& extents) const;
+
+    int getWidth() const {
+        return width;
+    }
+
+    int getHeight() const {
+        return height;
+    }
+
+    /// Row-major depth values, row 0 at the bottom of the screen
+    const std::vector<float>& getDepth() const {
+        return depth;
+    }
+
+  private:
+    int width;
+    int height;
+    int tilesX;
+    int tilesY;
+    glm::mat4 viewProj{1.0f};
+    std::vector<float> depth;
+    std::vector<float> tileMaxDepth; ///< Farthest depth per tile, valid after finish()
+
+    struct ScreenVertex {
+        float x, y, z; ///< Pixel coordinates and [0, 1] depth
+    };
+
+    void rasterizeTriangle(ScreenVertex v0, ScreenVertex v1, ScreenVertex v2);
+    bool rectVisible(int minX, int minY, int maxX, int maxY, float nearestDepth) const;
+};
+
+#endif
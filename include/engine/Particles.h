@@ -0,0 +1,146 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <engine/Shader.h>
+#include <engine/StreamBuffer.h>
+
+/**
+ * @struct ParticleMaterial
+ * @brief How the particles of an emitter look; emitters with equal materials share a draw.
+ */
+struct ParticleMaterial {
+    unsigned int texture{0}; ///< Sprite; 0 draws a soft round dot
+    bool additive{true};     ///< Additive blending, order independent; otherwise alpha blending
+    float size{0.05f};       ///< Billboard edge, world units
+    float fadeTime{0.5f};    ///< Seconds of life over which particles fade out
+
+    bool operator==(const ParticleMaterial& other) const {
+        return texture == other.texture && additive == other.additive && size == other.size &&
+               fadeTime == other.fadeTime;
+    }
+
+    bool operator!=(const ParticleMaterial& other) const {
+        return !(*this == other);
+    }
+};
+
+/**
+ * @struct ParticlePool
+ * @brief Live particles of one emitter, structure-of-arrays.
+ *
+ * Every column holds size() values. Dead particles are swap-removed, so the columns stay dense
+ * but unordered, which is fine as long as particles are blended order independently.
+ */
+struct ParticlePool {
+    std::vector<float> x, y, z;    ///< World position
+    std::vector<float> vx, vy, vz; ///< Velocity, units per second
+    std::vector<float> life;       ///< Seconds left to live
+    std::vector<uint32_t> color;   ///< RGBA8, bytes in that order; constant over the life
+
+    size_t size() const {
+        return life.size();
+    }
+
+    void clear();
+    void reserve(size_t count);
+    void push(const glm::vec3& position,
+              const glm::vec3& velocity,
+              float lifetime,
+              const glm::vec4& color);
+
+    /**
+     * @brief Advance particles [begin, end) by @p dt: gravity, then drag, then position.
+     *
+     * Eight particles at a time with AVX, four with SSE2/NEON. Disjoint ranges may be simulated
+     * on different threads.
+     */
+    void simulate(size_t begin, size_t end, float dt, const glm::vec3& gravity, float drag);
+
+    /// Swap-remove the particles whose life ran out; returns how many were removed
+    size_t compact();
+
+  private:
+    template <typename Fn> void forEachColumn(Fn&& fn) {
+        fn(x);
+        fn(y);
+        fn(z);
+        fn(vx);
+        fn(vy);
+        fn(vz);
+        fn(life);
+        fn(color);
+    }
+};
+
+/**
+ * @struct ParticleDraw
+ * @brief One instanced draw: particles [first, first + count) of a ParticleFrame.
+ */
+struct ParticleDraw {
+    ParticleMaterial material;
+    size_t first{0};
+    size_t count{0};
+};
+
+/**
+ * @struct ParticleFrame
+ * @brief Every live particle of a frame as the particle shader reads it.
+ *
+ * @p columns holds COLUMN_COUNT arrays of @p count floats back to back, in Column order; the
+ * colors follow them in the upload. Draws cover consecutive particles.
+ */
+struct ParticleFrame {
+    enum Column { X, Y, Z, Life, COLUMN_COUNT };
+
+    size_t count{0};
+    std::vector<float> columns;
+    std::vector<uint32_t> colors; ///< RGBA8, as in ParticlePool
+    std::vector<ParticleDraw> draws;
+
+    float* column(Column which) {
+        return columns.data() + which * count;
+    }
+
+    void clear() {
+        count = 0;
+        draws.clear();
+    }
+};
+
+/**
+ * @class ParticleRenderer
+ * @brief Draws a ParticleFrame as camera-facing quads, one instanced draw per ParticleDraw.
+ *
+ * The frame's columns and colors stream to the GPU as they are, as instance attributes 1..4
+ * (floats) and 5 (normalized bytes), next to the quad corners at location 0. GL 3.3 has no
+ * base instance, so every draw re-points the attributes at its first particle. Must be used on
+ * the thread that owns the GL context.
+ */
+class ParticleRenderer {
+  public:
+    static constexpr GLsizeiptr STREAM_CAPACITY = 1 << 20;
+
+    ParticleRenderer() = default;
+    ParticleRenderer(const ParticleRenderer&) = delete;
+    ParticleRenderer& operator=(const ParticleRenderer&) = delete;
+
+    /**
+     * @brief Upload @p frame and draw it with @p shader over the current depth buffer.
+     * @return The draw calls issued.
+     */
+    uint32_t draw(const ParticleFrame& frame, const Shader& shader);
+
+    /// Delete the stream, quad and vertex array; call on the context thread
+    void release();
+
+  private:
+    StreamBuffer stream{GL_ARRAY_BUFFER, STREAM_CAPACITY};
+    unsigned int vertexArray{0};
+    unsigned int quad{0};
+};
+
+#endif
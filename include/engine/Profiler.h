@@ -0,0 +1,161 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+/**
+ * @struct Timing
+ * @brief Smoothed duration of one named section of the frame.
+ */
+struct Timing {
+    const char* name{nullptr}; ///< Must outlive the stats, in practice a string literal
+    float milliseconds{0.0f};
+};
+
+/**
+ * @class TimingStats
+ * @brief Named section timings, exponentially smoothed, from either the CPU or the GPU.
+ *
+ * Sections are kept in the order they were first seen, which for frame sections is the order
+ * they run in.
+ */
+class TimingStats {
+  public:
+    static constexpr float SMOOTHING = 0.1f; ///< Weight of a new sample
+
+    /// Fold one sample of @p name in; the first one is taken as is
+    void add(const char* name, float milliseconds);
+
+    /// Smoothed time of @p name, 0 if it was never timed
+    float get(const char* name) const;
+
+    const std::vector<Timing>& getTimings() const {
+        return timings;
+    }
+
+    /// Print one "name: time" line per section, under @p title
+    void report(std::ostream& out, const char* title) const;
+
+  private:
+    std::vector<Timing> timings;
+};
+
+/**
+ * @class ScopedTimer
+ * @brief Adds the CPU time between construction and destruction to a TimingStats section.
+ */
+class ScopedTimer {
+  public:
+    ScopedTimer(TimingStats& stats, const char* name)
+        : stats(stats), name(name), start(Clock::now()) {}
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    ~ScopedTimer() {
+        std::chrono::duration<float, std::milli> elapsed = Clock::now() - start;
+        stats.add(name, elapsed.count());
+    }
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    TimingStats& stats;
+    const char* name;
+    Clock::time_point start;
+};
+
+/**
+ * @class GpuProfiler
+ * @brief GPU time of named sections of the frame, from GL_TIMESTAMP queries read back late.
+ *
+ * Each section takes two timestamp queries from a pool, so sections may nest, unlike
+ * GL_TIME_ELAPSED queries, and never clash with GpuFrameTimer's. A frame's queries are read
+ * LATENCY frames later once the last one is available, without waiting, and go back to the
+ * pool; a frame whose slot is still busy simply isn't measured. Sections repeated in a frame
+ * add up before smoothing.
+ *
+ * Lives on the thread that owns the GL context; getTimings() may be called from any thread.
+ */
+class GpuProfiler {
+  public:
+    static constexpr int LATENCY = 3; ///< Frames in flight
+
+    /**
+     * @class Scope
+     * @brief Times its own lifetime as a section; does nothing with a null profiler.
+     */
+    class Scope {
+      public:
+        Scope(GpuProfiler* profiler, const char* name) : profiler(profiler) {
+            if (profiler != nullptr) {
+                profiler->begin(name);
+            }
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        ~Scope() {
+            if (profiler != nullptr) {
+                profiler->end();
+            }
+        }
+
+      private:
+        GpuProfiler* profiler;
+    };
+
+    GpuProfiler() = default;
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    /// Collect finished frames, then start measuring this one if its slot is free
+    void beginFrame();
+
+    void endFrame();
+
+    /// Open a section inside the current frame; close it with end()
+    void begin(const char* name);
+
+    void end();
+
+    /// Copy of the smoothed section times, as of the latest finished frame
+    TimingStats getTimings() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return published;
+    }
+
+    /// Delete the queries; call on the context thread
+    void release();
+
+  private:
+    struct Section {
+        const char* name;
+        unsigned int begin;  ///< Timestamp queries
+        unsigned int end{0}; ///< 0 while the section is open
+    };
+
+    struct Frame {
+        std::vector<Section> sections;
+        unsigned int last{0}; ///< Latest timestamp issued; the others are done once it is
+        bool pending{false};
+    };
+
+    Frame frames[LATENCY];
+    int next{0};
+    bool active{false};              ///< This frame is being measured
+    std::vector<size_t> open;        ///< Sections begun but not ended, innermost last
+    std::vector<unsigned int> pool;  ///< Queries free for reuse
+    std::vector<Timing> frameTotals; ///< Scratch for adding up repeated sections
+    TimingStats timings;
+    mutable std::mutex mutex;
+    TimingStats published; ///< Copy of timings readable from other threads
+
+    unsigned int timestamp();
+    void collect(Frame& frame);
+};
+
+#endif
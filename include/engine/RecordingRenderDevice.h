@@ -0,0 +1,327 @@
+#ifndef RECORDING_RENDER_DEVICE_H
+#define RECORDING_RENDER_DEVICE_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <engine/RenderDevice.h>
+
+/**
+ * @enum RenderCommand
+ * @brief One entry per RenderDevice call, used to tag recorded commands.
+ */
+enum class RenderCommand : uint8_t {
+    CreateBuffer,
+    DeleteBuffer,
+    BindBuffer,
+    BindBufferRange,
+    BufferData,
+    BufferSubData,
+    BufferStorage,
+    MapBufferRange,
+    FlushMappedBufferRange,
+    UnmapBuffer,
+    FenceSync,
+    ClientWaitSync,
+    DeleteSync,
+    CreateQuery,
+    DeleteQuery,
+    BeginQuery,
+    EndQuery,
+    QueryCounter,
+    QueryResult,
+    WaitQueryResult,
+    CreateVertexArray,
+    DeleteVertexArray,
+    BindVertexArray,
+    VertexAttribPointer,
+    EnableVertexAttribArray,
+    VertexAttribDivisor,
+    CreateTexture,
+    DeleteTexture,
+    BindTexture,
+    TexParameter,
+    TexImage2D,
+    TexImage3D,
+    TexSubImage2D,
+    TexSubImage3D,
+    GenerateMipmap,
+    TexBuffer,
+    CreateFramebuffer,
+    DeleteFramebuffer,
+    BindFramebuffer,
+    FramebufferTextureLayer,
+    FramebufferTexture,
+    DrawBuffer,
+    DrawBuffers,
+    ReadBuffer,
+    CheckFramebufferStatus,
+    BlitFramebuffer,
+    CompileShader,
+    LinkProgram,
+    LinkFeedbackProgram,
+    DeleteShader,
+    DeleteProgram,
+    UseProgram,
+    GetUniformLocation,
+    UniformBlockBinding,
+    SetUniform,
+    SetEnabled,
+    DepthMask,
+    ColorMask,
+    DepthFunc,
+    BlendFunc,
+    BlendFuncSeparate,
+    PolygonOffset,
+    Viewport,
+    Clear,
+    DrawArrays,
+    DrawArraysInstanced,
+    BeginTransformFeedback,
+    EndTransformFeedback,
+    Finish,
+    GetInteger,
+    GetViewport,
+    Count
+};
+
+/**
+ * @struct RecordedCommand
+ * @brief A captured call: its type and up to four integer arguments (ids, enums, counts).
+ *
+ * Pointers and matrices aren't kept; the stream describes what was issued, not the data.
+ */
+struct RecordedCommand {
+    RenderCommand command;
+    uint32_t args[4];
+};
+
+/**
+ * @class RecordingRenderDevice
+ * @brief RenderDevice without a GL context: counts every call and optionally records it.
+ *
+ * Object ids are handed out sequentially, uniform locations are stable per name, fences signal
+ * immediately, queries finish at once with a result of 0 and mapped ranges point into host
+ * memory sized like the buffer, so the engine runs unchanged. With capture off it acts as a
+ * null backend that only keeps counters, which isolates the CPU cost of the renderer. Unlike
+ * the GL device nothing is elided, so the counts are what the engine asked for, before GLState
+ * filters redundant state.
+ */
+class RecordingRenderDevice : public RenderDevice {
+  public:
+    /// Keep the full command stream (true) or only the counters (false)
+    void setCapture(bool enabled) {
+        capture = enabled;
+    }
+
+    /// Drop recorded commands and zero the counters; object ids keep counting
+    void reset();
+
+    const std::vector<RecordedCommand>& getCommands() const {
+        return commands;
+    }
+
+    uint64_t count(RenderCommand command) const {
+        return counts[static_cast<size_t>(command)];
+    }
+
+    uint64_t totalCommands() const;
+
+    /// Vertices over every draw, instanced draws counting each instance
+    uint64_t getVertexCount() const {
+        return vertexCount;
+    }
+
+    /// Bytes given to bufferData/bufferSubData/texImage2D/3D (4 bytes per texel) or flushed from
+    /// a mapping; writes into coherent persistent mappings go unseen
+    uint64_t getUploadedBytes() const {
+        return uploadedBytes;
+    }
+
+    /// Whether to report GL 4.4 buffer storage, to exercise either streaming path
+    void setBufferStorage(bool enabled) {
+        bufferStorageSupported = enabled;
+    }
+
+    /// Print every non-zero counter, divided by @p frames
+    void report(std::ostream& out, uint64_t frames = 1) const;
+
+    static const char* commandName(RenderCommand command);
+
+    const char* name() const override {
+        return capture ? "Recording" : "Null";
+    }
+
+    unsigned int createBuffer() override;
+    void deleteBuffer(unsigned int buffer) override;
+    void bindBuffer(GLenum target, unsigned int buffer) override;
+    void bindBufferRange(GLenum target,
+                         unsigned int index,
+                         unsigned int buffer,
+                         GLintptr offset,
+                         GLsizeiptr size) override;
+    void bufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) override;
+    void bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) override;
+    bool bufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags) override;
+    bool supportsBufferStorage() const override;
+    void*
+    mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) override;
+    void flushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr length) override;
+    void unmapBuffer(GLenum target) override;
+
+    GLsync fenceSync() override;
+    bool clientWaitSync(GLsync fence, uint64_t timeout) override;
+    void deleteSync(GLsync fence) override;
+
+    unsigned int createQuery() override;
+    void deleteQuery(unsigned int query) override;
+    void beginQuery(GLenum target, unsigned int query) override;
+    void endQuery(GLenum target) override;
+    void queryCounter(unsigned int query) override;
+    bool queryResult(unsigned int query, uint64_t& result) override;
+    uint64_t waitQueryResult(unsigned int query) override;
+
+    unsigned int createVertexArray() override;
+    void deleteVertexArray(unsigned int vao) override;
+    void bindVertexArray(unsigned int vao) override;
+    void vertexAttribPointer(unsigned int index,
+                             int size,
+                             GLenum type,
+                             bool normalized,
+                             GLsizei stride,
+                             size_t offset) override;
+    void enableVertexAttribArray(unsigned int index) override;
+    void vertexAttribDivisor(unsigned int index, unsigned int divisor) override;
+
+    unsigned int createTexture() override;
+    void deleteTexture(unsigned int texture) override;
+    void bindTexture(unsigned int unit, GLenum target, unsigned int texture) override;
+    void texParameter(GLenum target, GLenum name, int value) override;
+    void texImage2D(GLenum target,
+                    int level,
+                    int internalFormat,
+                    int width,
+                    int height,
+                    GLenum format,
+                    GLenum type,
+                    const void* pixels) override;
+    void texImage3D(GLenum target,
+                    int level,
+                    int internalFormat,
+                    int width,
+                    int height,
+                    int depth,
+                    GLenum format,
+                    GLenum type,
+                    const void* pixels) override;
+    void texSubImage2D(unsigned int unit,
+                       unsigned int texture,
+                       int level,
+                       int x,
+                       int y,
+                       int width,
+                       int height,
+                       GLenum format,
+                       GLenum type,
+                       const void* pixels) override;
+    void texSubImage3D(unsigned int unit,
+                       unsigned int texture,
+                       int level,
+                       int layer,
+                       int width,
+                       int height,
+                       GLenum format,
+                       GLenum type,
+                       const void* pixels) override;
+    void generateMipmap(GLenum target) override;
+    void texBuffer(unsigned int unit,
+                   unsigned int texture,
+                   GLenum internalFormat,
+                   unsigned int buffer) override;
+
+    unsigned int createFramebuffer() override;
+    void deleteFramebuffer(unsigned int framebuffer) override;
+    void bindFramebuffer(unsigned int framebuffer) override;
+    void
+    framebufferTextureLayer(GLenum attachment, unsigned int texture, int level, int layer) override;
+    void framebufferTexture(GLenum attachment, unsigned int texture, int level) override;
+    void drawBuffer(GLenum buffer) override;
+    void drawBuffers(GLsizei count, const GLenum* buffers) override;
+    void readBuffer(GLenum buffer) override;
+    GLenum checkFramebufferStatus() override;
+    void blitFramebuffer(unsigned int source,
+                         unsigned int destination,
+                         const int sourceRect[4],
+                         const int destinationRect[4],
+                         GLbitfield mask,
+                         GLenum filter) override;
+
+    unsigned int compileShader(GLenum type, const char* source, std::string& log) override;
+    unsigned int linkProgram(unsigned int vertex, unsigned int fragment, std::string& log) override;
+    unsigned int linkFeedbackProgram(unsigned int vertex,
+                                     unsigned int geometry,
+                                     const char* const* varyings,
+                                     int varyingCount,
+                                     std::string& log) override;
+    void deleteShader(unsigned int shader) override;
+    void deleteProgram(unsigned int program) override;
+    void useProgram(unsigned int program) override;
+    int getUniformLocation(unsigned int program, const char* name) override;
+    void
+    uniformBlockBinding(unsigned int program, const char* blockName, unsigned int binding) override;
+    void setUniform(int location, int value) override;
+    void setUniform(int location, float value) override;
+    void setUniform(int location, const glm::vec2& value) override;
+    void setUniform(int location, const glm::vec4& value) override;
+    void setUniform(int location, const glm::mat4& value) override;
+
+    void setEnabled(GLenum capability, bool enabled) override;
+    void depthMask(bool enabled) override;
+    void colorMask(bool enabled) override;
+    void depthFunc(GLenum func) override;
+    void blendFunc(GLenum source, GLenum destination) override;
+    void blendFuncSeparate(GLenum sourceColor,
+                           GLenum destinationColor,
+                           GLenum sourceAlpha,
+                           GLenum destinationAlpha) override;
+    void polygonOffset(float factor, float units) override;
+    void viewport(int x, int y, int width, int height) override;
+
+    void clear(const glm::vec4& color, GLbitfield mask) override;
+    void drawArrays(GLenum mode, int first, GLsizei count) override;
+    void drawArraysInstanced(GLenum mode, int first, GLsizei count, GLsizei instances) override;
+    void beginTransformFeedback(GLenum primitiveMode) override;
+    void endTransformFeedback() override;
+    void finish() override;
+
+    int getInteger(GLenum name) override;
+    void getViewport(int viewport[4]) override;
+
+  private:
+    bool capture{true};
+    bool bufferStorageSupported{true};
+    std::vector<RecordedCommand> commands;
+    uint64_t counts[static_cast<size_t>(RenderCommand::Count)] = {};
+    uint64_t vertexCount{0};
+    uint64_t uploadedBytes{0};
+    unsigned int nextObject{1}; ///< Shared by every object kind; 0 stays "none"
+    uintptr_t nextFence{1};
+    int currentViewport[4] = {};
+    std::unordered_map<std::string, int> uniformLocations;
+    std::unordered_map<GLenum, unsigned int> boundBuffers;              ///< Per target
+    std::unordered_map<unsigned int, std::vector<unsigned char>> memory; ///< Per buffer
+
+    std::vector<unsigned char>& boundMemory(GLenum target) {
+        return memory[boundBuffers[target]];
+    }
+
+    void record(RenderCommand command,
+                uint32_t a = 0,
+                uint32_t b = 0,
+                uint32_t c = 0,
+                uint32_t d = 0);
+};
+
+#endif
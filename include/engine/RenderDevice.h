@@ -0,0 +1,396 @@
+#ifndef RENDER_DEVICE_H
+#define RENDER_DEVICE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <glad/glad.h> // GL enums and typedefs only, no context needed
+#include <glm/glm.hpp>
+
+// GL 4.4 / ARB_buffer_storage, which the 4.1 loader doesn't know about
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+
+/**
+ * @class RenderDevice
+ * @brief The GL calls the engine makes, behind an interface so they can be swapped out.
+ *
+ * Shader, Texture, MeshSystem and RenderingSystem talk to RenderDevice::current() rather than to
+ * GL. GLRenderDevice forwards to the driver (state through GLState). RecordingRenderDevice
+ * counts and optionally records the commands without a context. Arguments keep GL's enums so
+ * the two paths stay one-to-one.
+ */
+class RenderDevice {
+  public:
+    virtual ~RenderDevice() = default;
+
+    /// Device used by the engine; the GL device unless setCurrent() installed another
+    static RenderDevice& current();
+
+    /// Install @p device for every following call; nullptr restores the GL device
+    static void setCurrent(RenderDevice* device);
+
+    virtual const char* name() const = 0;
+
+    // --- Buffers ---
+    virtual unsigned int createBuffer() = 0;
+    virtual void deleteBuffer(unsigned int buffer) = 0;
+    virtual void bindBuffer(GLenum target, unsigned int buffer) = 0;
+    virtual void bindBufferRange(GLenum target,
+                                 unsigned int index,
+                                 unsigned int buffer,
+                                 GLintptr offset,
+                                 GLsizeiptr size) = 0;
+    virtual void bufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) = 0;
+    virtual void
+    bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) = 0;
+    /// Immutable storage (GL 4.4); returns false if unsupported, leaving the buffer untouched
+    virtual bool
+    bufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags) = 0;
+    virtual bool supportsBufferStorage() const = 0;
+    virtual void*
+    mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) = 0;
+    /// Range is relative to the start of the mapping
+    virtual void flushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr length) = 0;
+    virtual void unmapBuffer(GLenum target) = 0;
+
+    // --- Synchronization ---
+    /// Fence after every command issued so far
+    virtual GLsync fenceSync() = 0;
+    /// Wait up to @p timeout nanoseconds; true once the fence has signaled (or waiting failed)
+    virtual bool clientWaitSync(GLsync fence, uint64_t timeout) = 0;
+    virtual void deleteSync(GLsync fence) = 0;
+
+    // --- Queries ---
+    virtual unsigned int createQuery() = 0;
+    virtual void deleteQuery(unsigned int query) = 0;
+    virtual void beginQuery(GLenum target, unsigned int query) = 0;
+    virtual void endQuery(GLenum target) = 0;
+    /// Have @p query record the GPU clock (GL_TIMESTAMP, nanoseconds) once prior work is done
+    virtual void queryCounter(unsigned int query) = 0;
+    /// Fetch a finished query's result without waiting; false while the GPU is still on it
+    virtual bool queryResult(unsigned int query, uint64_t& result) = 0;
+    /// Wait for the GPU to finish @p query and return its result
+    virtual uint64_t waitQueryResult(unsigned int query) = 0;
+
+    // --- Vertex arrays ---
+    virtual unsigned int createVertexArray() = 0;
+    virtual void deleteVertexArray(unsigned int vao) = 0;
+    virtual void bindVertexArray(unsigned int vao) = 0;
+    /// Float attribute sourced from the bound GL_ARRAY_BUFFER at byte @p offset
+    virtual void vertexAttribPointer(unsigned int index,
+                                     int size,
+                                     GLenum type,
+                                     bool normalized,
+                                     GLsizei stride,
+                                     size_t offset) = 0;
+    virtual void enableVertexAttribArray(unsigned int index) = 0;
+    virtual void vertexAttribDivisor(unsigned int index, unsigned int divisor) = 0;
+
+    // --- Textures ---
+    virtual unsigned int createTexture() = 0;
+    virtual void deleteTexture(unsigned int texture) = 0;
+    virtual void bindTexture(unsigned int unit, GLenum target, unsigned int texture) = 0;
+    virtual void texParameter(GLenum target, GLenum name, int value) = 0;
+    virtual void texImage2D(GLenum target,
+                            int level,
+                            int internalFormat,
+                            int width,
+                            int height,
+                            GLenum format,
+                            GLenum type,
+                            const void* pixels) = 0;
+    /// Array and 3D textures; @p depth is the layer count for GL_TEXTURE_2D_ARRAY
+    virtual void texImage3D(GLenum target,
+                            int level,
+                            int internalFormat,
+                            int width,
+                            int height,
+                            int depth,
+                            GLenum format,
+                            GLenum type,
+                            const void* pixels) = 0;
+    /// Upload a rectangle of one mip level of @p texture, a GL_TEXTURE_2D bound to @p unit
+    virtual void texSubImage2D(unsigned int unit,
+                               unsigned int texture,
+                               int level,
+                               int x,
+                               int y,
+                               int width,
+                               int height,
+                               GLenum format,
+                               GLenum type,
+                               const void* pixels) = 0;
+    /// Upload one mip level of one layer of @p texture, a GL_TEXTURE_2D_ARRAY bound to @p unit
+    virtual void texSubImage3D(unsigned int unit,
+                               unsigned int texture,
+                               int level,
+                               int layer,
+                               int width,
+                               int height,
+                               GLenum format,
+                               GLenum type,
+                               const void* pixels) = 0;
+    virtual void generateMipmap(GLenum target) = 0;
+    /// Bind @p texture as a buffer texture on @p unit, viewing all of @p buffer as @p format
+    virtual void texBuffer(unsigned int unit,
+                           unsigned int texture,
+                           GLenum internalFormat,
+                           unsigned int buffer) = 0;
+
+    // --- Framebuffers ---
+    virtual unsigned int createFramebuffer() = 0;
+    virtual void deleteFramebuffer(unsigned int framebuffer) = 0;
+    /// 0 means the back buffer, which is GLState::defaultFramebuffer() on the GL device
+    virtual void bindFramebuffer(unsigned int framebuffer) = 0;
+    /// Attach one layer of an array texture to the bound framebuffer
+    virtual void
+    framebufferTextureLayer(GLenum attachment, unsigned int texture, int level, int layer) = 0;
+    /// Attach a 2D texture to the bound framebuffer
+    virtual void framebufferTexture(GLenum attachment, unsigned int texture, int level) = 0;
+    /// Color buffers of the bound framebuffer; GL_NONE for depth-only targets
+    virtual void drawBuffer(GLenum buffer) = 0;
+    /// Route fragment outputs 0..count-1 to @p buffers
+    virtual void drawBuffers(GLsizei count, const GLenum* buffers) = 0;
+    virtual void readBuffer(GLenum buffer) = 0;
+    virtual GLenum checkFramebufferStatus() = 0;
+    /**
+     * @brief Copy a rectangle between framebuffers, 0 meaning the back buffer on either side.
+     *
+     * Rectangles are x, y, width, height like viewport(); sizes may differ when @p filter is
+     * GL_LINEAR and only color is copied. Leaves the two framebuffers bound for read and draw.
+     */
+    virtual void blitFramebuffer(unsigned int source,
+                                 unsigned int destination,
+                                 const int sourceRect[4],
+                                 const int destinationRect[4],
+                                 GLbitfield mask,
+                                 GLenum filter) = 0;
+
+    // --- Programs ---
+    /// Compile one stage; returns 0 and fills @p log on failure
+    virtual unsigned int compileShader(GLenum type, const char* source, std::string& log) = 0;
+    /// Link two stages; returns 0 and fills @p log on failure
+    virtual unsigned int
+    linkProgram(unsigned int vertex, unsigned int fragment, std::string& log) = 0;
+    /// Link a vertex and geometry stage without rasterization, capturing @p varyings
+    /// interleaved into GL_TRANSFORM_FEEDBACK_BUFFER binding 0; 0 and @p log on failure
+    virtual unsigned int linkFeedbackProgram(unsigned int vertex,
+                                             unsigned int geometry,
+                                             const char* const* varyings,
+                                             int varyingCount,
+                                             std::string& log) = 0;
+    virtual void deleteShader(unsigned int shader) = 0;
+    virtual void deleteProgram(unsigned int program) = 0;
+    virtual void useProgram(unsigned int program) = 0;
+    virtual int getUniformLocation(unsigned int program, const char* name) = 0;
+    /// Attach a uniform block to a binding point; does nothing if the program lacks the block
+    virtual void
+    uniformBlockBinding(unsigned int program, const char* blockName, unsigned int binding) = 0;
+    // Uniforms of the program in use
+    virtual void setUniform(int location, int value) = 0;
+    virtual void setUniform(int location, float value) = 0;
+    virtual void setUniform(int location, const glm::vec2& value) = 0;
+    virtual void setUniform(int location, const glm::vec4& value) = 0;
+    virtual void setUniform(int location, const glm::mat4& value) = 0;
+
+    // --- Fixed-function state ---
+    virtual void setEnabled(GLenum capability, bool enabled) = 0;
+    virtual void depthMask(bool enabled) = 0;
+    /// Write all color channels, or none (depth-only passes)
+    virtual void colorMask(bool enabled) = 0;
+    virtual void depthFunc(GLenum func) = 0;
+    virtual void blendFunc(GLenum source, GLenum destination) = 0;
+    /// Separate factors for color and alpha
+    virtual void blendFuncSeparate(GLenum sourceColor,
+                                   GLenum destinationColor,
+                                   GLenum sourceAlpha,
+                                   GLenum destinationAlpha) = 0;
+    /// Depth offset applied while GL_POLYGON_OFFSET_FILL is enabled
+    virtual void polygonOffset(float factor, float units) = 0;
+    virtual void viewport(int x, int y, int width, int height) = 0;
+
+    // --- Drawing ---
+    virtual void clear(const glm::vec4& color, GLbitfield mask) = 0;
+    virtual void drawArrays(GLenum mode, int first, GLsizei count) = 0;
+    virtual void drawArraysInstanced(GLenum mode, int first, GLsizei count, GLsizei instances) = 0;
+    /// Capture the outputs of the following draws; @p primitiveMode is what the last stage emits
+    virtual void beginTransformFeedback(GLenum primitiveMode) = 0;
+    virtual void endTransformFeedback() = 0;
+    /// Block until every submitted command has executed
+    virtual void finish() = 0;
+
+    virtual int getInteger(GLenum name) = 0;
+    /// Current viewport as x, y, width, height
+    virtual void getViewport(int viewport[4]) = 0;
+};
+
+/**
+ * @class GLRenderDevice
+ * @brief RenderDevice backed by the current GL context.
+ */
+class GLRenderDevice : public RenderDevice {
+  public:
+    /**
+     * @brief Load entry points newer than the generated loader (glBufferStorage).
+     * @param loader The proc address function the context was loaded with.
+     *
+     * Call once after gladLoadGLLoader; without it the device reports no buffer storage.
+     */
+    static void loadExtensions(GLADloadproc loader);
+
+    const char* name() const override {
+        return "OpenGL";
+    }
+
+    unsigned int createBuffer() override;
+    void deleteBuffer(unsigned int buffer) override;
+    void bindBuffer(GLenum target, unsigned int buffer) override;
+    void bindBufferRange(GLenum target,
+                         unsigned int index,
+                         unsigned int buffer,
+                         GLintptr offset,
+                         GLsizeiptr size) override;
+    void bufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) override;
+    void bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) override;
+    bool bufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags) override;
+    bool supportsBufferStorage() const override;
+    void*
+    mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) override;
+    void flushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr length) override;
+    void unmapBuffer(GLenum target) override;
+
+    GLsync fenceSync() override;
+    bool clientWaitSync(GLsync fence, uint64_t timeout) override;
+    void deleteSync(GLsync fence) override;
+
+    unsigned int createQuery() override;
+    void deleteQuery(unsigned int query) override;
+    void beginQuery(GLenum target, unsigned int query) override;
+    void endQuery(GLenum target) override;
+    void queryCounter(unsigned int query) override;
+    bool queryResult(unsigned int query, uint64_t& result) override;
+    uint64_t waitQueryResult(unsigned int query) override;
+
+    unsigned int createVertexArray() override;
+    void deleteVertexArray(unsigned int vao) override;
+    void bindVertexArray(unsigned int vao) override;
+    void vertexAttribPointer(unsigned int index,
+                             int size,
+                             GLenum type,
+                             bool normalized,
+                             GLsizei stride,
+                             size_t offset) override;
+    void enableVertexAttribArray(unsigned int index) override;
+    void vertexAttribDivisor(unsigned int index, unsigned int divisor) override;
+
+    unsigned int createTexture() override;
+    void deleteTexture(unsigned int texture) override;
+    void bindTexture(unsigned int unit, GLenum target, unsigned int texture) override;
+    void texParameter(GLenum target, GLenum name, int value) override;
+    void texImage2D(GLenum target,
+                    int level,
+                    int internalFormat,
+                    int width,
+                    int height,
+                    GLenum format,
+                    GLenum type,
+                    const void* pixels) override;
+    void texImage3D(GLenum target,
+                    int level,
+                    int internalFormat,
+                    int width,
+                    int height,
+                    int depth,
+                    GLenum format,
+                    GLenum type,
+                    const void* pixels) override;
+    void texSubImage2D(unsigned int unit,
+                       unsigned int texture,
+                       int level,
+                       int x,
+                       int y,
+                       int width,
+                       int height,
+                       GLenum format,
+                       GLenum type,
+                       const void* pixels) override;
+    void texSubImage3D(unsigned int unit,
+                       unsigned int texture,
+                       int level,
+                       int layer,
+                       int width,
+                       int height,
+                       GLenum format,
+                       GLenum type,
+                       const void* pixels) override;
+    void generateMipmap(GLenum target) override;
+    void texBuffer(unsigned int unit,
+                   unsigned int texture,
+                   GLenum internalFormat,
+                   unsigned int buffer) override;
+
+    unsigned int createFramebuffer() override;
+    void deleteFramebuffer(unsigned int framebuffer) override;
+    void bindFramebuffer(unsigned int framebuffer) override;
+    void
+    framebufferTextureLayer(GLenum attachment, unsigned int texture, int level, int layer) override;
+    void framebufferTexture(GLenum attachment, unsigned int texture, int level) override;
+    void drawBuffer(GLenum buffer) override;
+    void drawBuffers(GLsizei count, const GLenum* buffers) override;
+    void readBuffer(GLenum buffer) override;
+    GLenum checkFramebufferStatus() override;
+    void blitFramebuffer(unsigned int source,
+                         unsigned int destination,
+                         const int sourceRect[4],
+                         const int destinationRect[4],
+                         GLbitfield mask,
+                         GLenum filter) override;
+
+    unsigned int compileShader(GLenum type, const char* source, std::string& log) override;
+    unsigned int linkProgram(unsigned int vertex, unsigned int fragment, std::string& log) override;
+    unsigned int linkFeedbackProgram(unsigned int vertex,
+                                     unsigned int geometry,
+                                     const char* const* varyings,
+                                     int varyingCount,
+                                     std::string& log) override;
+    void deleteShader(unsigned int shader) override;
+    void deleteProgram(unsigned int program) override;
+    void useProgram(unsigned int program) override;
+    int getUniformLocation(unsigned int program, const char* name) override;
+    void
+    uniformBlockBinding(unsigned int program, const char* blockName, unsigned int binding) override;
+    void setUniform(int location, int value) override;
+    void setUniform(int location, float value) override;
+    void setUniform(int location, const glm::vec2& value) override;
+    void setUniform(int location, const glm::vec4& value) override;
+    void setUniform(int location, const glm::mat4& value) override;
+
+    void setEnabled(GLenum capability, bool enabled) override;
+    void depthMask(bool enabled) override;
+    void colorMask(bool enabled) override;
+    void depthFunc(GLenum func) override;
+    void blendFunc(GLenum source, GLenum destination) override;
+    void blendFuncSeparate(GLenum sourceColor,
+                           GLenum destinationColor,
+                           GLenum sourceAlpha,
+                           GLenum destinationAlpha) override;
+    void polygonOffset(float factor, float units) override;
+    void viewport(int x, int y, int width, int height) override;
+
+    void clear(const glm::vec4& color, GLbitfield mask) override;
+    void drawArrays(GLenum mode, int first, GLsizei count) override;
+    void drawArraysInstanced(GLenum mode, int first, GLsizei count, GLsizei instances) override;
+    void beginTransformFeedback(GLenum primitiveMode) override;
+    void endTransformFeedback() override;
+    void finish() override;
+
+    int getInteger(GLenum name) override;
+    void getViewport(int viewport[4]) override;
+};
+
+#endif
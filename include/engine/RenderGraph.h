@@ -0,0 +1,209 @@
+#ifndef RENDER_GRAPH_H
+#define RENDER_GRAPH_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <glad/glad.h>
+#include <entt/graph/flow.hpp>
+#include <engine/Profiler.h>
+
+/**
+ * @struct RenderTargetDesc
+ * @brief Size and format of a transient texture; equal descriptions share pooled textures.
+ */
+struct RenderTargetDesc {
+    int width{0};
+    int height{0};
+    int internalFormat{GL_RGBA8};
+    GLenum format{GL_RGBA};
+    GLenum type{GL_UNSIGNED_BYTE};
+    GLenum filter{GL_NEAREST}; ///< Min and mag filter; edges always clamp
+
+    bool operator==(const RenderTargetDesc& other) const {
+        return width == other.width && height == other.height &&
+               internalFormat == other.internalFormat && format == other.format &&
+               type == other.type && filter == other.filter;
+    }
+};
+
+/**
+ * @class RenderGraph
+ * @brief Frame passes declared with the textures they read and write, scheduled and culled
+ * before any of them runs.
+ *
+ * Rebuilt every frame: beginFrame(), then resources and passes, then execute(). Passes run in
+ * a topological order of their dependencies (an entt::flow over the resources, declaration
+ * order breaking ties), and a pass is culled when nothing that survives reads what it writes.
+ * Passes writing the back buffer or an imported resource, or flagged with sideEffect(), are
+ * the roots that keep the rest alive.
+ *
+ * Transient textures only get a GL texture for the span of passes that use them. They come
+ * from a pool that outlives the frame, so two transients with the same description and
+ * disjoint lifetimes share one texture, and a steady frame allocates nothing. Textures the
+ * pool hasn't handed out for EVICT_FRAMES frames are deleted. Framebuffers are cached per set
+ * of attachments and bound, with the viewport, before a pass runs.
+ *
+ * Must be used on the thread that owns the GL context.
+ */
+class RenderGraph {
+  public:
+    using Resource = uint32_t;
+    static constexpr Resource BACK_BUFFER = 0; ///< Default framebuffer, color and depth
+    static constexpr int MAX_COLOR_ATTACHMENTS = 4;
+    static constexpr uint64_t EVICT_FRAMES = 8;
+
+    /**
+     * @class PassBuilder
+     * @brief Declares what a pass reads and writes; calls chain.
+     *
+     * A pass that writes a resource is assumed to load what is already there (blending over it
+     * or leaving parts untouched), so it depends on the previous writer too.
+     */
+    class PassBuilder {
+      public:
+        /// Sampled as a texture
+        PassBuilder& read(Resource resource);
+        /// Color attachment, numbered in call order; BACK_BUFFER can't be mixed with textures
+        PassBuilder& write(Resource resource);
+        /// Depth attachment the pass writes
+        PassBuilder& writeDepth(Resource resource);
+        /// Depth attachment the pass only tests against
+        PassBuilder& readDepth(Resource resource);
+        /// Written through framebuffers of the pass's own, nothing is attached for it
+        PassBuilder& modify(Resource resource);
+        /// Draw into the lower-left @p width x @p height of the attachments, not all of them
+        PassBuilder& viewport(int width, int height);
+        /// Never culled, e.g. it updates state outside the graph
+        PassBuilder& sideEffect();
+
+      private:
+        friend class RenderGraph;
+        PassBuilder(RenderGraph& owner, uint32_t index) : graph(owner), pass(index) {}
+
+        RenderGraph& graph;
+        uint32_t pass;
+    };
+
+    RenderGraph() = default;
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    /// Drop last frame's passes and resources; BACK_BUFFER takes @p backBufferViewport
+    void beginFrame(const int backBufferViewport[4]);
+
+    /// A texture owned elsewhere; writing it keeps the writer alive
+    Resource importTexture(const char* name, unsigned int texture, int width, int height);
+
+    /// A texture that only lives for this frame's passes, allocated from the pool
+    Resource createTexture(const char* name, const RenderTargetDesc& desc);
+
+    /// Add a pass; @p execute runs with its attachments bound, unless the pass is culled
+    PassBuilder addPass(const char* name, std::function<void(RenderGraph&)> execute);
+
+    /// Cull, schedule, allocate and run the passes, then hand the transients back to the pool
+    void execute();
+
+    /// Time every pass that runs as a section named after it; null stops timing
+    void setProfiler(GpuProfiler* gpuProfiler) {
+        profiler = gpuProfiler;
+    }
+
+    /// GL texture behind @p resource; for transients only valid inside a pass that uses it
+    unsigned int getTexture(Resource resource) const;
+
+    /// Framebuffer with @p resource as its only color attachment, e.g. to blit from
+    unsigned int getReadFramebuffer(Resource resource);
+
+    /// Passes run by the last execute()
+    uint32_t getExecutedCount() const {
+        return executedCount;
+    }
+
+    /// Passes dropped by the last execute() because their results went unused
+    uint32_t getCulledCount() const {
+        return culledCount;
+    }
+
+    /// Approximate memory held by pooled textures
+    uint64_t getPoolBytes() const;
+
+    /// Delete pooled textures and cached framebuffers; call on the context thread
+    void release();
+
+  private:
+    enum class Access : uint8_t { Read, Write, WriteDepth, ReadDepth, Modify };
+
+    struct PassAccess {
+        Resource resource;
+        Access access;
+    };
+
+    struct Pass {
+        const char* name{nullptr};
+        std::function<void(RenderGraph&)> execute;
+        std::vector<PassAccess> accesses;
+        std::vector<uint32_t> producers; ///< Earlier passes that wrote what this one uses
+        int viewportWidth{0};            ///< 0 or less = whole attachment
+        int viewportHeight{0};
+        bool sideEffect{false};
+        bool live{false};
+    };
+
+    struct ResourceEntry {
+        const char* name{nullptr};
+        RenderTargetDesc desc;
+        unsigned int texture{0};
+        bool imported{false};
+        int pooled{-1};     ///< Pool slot while the texture is held
+        int firstUse{-1};   ///< Positions in the schedule
+        int lastUse{-1};
+        int lastWriter{-1}; ///< Latest pass declared writing it
+    };
+
+    struct PooledTexture {
+        RenderTargetDesc desc;
+        unsigned int texture{0};
+        uint64_t lastUsed{0}; ///< Frame it was last handed out
+        bool inUse{false};
+    };
+
+    struct CachedFramebuffer {
+        unsigned int colors[MAX_COLOR_ATTACHMENTS] = {};
+        int colorCount{0};
+        unsigned int depth{0};
+        unsigned int framebuffer{0};
+        bool complete{false};
+    };
+
+    /// Only the first passCount are this frame's; the rest are kept for their capacity
+    std::vector<Pass> passes;
+    uint32_t passCount{0};
+    std::vector<ResourceEntry> resources;
+    entt::flow flow;                ///< Dependencies of the live passes
+    std::vector<uint32_t> schedule; ///< Live passes in execution order
+    std::vector<PooledTexture> pool;
+    std::vector<CachedFramebuffer> framebuffers;
+    int backBufferViewport[4] = {};
+    uint64_t frame{0};
+    uint32_t executedCount{0};
+    uint32_t culledCount{0};
+    GpuProfiler* profiler{nullptr};
+
+    static bool isWrite(Access access) {
+        return access != Access::Read && access != Access::ReadDepth;
+    }
+
+    void addAccess(uint32_t pass, Resource resource, Access access);
+    void cull();
+    void buildSchedule();
+    void acquire(ResourceEntry& resource);
+    void releaseTransient(ResourceEntry& resource);
+    void evict();
+    bool bindAttachments(const Pass& pass);
+    const CachedFramebuffer* findFramebuffer(const unsigned int* colors,
+                                             int colorCount,
+                                             unsigned int depth);
+};
+
+#endif
@@ -0,0 +1,194 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+class Shader;
+
+/**
+ * @struct DrawItem
+ * @brief Everything needed to issue one draw, captured when the queue is built.
+ */
+struct DrawItem {
+    Shader* shader{nullptr};      ///< Program used for this draw
+    unsigned int VAO{0};          ///< Vertex array object
+    unsigned int texture1{0};     ///< Texture bound to unit 0 (0 = none)
+    unsigned int textureArray{0}; ///< Array sampled instead of texture1 (0 = none)
+    float layer{0.0f};            ///< Layer of textureArray; per instance, so not batch state
+    unsigned int vertexCount{0};  ///< Vertex count for glDrawArrays
+    float opacity{1.0f};          ///< Multiplies the texture's alpha
+    glm::mat4 model{1.0f};        ///< World matrix
+    /// Scale (xy) and offset (zw) of texture1's coordinates; per instance, so not batch state
+    glm::vec4 uvTransform{1.0f, 1.0f, 0.0f, 0.0f};
+    /// Mesh-space box tested by GPU culling; min above max (the default) means always visible
+    glm::vec3 boundsMin{1.0f};
+    glm::vec3 boundsMax{-1.0f};
+};
+
+/**
+ * @enum RenderBucket
+ * @brief Pass a draw belongs to; stored in the top bits of its sort key, so buckets stay in
+ * this order after sorting.
+ */
+enum class RenderBucket : uint8_t {
+    Opaque,           ///< Depth-tested and written, no blending
+    Transparent,      ///< Weighted blended order-independent transparency
+    SortedTransparent ///< Exact back-to-front blending, for the few draws that need it
+};
+
+/**
+ * @class RenderQueue
+ * @brief Collects draws tagged with a 64-bit sort key and orders them with a radix sort.
+ *
+ * Opaque keys sort by shader, then texture, then VAO, then front-to-back depth, so state changes
+ * happen as rarely as possible. Weighted transparency doesn't depend on draw order, so it sorts
+ * the same way. Sorted transparency comes last and sorts back-to-front first, state second.
+ *
+ * Opaque/Transparent: [63:62] bucket | [61:51] shader | [50:39] texture | [38:27] VAO |
+ *                     [26:3] depth
+ * SortedTransparent:  [63:62] bucket | [61:38] ~depth | [37:27] shader  | [26:15] texture |
+ *                     [14:3] VAO
+ *
+ * Object ids are truncated to fit their field, so two ids may share a key. That only costs an
+ * extra state change; the submitter always compares the real ids in the DrawItem.
+ */
+class RenderQueue {
+  public:
+    static constexpr int DEPTH_BITS = 24;
+    static constexpr int BUCKET_SHIFT = 62;
+
+    /**
+     * @brief Build a sort key.
+     * @param bucket Pass the draw belongs to.
+     * @param shader Shader program id.
+     * @param texture Texture id.
+     * @param VAO Vertex array id.
+     * @param depth Normalized view depth in [0, 1], 0 being the near plane.
+     */
+    static uint64_t makeKey(RenderBucket bucket,
+                            unsigned int shader,
+                            unsigned int texture,
+                            unsigned int VAO,
+                            float depth) {
+        constexpr uint64_t depthMax = (1ull << DEPTH_BITS) - 1;
+        uint64_t quantDepth = static_cast<uint64_t>(std::clamp(depth, 0.0f, 1.0f) * depthMax);
+        uint64_t program = shader & 0x7FFu;
+        uint64_t tex = texture & 0xFFFu;
+        uint64_t vao = VAO & 0xFFFu;
+        uint64_t prefix = static_cast<uint64_t>(bucket) << BUCKET_SHIFT;
+
+        if (bucket == RenderBucket::SortedTransparent) {
+            return prefix | ((depthMax - quantDepth) << 38) | (program << 27) | (tex << 15) |
+                   (vao << 3);
+        }
+        return prefix | (program << 51) | (tex << 39) | (vao << 27) | (quantDepth << 3);
+    }
+
+    static RenderBucket bucketOf(uint64_t key) {
+        return static_cast<RenderBucket>(key >> BUCKET_SHIFT);
+    }
+
+    void clear() {
+        keys.clear();
+        items.clear();
+    }
+
+    void reserve(size_t count) {
+        keys.reserve(count);
+        items.reserve(count);
+    }
+
+    void push(uint64_t key, const DrawItem& item) {
+        keys.push_back(key);
+        items.push_back(item);
+    }
+
+    /// Append pre-recorded packets, e.g. from a CommandList
+    void append(const std::vector<uint64_t>& packetKeys, const std::vector<DrawItem>& packetItems) {
+        keys.insert(keys.end(), packetKeys.begin(), packetKeys.end());
+        items.insert(items.end(), packetItems.begin(), packetItems.end());
+    }
+
+    size_t size() const {
+        return items.size();
+    }
+
+    bool empty() const {
+        return items.empty();
+    }
+
+    /// Item at position @p i in sorted order; only valid after sort()
+    const DrawItem& operator[](size_t i) const {
+        return items[order[i]];
+    }
+
+    /// Sort key at position @p i in sorted order; only valid after sort()
+    uint64_t keyAt(size_t i) const {
+        return keys[order[i]];
+    }
+
+    /// First sorted position at or after @p bucket, size() if none; only valid after sort()
+    size_t bucketStart(RenderBucket bucket) const {
+        uint64_t first = static_cast<uint64_t>(bucket) << BUCKET_SHIFT;
+        return static_cast<size_t>(
+            std::lower_bound(sortedKeys.begin(), sortedKeys.end(), first) - sortedKeys.begin());
+    }
+
+    /**
+     * @brief LSD radix sort of the keys, 8 bits per pass.
+     *
+     * Passes whose byte is identical for every key are skipped, which is common for the high
+     * bytes when a scene uses few shaders.
+     */
+    void sort() {
+        size_t count = keys.size();
+        order.resize(count);
+        sortedKeys.resize(count);
+        scratchOrder.resize(count);
+        scratchKeys.resize(count);
+
+        for (size_t i = 0; i < count; ++i) {
+            order[i] = static_cast<uint32_t>(i);
+            sortedKeys[i] = keys[i];
+        }
+
+        for (int pass = 0; pass < 8; ++pass) {
+            int shift = pass * 8;
+            size_t histogram[256] = {};
+            for (size_t i = 0; i < count; ++i) {
+                ++histogram[(sortedKeys[i] >> shift) & 0xFF];
+            }
+
+            if (count == 0 || histogram[(sortedKeys[0] >> shift) & 0xFF] == count) {
+                continue; // Every key has the same byte here, order is unchanged
+            }
+
+            size_t offset = 0;
+            for (size_t& bucket : histogram) {
+                size_t n = bucket;
+                bucket = offset;
+                offset += n;
+            }
+
+            for (size_t i = 0; i < count; ++i) {
+                size_t dst = histogram[(sortedKeys[i] >> shift) & 0xFF]++;
+                scratchKeys[dst] = sortedKeys[i];
+                scratchOrder[dst] = order[i];
+            }
+            sortedKeys.swap(scratchKeys);
+            order.swap(scratchOrder);
+        }
+    }
+
+  private:
+    std::vector<uint64_t> keys;
+    std::vector<DrawItem> items;
+
+    // Sort output and ping-pong buffers, kept to avoid per-frame allocations
+    std::vector<uint32_t> order;
+    std::vector<uint64_t> sortedKeys;
+    std::vector<uint32_t> scratchOrder;
+    std::vector<uint64_t> scratchKeys;
+};
@@ -0,0 +1,121 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+ * @class RenderThread
+ * @brief Thread that owns the GL context and consumes double-buffered frame snapshots.
+ *
+ * The simulation thread fills the snapshot returned by acquire() and hands it over with
+ * publish(), then carries on with the next frame while the render thread submits this one.
+ * Snapshots must be self-contained: the render thread never touches the registry.
+ *
+ * At most one frame is in flight and one is waiting, so acquire() blocks when the simulation
+ * gets two frames ahead and publish() blocks until the previous snapshot was picked up. No frame
+ * is ever dropped.
+ */
+template <typename Snapshot> class RenderThread {
+  public:
+    using Hook = std::function<void()>;
+    using FrameFn = std::function<void(const Snapshot&)>;
+
+    RenderThread() = default;
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    ~RenderThread() {
+        stop();
+    }
+
+    /**
+     * @brief Start the thread. The caller must have released the GL context beforehand.
+     * @param onStart Runs first on the render thread, typically makes the context current.
+     * @param onFrame Submits one snapshot and presents it.
+     * @param onStop Runs last on the render thread, typically releases the context.
+     */
+    void start(Hook onStart, FrameFn onFrame, Hook onStop) {
+        if (thread.joinable()) {
+            return;
+        }
+        stopping = false;
+        thread = std::thread([this, onStart, onFrame, onStop] {
+            if (onStart) {
+                onStart();
+            }
+            loop(onFrame);
+            if (onStop) {
+                onStop();
+            }
+        });
+    }
+
+    bool isRunning() const {
+        return thread.joinable();
+    }
+
+    /// Snapshot to fill for the next frame; waits while the render thread still needs it
+    Snapshot& acquire() {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this] { return !busy[writeIndex]; });
+        return snapshots[writeIndex];
+    }
+
+    /// Hand the acquired snapshot to the render thread
+    void publish() {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this] { return readyIndex < 0; });
+        readyIndex = writeIndex;
+        busy[writeIndex] = true;
+        writeIndex ^= 1;
+        changed.notify_all();
+    }
+
+    /// Finish every published frame, run onStop on the render thread and join it
+    void stop() {
+        if (!thread.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        changed.notify_all();
+        thread.join();
+    }
+
+  private:
+    Snapshot snapshots[2];
+    bool busy[2] = {false, false}; ///< Published and not yet fully rendered
+    int writeIndex{0};
+    int readyIndex{-1}; ///< Published snapshot waiting for the render thread, -1 if none
+    bool stopping{false};
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::thread thread;
+
+    void loop(const FrameFn& onFrame) {
+        for (;;) {
+            int index;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [this] { return stopping || readyIndex >= 0; });
+                if (readyIndex < 0) {
+                    return; // Stopping and nothing left to draw
+                }
+                index = readyIndex;
+                readyIndex = -1;
+                changed.notify_all();
+            }
+
+            onFrame(snapshots[index]);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                busy[index] = false;
+            }
+            changed.notify_all();
+        }
+    }
+};
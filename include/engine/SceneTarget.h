@@ -0,0 +1,83 @@
+#ifndef SCENE_TARGET_H
+#define SCENE_TARGET_H
+
+#include <glad/glad.h>
+#include <engine/RenderGraph.h>
+
+class Shader;
+
+/**
+ * @class SceneTarget
+ * @brief Offscreen color and depth the scene is drawn into before it reaches the back buffer.
+ *
+ * Needed whenever the back buffer won't do: its depth can't be shared with the weighted
+ * transparency targets, and it can't be drawn at a lower resolution. Both are RenderGraph
+ * transients sized to the back buffer's viewport; a render scale below 1 draws into the
+ * lower-left part of them, so the scale can move every frame without a new pool texture.
+ */
+class SceneTarget {
+  public:
+    static constexpr unsigned int COLOR_UNIT = 7;
+    static constexpr const char* COLOR_SAMPLER = "sceneColor";
+
+    SceneTarget() = default;
+    SceneTarget(const SceneTarget&) = delete;
+    SceneTarget& operator=(const SceneTarget&) = delete;
+
+    /**
+     * @brief Create this frame's color and depth in @p graph.
+     * @param backBufferViewport Viewport the scene ends up in.
+     * @param scale Fraction of it to draw; passes drawing the scene use getRenderWidth() and
+     * getRenderHeight() as their viewport.
+     */
+    void declare(RenderGraph& graph, const int backBufferViewport[4], float scale);
+
+    /**
+     * @brief Add the pass bringing the drawn region to the back buffer.
+     * @param upscale Fullscreen program resampling sceneColor when the render size differs
+     * from the back buffer's; a bilinear blit is used without one.
+     */
+    void addPresentPass(RenderGraph& graph, const Shader* upscale);
+
+    RenderGraph::Resource getColor() const {
+        return color;
+    }
+
+    RenderGraph::Resource getDepth() const {
+        return depth;
+    }
+
+    /// Size of the textures; the region drawn this frame may be smaller
+    int getWidth() const {
+        return width;
+    }
+
+    int getHeight() const {
+        return height;
+    }
+
+    int getRenderWidth() const {
+        return renderWidth;
+    }
+
+    int getRenderHeight() const {
+        return renderHeight;
+    }
+
+    /// Delete the vertex array; call on the context thread
+    void release();
+
+  private:
+    RenderGraph::Resource color{RenderGraph::BACK_BUFFER};
+    RenderGraph::Resource depth{RenderGraph::BACK_BUFFER};
+    int width{0};
+    int height{0};
+    int renderWidth{0};       ///< Region drawn this frame
+    int renderHeight{0};
+    int viewport[4] = {};     ///< Back buffer viewport the region is brought to
+    unsigned int emptyVAO{0}; ///< Core profile needs a VAO even for attribute-less draws
+
+    void present(RenderGraph& graph, const Shader* upscale);
+};
+
+#endif
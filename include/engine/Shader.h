@@ -2,10 +2,13 @@
 #define SHADER_H
 
 #include <glad/glad.h> // Required for OpenGL function pointers
+#include <engine/GLState.h>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -19,6 +22,15 @@ struct ShaderType {
     GLenum type;     ///< Type of shader (e.g., GL_VERTEX_SHADER, GL_FRAGMENT_SHADER)
 };
 
+/**
+ * @struct ShaderSource
+ * @brief Vertex and fragment source code of one program.
+ */
+struct ShaderSource {
+    std::string vertex;
+    std::string fragment;
+};
+
 /**
  * @class Shader
  * @brief Utility class for compiling and managing OpenGL shader programs.
@@ -35,6 +47,12 @@ class Shader {
      */
     Shader(const char* vertexPath, const char* fragmentPath);
 
+    /**
+     * @brief Construct a Shader program from source code already in memory.
+     * @param source Vertex and fragment source, e.g. with defines injected by ShaderVariants.
+     */
+    explicit Shader(const ShaderSource& source);
+
     /**
      * @brief Destructor. Deletes the shader program.
      */
@@ -66,6 +84,20 @@ class Shader {
      */
     void setFloat(const std::string& name, float value) const;
 
+    /**
+     * @brief Set a 2-component vector uniform.
+     * @param name Uniform name in the shader.
+     * @param value Vector to set.
+     */
+    void setVec2(const std::string& name, const glm::vec2& value) const;
+
+    /**
+     * @brief Set a 4-component vector uniform.
+     * @param name Uniform name in the shader.
+     * @param value Vector to set.
+     */
+    void setVec4(const std::string& name, const glm::vec4& value) const;
+
     /**
      * @brief Set a 4x4 matrix uniform.
      * @param name Uniform name in the shader.
@@ -73,16 +105,27 @@ class Shader {
      */
     void setMat4(const std::string& name, const glm::mat4& mat) const;
 
+    /**
+     * @brief Attach a uniform block to a buffer binding point. Does nothing if the program
+     * doesn't declare the block.
+     * @param blockName Uniform block name in the shader.
+     * @param binding Binding point index.
+     */
+    void bindUniformBlock(const char* blockName, unsigned int binding) const;
+
     /**
      * @brief Get the OpenGL shader program ID.
      * @param shaderProgramID Reference to store the shader program ID.
      */
     unsigned int getShaderProgramID() const;
 
-  private:
-    unsigned int SHADERPROGRAMID; ///< OpenGL shader program ID
-
-    static const int INFOLOG_SIZE = 512; ///< Max size of shader compiler log
+    /**
+     * @brief Read the source code of a vertex and fragment shader pair.
+     * @param vertexPath Path to the vertex shader source file.
+     * @param fragmentPath Path to the fragment shader source file.
+     * @return Both sources, empty where a file couldn't be read.
+     */
+    static ShaderSource readSource(const char* vertexPath, const char* fragmentPath);
 
     /**
      * @brief Read shader source code from a file.
@@ -91,6 +134,18 @@ class Shader {
      */
     static std::stringstream readShaderFile(const char* shaderPath);
 
+  private:
+    unsigned int SHADERPROGRAMID{0}; ///< OpenGL shader program ID
+
+    mutable std::unordered_map<std::string, int> uniformLocations; ///< Location lookup cache
+
+    /**
+     * @brief Look up a uniform location, querying GL only the first time a name is seen.
+     * @param name Uniform name in the shader.
+     * @return Uniform location, -1 if the uniform doesn't exist or was optimized out.
+     */
+    int getUniformLocation(const std::string& name) const;
+
     /**
      * @brief Compile a shader from source.
      * @param shaderCode Shader source code.
@@ -109,7 +164,7 @@ class Shader {
 };
 
 // Loader ( Needed for all the resources )
-static std::unique_ptr<Shader> shaderLoader(const std::string& pathPair) {
+inline std::unique_ptr<Shader> shaderLoader(const std::string& pathPair) {
     auto sep = pathPair.find(';');
     auto vert = pathPair.substr(0, sep);
     auto frag = pathPair.substr(sep + 1);
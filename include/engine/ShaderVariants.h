@@ -0,0 +1,69 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <engine/Shader.h>
+
+/**
+ * @class ShaderVariants
+ * @brief Programs compiled from one vertex/fragment pair with different features enabled.
+ *
+ * Sources declare the keywords they understand on lines of the form
+ *
+ *     #pragma features TEXTURE_ARRAY ALPHA_TEST
+ *
+ * which GLSL ignores, and test them with #ifdef. Each keyword gets one bit, in declaration
+ * order, vertex shader first; a variant is asked for by the bitmask of its features and gets
+ * a "#define KEYWORD" for each right after the #version line. Programs are compiled the first
+ * time their mask is asked for and cached, so materials should pick their variants at load
+ * time, on the thread that owns the GL context, and keep the Shader pointer.
+ */
+class ShaderVariants {
+  public:
+    static constexpr size_t MAX_FEATURES = 32; ///< Bits of a feature mask
+
+    ShaderVariants(const char* vertexPath, const char* fragmentPath);
+    ShaderVariants(const ShaderVariants&) = delete;
+    ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+    /// Bit of @p keyword, 0 with an error if the sources don't declare it
+    uint32_t getFeature(const std::string& keyword) const;
+
+    /// Mask of several keywords
+    uint32_t getFeatures(std::initializer_list<const char*> keywords) const;
+
+    /// Program with exactly the features in @p features, compiled on first use; bits the
+    /// sources don't declare are ignored
+    Shader& get(uint32_t features = 0);
+
+    const std::vector<std::string>& getKeywords() const {
+        return keywords;
+    }
+
+    size_t getVariantCount() const {
+        return variants.size();
+    }
+
+  private:
+    ShaderSource source;
+    std::vector<std::string> keywords; ///< Bit i is keywords[i]
+    std::unordered_map<uint32_t, std::unique_ptr<Shader>> variants;
+
+    void parseKeywords(const std::string& code);
+    std::string inject(const std::string& code, uint32_t features) const;
+};
+
+// Loader for ResourceManager<ShaderVariants>, same "vertex;fragment" path pair as shaderLoader
+inline std::unique_ptr<ShaderVariants> shaderVariantsLoader(const std::string& pathPair) {
+    auto sep = pathPair.find(';');
+    auto vert = pathPair.substr(0, sep);
+    auto frag = pathPair.substr(sep + 1);
+    return std::make_unique<ShaderVariants>(vert.c_str(), frag.c_str());
+}
+
+#endif
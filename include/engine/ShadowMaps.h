@@ -0,0 +1,172 @@
+#ifndef SHADOW_MAPS_H
+#define SHADOW_MAPS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <engine/StreamBuffer.h>
+
+class Shader;
+
+/**
+ * @struct ShadowData
+ * @brief CPU mirror of the std140 "ShadowData" uniform block.
+ */
+struct ShadowData {
+    static constexpr int CASCADE_COUNT = 4;
+
+    glm::mat4 cascades[CASCADE_COUNT]; ///< View space to shadow map texture coordinates and depth
+    glm::vec4 splits{0.0f};            ///< View-space depth where each cascade ends
+    glm::vec4 texelSizes{0.0f};        ///< World-space size of one shadow map texel per cascade
+    glm::ivec4 params{-1, 0, 0, 0};    ///< x = shadowed light in LightFrame::lights (-1 for none),
+                                       ///< y = cascade count
+    glm::vec4 bias{0.0f};              ///< x = depth bias, y = texel size in texture coordinates,
+                                       ///< z = normal offset in texels
+};
+
+/// One shadow caster as drawn into a cascade
+struct ShadowCaster {
+    unsigned int VAO;
+    unsigned int vertexCount;
+    glm::mat4 model;
+};
+
+/**
+ * @struct ShadowFrame
+ * @brief Shadow work of one frame, produced on the CPU by ShadowSystem.
+ *
+ * Only the cascades flagged in redrawMask carry casters; the others keep the depth they were
+ * last drawn with.
+ */
+struct ShadowFrame {
+    ShadowData data;
+    glm::mat4 lightViewProj[ShadowData::CASCADE_COUNT]; ///< World to light clip space
+    std::vector<ShadowCaster> casters[ShadowData::CASCADE_COUNT]; ///< Sorted by VAO
+    uint32_t redrawMask{0};  ///< Bit c set when cascade c must be drawn again
+    const Shader* shader{nullptr}; ///< Depth-only program the casters are drawn with
+
+    bool enabled() const {
+        return data.params.x >= 0;
+    }
+};
+
+/**
+ * @class CascadedShadowMap
+ * @brief Fits directional light cascades to the camera frustum and tracks what each one holds.
+ *
+ * The shadow distance is split into CASCADE_COUNT slices, blending logarithmic and uniform
+ * spacing. Each cascade is a light-space box around the bounding sphere of its slice, so its
+ * size doesn't change as the camera turns, and its position snaps to an eighth of its width.
+ * A cascade therefore keeps the same matrix until the camera has moved a fair distance, and
+ * as long as its casters don't change either, the depth drawn earlier can be reused.
+ * No GL is involved.
+ */
+class CascadedShadowMap {
+  public:
+    static constexpr int CASCADE_COUNT = ShadowData::CASCADE_COUNT;
+    static constexpr int RESOLUTION = 1024; ///< Texels per side of each cascade
+
+    /// Distance from the camera covered by the cascades
+    void setShadowDistance(float distance) {
+        shadowDistance = std::max(distance, 1.0f);
+    }
+
+    /// 0 spaces the splits uniformly, 1 logarithmically
+    void setSplitLambda(float lambda) {
+        splitLambda = std::max(0.0f, std::min(lambda, 1.0f));
+    }
+
+    /// How far toward the light casters outside a cascade's slice are still drawn into it
+    void setCasterDistance(float distance) {
+        casterDistance = std::max(distance, 0.0f);
+    }
+
+    /**
+     * @brief Compute every cascade's matrices for this frame.
+     * @param view Camera view matrix.
+     * @param fovY Vertical field of view in radians.
+     * @param aspect Width over height of the camera projection.
+     * @param nearPlane Camera near plane distance.
+     * @param lightDirection World-space direction the light travels in.
+     * @param out Receives lightViewProj and the cascades, splits and texel sizes of data.
+     */
+    void fit(const glm::mat4& view,
+             float fovY,
+             float aspect,
+             float nearPlane,
+             const glm::vec3& lightDirection,
+             ShadowFrame& out) const;
+
+    /**
+     * @brief Compare a cascade against what it was last drawn with, and remember it.
+     * @return True if @p viewProj or @p casters differ, i.e. the cascade must be drawn again.
+     */
+    bool update(int cascade, const glm::mat4& viewProj, const std::vector<ShadowCaster>& casters);
+
+    /// Forget every cascade's content, e.g. after the shadow map was lost or disabled
+    void invalidate();
+
+  private:
+    struct CachedCascade {
+        bool valid{false};
+        glm::mat4 viewProj{1.0f};
+        std::vector<ShadowCaster> casters;
+    };
+
+    float shadowDistance{40.0f};
+    float splitLambda{0.75f};
+    float casterDistance{40.0f};
+    CachedCascade cache[CASCADE_COUNT];
+};
+
+/**
+ * @class ShadowMaps
+ * @brief GPU side of the cascades: a depth texture array with one layer per cascade.
+ *
+ * Cascades are drawn one layer at a time through a depth-only framebuffer. The main pass reads
+ * the array as a shadow sampler with hardware depth comparison, along with the ShadowData
+ * block. Programs get the sampler unit and block binding in the Shader constructor.
+ */
+class ShadowMaps {
+  public:
+    static constexpr unsigned int BINDING = 2;
+    static constexpr const char* BLOCK_NAME = "ShadowData";
+    static constexpr unsigned int UNIT = 4;
+    static constexpr const char* SAMPLER = "shadowMap";
+
+    ShadowMaps() = default;
+    ShadowMaps(const ShadowMaps&) = delete;
+    ShadowMaps& operator=(const ShadowMaps&) = delete;
+
+    /**
+     * @brief Bind the framebuffer to draw one cascade into, and clear it.
+     * @return False if the framebuffer can't be created; the cascade should be skipped.
+     *
+     * Changes the viewport; the caller restores its own afterwards.
+     */
+    bool beginCascade(int cascade);
+
+    /// Upload @p data and bind it and the depth array for the following draws
+    void bind(const ShadowData& data);
+
+    /// Depth array, 0 until the first cascade is drawn
+    unsigned int getTexture() const {
+        return texture;
+    }
+
+    /// Delete the texture, framebuffer and uniform buffer; call on the context thread
+    void release();
+
+  private:
+    unsigned int texture{0};
+    unsigned int framebuffer{0};
+    bool failed{false}; ///< Framebuffer was incomplete, don't try again every frame
+    StreamBuffer uniforms{GL_UNIFORM_BUFFER, 1024};
+    GLsizeiptr alignment{0}; ///< GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, queried on first use
+
+    bool create();
+};
+
+#endif
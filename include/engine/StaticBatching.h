@@ -0,0 +1,82 @@
+#ifndef STATIC_BATCHING_H
+#define STATIC_BATCHING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <engine/Culling.h>
+
+/**
+ * @struct StaticInstance
+ * @brief One placed mesh handed to StaticMerger.
+ */
+struct StaticInstance {
+    const float* vertices{nullptr}; ///< Interleaved position, color, uv, as createCube expects
+    uint32_t vertexCount{0};
+    uint32_t material{0};           ///< Only instances of the same material are merged
+    glm::mat4 model{1.0f};
+    glm::vec4 uvTransform{1.0f, 1.0f, 0.0f, 0.0f}; ///< Baked into the merged uvs
+};
+
+/**
+ * @struct StaticBatch
+ * @brief Merged world-space triangle list of one material in one cell of space.
+ */
+struct StaticBatch {
+    uint32_t material{0};
+    std::vector<float> vertices; ///< Same layout as the instances, already transformed
+    AABB bounds;                 ///< World space
+};
+
+/**
+ * @class StaticMerger
+ * @brief Merges static meshes into a few large pre-transformed triangle lists.
+ *
+ * Instances are bucketed by material and by the cell of a uniform grid holding their origin,
+ * so every batch stays compact enough to be frustum culled on its own; a bucket over
+ * MAX_BATCH_VERTICES is split. The grid starts at the lowest instance origin rather than the
+ * world origin, which would cut a scene smaller than a cell in up to eight. Cell keys, the
+ * vertex transforms and the batch bounds are computed on JobSystem::shared(), leaving only
+ * the sort and the offsets on the caller. Makes no GL calls.
+ */
+class StaticMerger {
+  public:
+    static constexpr size_t STRIDE = 8; ///< Floats per vertex
+    static constexpr size_t MAX_BATCH_VERTICES = size_t(1) << 20;
+
+    /// Edge of the grid cells batches are split along, in world units
+    void setCellSize(float size) {
+        cellSize = size > 0.0f ? size : 1.0f;
+    }
+
+    float getCellSize() const {
+        return cellSize;
+    }
+
+    /// Replace @p batches with the merged @p instances, ordered by material
+    void merge(const std::vector<StaticInstance>& instances, std::vector<StaticBatch>& batches);
+
+  private:
+    static constexpr size_t GRAIN = 1024; ///< Instances per job
+
+    struct Entry {
+        uint32_t material;
+        uint64_t cell;
+        uint32_t instance;
+    };
+
+    struct Placement {
+        uint32_t batch;
+        size_t vertex; ///< First vertex in the batch
+    };
+
+    float cellSize{32.0f};
+    glm::vec3 origin{0.0f}; ///< Corner of the grid, the lowest instance origin
+    std::vector<Entry> entries;
+    std::vector<Placement> placements; ///< Per entry, in sorted order
+
+    uint64_t cellKey(const glm::vec3& position) const;
+};
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <cstdint>
+#include <vector>
+#include <glad/glad.h>
+
+/**
+ * @struct StreamAllocation
+ * @brief A sub-range of a StreamBuffer, writable until the next flush() or beginFrame().
+ */
+struct StreamAllocation {
+    void* data{nullptr};   ///< Where to write; nullptr if the allocation failed
+    unsigned int buffer{0}; ///< GL buffer to bind when drawing from it
+    GLintptr offset{0};    ///< Byte offset of the range inside buffer
+    GLsizeiptr size{0};
+
+    explicit operator bool() const {
+        return data != nullptr;
+    }
+};
+
+/**
+ * @class StreamBuffer
+ * @brief Ring of per-frame regions for data rewritten every frame (instances, particles, UBOs).
+ *
+ * The buffer is split into REGION_COUNT regions. Each frame sub-allocates linearly from the next
+ * one, and a fence placed when the frame ends tells when the GPU is done with it, so writes never
+ * race in-flight draws and never make the driver stall implicitly. The upload strategy depends
+ * on what the context offers:
+ *  - Persistent: GL 4.4 buffer storage, mapped once (coherent), allocations are plain pointers.
+ *  - Unsynchronized: GL 3.3 glMapBufferRange with MAP_UNSYNCHRONIZED, the fences doing the sync.
+ *  - Orphan: writes go to a CPU staging copy and are uploaded with glBufferSubData after the
+ *    storage is orphaned once per frame; no fences needed.
+ *
+ * Usage per frame: beginFrame(), any number of allocate(), then flush() before issuing the draws
+ * that read the data. Everything goes through RenderDevice, so the null backend works too.
+ */
+class StreamBuffer {
+  public:
+    enum class Mode { Persistent, Unsynchronized, Orphan };
+
+    static constexpr int REGION_COUNT = 3;
+
+    /**
+     * @param target Binding target used for uploads (GL_ARRAY_BUFFER, GL_UNIFORM_BUFFER, ...).
+     * @param capacity Bytes available per frame; grown by beginFrame() when asked for more.
+     * @param preferred Best mode to use; falls back to Unsynchronized without buffer storage.
+     */
+    StreamBuffer(GLenum target, GLsizeiptr capacity, Mode preferred = Mode::Persistent);
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    /**
+     * @brief Fence the region written since the last call and move to the next one.
+     * @param required Bytes the caller needs this frame; the buffer grows (after waiting for
+     * the GPU) if they don't fit.
+     *
+     * Blocks only if the GPU is still reading the region, i.e. REGION_COUNT frames behind.
+     */
+    void beginFrame(GLsizeiptr required = 0);
+
+    /**
+     * @brief Reserve @p size bytes in this frame's region.
+     * @param alignment Offset alignment, e.g. GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT for UBO ranges.
+     * @return The range, or an empty allocation if the region is full.
+     */
+    StreamAllocation allocate(GLsizeiptr size, GLsizeiptr alignment = 16);
+
+    /// Make every allocation so far visible to GL; call before drawing from them
+    void flush();
+
+    /// Delete the buffer and fences; call on the context thread
+    void release();
+
+    unsigned int getBuffer() const {
+        return buffer;
+    }
+
+    Mode getMode() const {
+        return mode;
+    }
+
+    /// Bytes available per frame
+    GLsizeiptr getCapacity() const {
+        return capacity;
+    }
+
+    /// Times beginFrame() had to block on a fence
+    uint64_t getStallCount() const {
+        return stalls;
+    }
+
+  private:
+    GLenum target;
+    GLsizeiptr capacity;
+    Mode preferred;
+    Mode mode;
+    unsigned int buffer{0};
+    int region{REGION_COUNT - 1};
+    GLsizeiptr cursor{0};  ///< Next free byte in the current region
+    GLsizeiptr flushed{0}; ///< Bytes of the current region already handed to GL
+    bool frameOpen{false};
+    GLsync fences[REGION_COUNT] = {};
+    uint64_t stalls{0};
+
+    unsigned char* persistent{nullptr}; ///< Whole-buffer mapping in Persistent mode
+    unsigned char* mapped{nullptr};     ///< Mapping of [flushed, capacity) in Unsynchronized mode
+    std::vector<unsigned char> staging; ///< CPU copy of the region in Orphan mode
+
+    void create();
+    void waitForRegion(int index);
+    GLintptr regionStart() const {
+        return mode == Mode::Orphan ? 0 : static_cast<GLintptr>(region) * capacity;
+    }
+};
+
+#endif
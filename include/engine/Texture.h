@@ -3,48 +3,114 @@
 #include <string>
 #include <engine/stb_image.h>
 #include <glad/glad.h>
+#include <engine/RenderDevice.h>
+#include <engine/TextureArray.h>
+#include <engine/TextureAtlas.h>
 
 class Texture {
   public:
     explicit Texture(const std::string& path) {
         id = createTextureFromFile(path.c_str());
     }
+    /// Load into a layer of an array in @p arrays instead of a texture of its own, so meshes
+    /// using different images of the same size can share a draw
+    Texture(const std::string& path, TextureArrayPool& arrays) : pool(&arrays) {
+        int width, height, nrChannels;
+        stbi_set_flip_vertically_on_load(true);
+        unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 4);
+        if (data) {
+            layer = arrays.add(data, width, height);
+        } else {
+            std::cout << "Failed to load texture: " << path << "\n";
+        }
+        stbi_image_free(data);
+    }
+    /// Pack a small image into a page of @p packer, so meshes using images of the same page
+    /// can share a draw; images too large for it get a texture of their own
+    Texture(const std::string& path, TextureAtlas& packer) {
+        int width, height, nrChannels;
+        stbi_set_flip_vertically_on_load(true);
+        unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 4);
+        if (data) {
+            region = packer.add(data, width, height);
+            if (region) {
+                atlas = &packer;
+                id = region.page;
+            } else {
+                id = createTextureFromPixels(data, width, height, GL_RGBA);
+            }
+        } else {
+            std::cout << "Failed to load texture: " << path << "\n";
+        }
+        stbi_image_free(data);
+    }
     ~Texture() {
-        glDeleteTextures(1, &id);
+        if (pool != nullptr) {
+            pool->remove(layer);
+        } else if (atlas != nullptr) {
+            atlas->remove(region);
+        } else {
+            RenderDevice::current().deleteTexture(id);
+        }
     }
+    /// GL_TEXTURE_2D id; the whole page for an atlas texture, see getUVTransform(), and 0 for
+    /// a texture loaded into an array
     unsigned int getId() const {
         return id;
     }
+    const TextureLayer& getLayer() const {
+        return layer;
+    }
+    /// Scale (xy) and offset (zw) taking the texture's coordinates to where it sits in getId()
+    const glm::vec4& getUVTransform() const {
+        return region.uvTransform;
+    }
 
   private:
-    unsigned int id;
+    unsigned int id{0};
+    TextureLayer layer;
+    AtlasRegion region;
+    TextureArrayPool* pool{nullptr};
+    TextureAtlas* atlas{nullptr};
     static unsigned int createTextureFromFile(const char* path) {
-        unsigned int textureID;
-        glGenTextures(1, &textureID);
-        glBindTexture(GL_TEXTURE_2D, textureID);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        int width, height, nrChannels;
+        int width = 0, height = 0, nrChannels = 0;
         stbi_set_flip_vertically_on_load(true);
         unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 0);
-        if (data) {
-            GLenum format = (nrChannels == 1) ? GL_RED : (nrChannels == 3) ? GL_RGB : GL_RGBA;
-            glTexImage2D(
-                GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-            glGenerateMipmap(GL_TEXTURE_2D);
-        } else {
+        if (!data) {
             std::cout << "Failed to load texture: " << path << "\n";
         }
+        GLenum format = (nrChannels == 1) ? GL_RED : (nrChannels == 3) ? GL_RGB : GL_RGBA;
+        unsigned int textureID = createTextureFromPixels(data, width, height, format);
         stbi_image_free(data);
         return textureID;
     }
+    static unsigned int
+    createTextureFromPixels(const unsigned char* data, int width, int height, GLenum format) {
+        RenderDevice& device = RenderDevice::current();
+        unsigned int textureID = device.createTexture();
+        device.bindTexture(0, GL_TEXTURE_2D, textureID);
+
+        device.texParameter(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        device.texParameter(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        device.texParameter(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        device.texParameter(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        if (data) {
+            device.texImage2D(
+                GL_TEXTURE_2D, 0, format, width, height, format, GL_UNSIGNED_BYTE, data);
+            device.generateMipmap(GL_TEXTURE_2D);
+        }
+        return textureID;
+    }
 };
 
 // Loader ( Needed for all the resources )
-static std::unique_ptr<Texture> textureLoader(const std::string& path) {
+inline std::unique_ptr<Texture> textureLoader(const std::string& path) {
     return std::make_unique<Texture>(path);
 }
+inline std::unique_ptr<Texture> layeredTextureLoader(const std::string& path) {
+    return std::make_unique<Texture>(path, TextureArrayPool::shared());
+}
+inline std::unique_ptr<Texture> atlasTextureLoader(const std::string& path) {
+    return std::make_unique<Texture>(path, TextureAtlas::shared());
+}
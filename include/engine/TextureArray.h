@@ -0,0 +1,102 @@
+#ifndef TEXTURE_ARRAY_H
+#define TEXTURE_ARRAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Next mip level of tightly packed RGBA8 pixels, with a 2x2 box filter.
+ *
+ * An odd last row or column is folded into its neighbour.
+ * @param out Resized to the half size, at least 1x1.
+ */
+void downsampleRGBA(const uint8_t* source, int width, int height, std::vector<uint8_t>& out);
+
+/**
+ * @struct TextureLayer
+ * @brief One image packed into a GL_TEXTURE_2D_ARRAY, see TextureArrayPool.
+ */
+struct TextureLayer {
+    unsigned int array{0}; ///< 0 = not packed
+    int layer{0};
+
+    explicit operator bool() const {
+        return array != 0;
+    }
+};
+
+/**
+ * @class TextureArrayPool
+ * @brief Packs same-size RGBA8 images into the layers of GL_TEXTURE_2D_ARRAY textures.
+ *
+ * Draws whose textures share an array differ only in the layer, which the renderer passes per
+ * instance, so they still batch into one instanced draw. Arrays have a fixed layer count and
+ * never move, so the ids handed out stay valid: the count comes from reserve() when the
+ * content is known, or from a memory budget otherwise, and a full array is followed by a new
+ * one. Mipmaps are built on the CPU, since glGenerateMipmap would redo every layer for each
+ * image added. Freed layers are reused, and an array is deleted with its last layer.
+ *
+ * Must be used on the thread that owns the GL context.
+ */
+class TextureArrayPool {
+  public:
+    static constexpr unsigned int UNIT = 8;
+    static constexpr const char* SAMPLER = "textureLayers";
+    static constexpr int MAX_LAYERS = 256; ///< GL 3.3's minimum GL_MAX_ARRAY_TEXTURE_LAYERS
+    static constexpr size_t ARRAY_BUDGET = size_t(32) << 20; ///< Bytes per unreserved array
+
+    /// Pool used by layeredTextureLoader
+    static TextureArrayPool& shared() {
+        static TextureArrayPool instance;
+        return instance;
+    }
+
+    TextureArrayPool() = default;
+    TextureArrayPool(const TextureArrayPool&) = delete;
+    TextureArrayPool& operator=(const TextureArrayPool&) = delete;
+
+    /// Size the next array created for @p width x @p height images to hold @p layers of them
+    void reserve(int width, int height, int layers);
+
+    /**
+     * @brief Copy an image into a free layer of an array of its size.
+     * @param rgba Tightly packed RGBA8 pixels, bottom row first like the rest of the textures.
+     * @return The layer, or an empty one for an empty image.
+     */
+    TextureLayer add(const unsigned char* rgba, int width, int height);
+
+    /// Free a layer taken by add()
+    void remove(const TextureLayer& layer);
+
+    size_t getArrayCount() const {
+        return arrays.size();
+    }
+
+    /// Delete every array; call on the context thread
+    void release();
+
+  private:
+    struct Array {
+        unsigned int texture{0};
+        int width{0};
+        int height{0};
+        int levels{0};
+        std::vector<bool> used; ///< One per layer
+        int usedCount{0};
+    };
+
+    struct Reservation {
+        int width;
+        int height;
+        int layers;
+    };
+
+    std::vector<Array> arrays;
+    std::vector<Reservation> reservations;
+    std::vector<uint8_t> mipmaps[2]; ///< Scratch for the mip chain, ping-ponged
+
+    Array& create(int width, int height);
+};
+
+#endif
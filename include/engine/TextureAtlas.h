@@ -0,0 +1,102 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @struct AtlasRegion
+ * @brief Where an image landed in a TextureAtlas page.
+ */
+struct AtlasRegion {
+    unsigned int page{0};                          ///< GL_TEXTURE_2D of the page, 0 = not packed
+    glm::vec4 uvTransform{1.0f, 1.0f, 0.0f, 0.0f}; ///< Scale (xy) and offset (zw) into the page
+
+    explicit operator bool() const {
+        return page != 0;
+    }
+};
+
+/**
+ * @class TextureAtlas
+ * @brief Packs small RGBA8 images into shared GL_TEXTURE_2D pages.
+ *
+ * Meshes using images of one page bind the same texture and batch together; each keeps its
+ * own uvTransform, which the vertex shader applies per instance. Images are placed with a
+ * bottom-left skyline packer and uploaded on their own, so adding one never touches the rest
+ * of its page. Every image is surrounded by BORDER copies of its edge texels and placed on a
+ * BORDER-aligned grid, so the LEVELS mip levels of a page are built per image on the CPU and
+ * none of them bleeds into a neighbour. Texture coordinates must stay within [0, 1], as there
+ * is no wrapping inside a page.
+ *
+ * The skyline doesn't take freed space back: a page is deleted once its last image is removed.
+ * Must be used on the thread that owns the GL context.
+ */
+class TextureAtlas {
+  public:
+    static constexpr int PAGE_SIZE = 2048;
+    static constexpr int MAX_IMAGE_SIZE = 256;       ///< Larger images are left to themselves
+    static constexpr int LEVELS = 4;                 ///< Mip levels of a page
+    static constexpr int BORDER = 1 << (LEVELS - 1); ///< Keeps one texel at the last level
+    static constexpr unsigned int UPLOAD_UNIT = 0;
+
+    /// Atlas used by atlasTextureLoader
+    static TextureAtlas& shared() {
+        static TextureAtlas instance;
+        return instance;
+    }
+
+    TextureAtlas() = default;
+    TextureAtlas(const TextureAtlas&) = delete;
+    TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+    /**
+     * @brief Copy an image into a page with room for it, opening a new page if none has.
+     * @param rgba Tightly packed RGBA8 pixels, bottom row first like the rest of the textures.
+     * @return The region, or an empty one for an empty image or one over MAX_IMAGE_SIZE.
+     */
+    AtlasRegion add(const unsigned char* rgba, int width, int height);
+
+    /// Give back a region returned by add()
+    void remove(const AtlasRegion& region);
+
+    size_t getPageCount() const {
+        return pages.size();
+    }
+
+    /// Delete every page; call on the context thread
+    void release();
+
+  private:
+    /// Span of the skyline: everything below y is taken between x and x + width
+    struct Segment {
+        int x;
+        int y;
+        int width;
+    };
+
+    struct Page {
+        unsigned int texture{0};
+        std::vector<Segment> skyline; ///< Left to right, covering the page width
+        int regionCount{0};
+    };
+
+    std::vector<Page> pages;
+    std::vector<uint8_t> block;      ///< Image with its border, level 0
+    std::vector<uint8_t> mipmaps[2]; ///< Scratch for the mip chain, ping-ponged
+
+    static bool place(Page& page, int width, int height, int& x, int& y);
+    Page& create();
+    void upload(const Page& page,
+                const unsigned char* rgba,
+                int width,
+                int height,
+                int x,
+                int y,
+                int blockWidth,
+                int blockHeight);
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef TRANSPARENCY_H
+#define TRANSPARENCY_H
+
+#include <glad/glad.h>
+#include <engine/RenderGraph.h>
+
+class Shader;
+class SceneTarget;
+
+/**
+ * @class WeightedTransparency
+ * @brief Render targets for weighted blended order-independent transparency.
+ *
+ * Transparent surfaces are accumulated in any order into two targets that share the depth of
+ * the opaque pass: an RGBA16F target holding the weighted color sum in rgb and the product of
+ * (1 - alpha) in a, and an R16F target holding the weight sum. A fullscreen pass then resolves
+ * them over the opaque color. GL 3.3 has no per-target blend factors, so one separate blend
+ * function does both jobs: additive for color, multiplicative for alpha.
+ *
+ * The default framebuffer's depth can't be shared with another framebuffer, so frames with
+ * weighted transparency draw into a SceneTarget. The targets are RenderGraph transients, and
+ * the cost is a fixed number of fullscreen passes, however many transparent surfaces overlap.
+ */
+class WeightedTransparency {
+  public:
+    static constexpr unsigned int ACCUMULATION_UNIT = 5;
+    static constexpr const char* ACCUMULATION_SAMPLER = "accumulation";
+    static constexpr unsigned int WEIGHT_UNIT = 6;
+    static constexpr const char* WEIGHT_SAMPLER = "weights";
+
+    WeightedTransparency() = default;
+    WeightedTransparency(const WeightedTransparency&) = delete;
+    WeightedTransparency& operator=(const WeightedTransparency&) = delete;
+
+    /// Create this frame's accumulation targets in @p graph, sized like @p scene's textures
+    void declare(RenderGraph& graph, const SceneTarget& scene);
+
+    RenderGraph::Resource getAccumulation() const {
+        return accumulation;
+    }
+
+    RenderGraph::Resource getWeights() const {
+        return weights;
+    }
+
+    /// Clear the bound accumulation targets and set their blending; depth stays the scene's,
+    /// read-only by then
+    void beginAccumulation();
+
+    /// Resolve the targets of @p graph over the bound scene color with @p shader
+    void composite(const Shader& shader, const RenderGraph& graph);
+
+    /// Delete the vertex array; call on the context thread
+    void release();
+
+  private:
+    RenderGraph::Resource accumulation{RenderGraph::BACK_BUFFER};
+    RenderGraph::Resource weights{RenderGraph::BACK_BUFFER};
+    unsigned int emptyVAO{0}; ///< Core profile needs a VAO even for attribute-less draws
+};
+
+#endif
@@ -4,14 +4,44 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <engine/stb_image.h>
 #include <unordered_map>
+#include <functional>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#include <utility>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <tuple>
 #include <glm/glm.hpp>
 #include <iostream>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <entt/entt.hpp>
 #include <engine/Shader.h>
+#include <engine/ShaderVariants.h>
 #include <engine/Texture.h>
 #include <engine/DeltaTime.h>
+#include <engine/RenderQueue.h>
+#include <engine/CommandList.h>
+#include <engine/RenderDevice.h>
+#include <engine/FrameUniforms.h>
+#include <engine/GLState.h>
+#include <engine/StreamBuffer.h>
+#include <engine/Culling.h>
+#include <engine/GpuCulling.h>
+#include <engine/ClusteredLighting.h>
+#include <engine/ShadowMaps.h>
+#include <engine/Transparency.h>
+#include <engine/DepthPrepass.h>
+#include <engine/SceneTarget.h>
+#include <engine/RenderGraph.h>
+#include <engine/DynamicResolution.h>
+#include <engine/OcclusionCulling.h>
+#include <engine/JobSystem.h>
+#include <engine/Profiler.h>
+#include <engine/StaticBatching.h>
+#include <engine/Particles.h>
 
 // --- Components ---
 struct Transform {
@@ -58,6 +88,74 @@ struct MeshRenderer {
     unsigned int VBO{0};
     unsigned int vertexCount{0};
     unsigned int texture1{0};
+    TextureLayer textureLayer;  ///< Array layer sampled instead of texture1 when set, needs
+                                ///< a TEXTURE_ARRAY shader variant
+    Shader* shader{nullptr};    ///< Falls back to the shader given to RenderingSystem::update
+    bool translucent{false};    ///< Drawn after opaque geometry with blending, casts no shadows
+    bool sortedBlending{false}; ///< Translucent only: exact back-to-front blending instead of
+                                ///< weighted order-independent transparency
+    float opacity{1.0f};        ///< Translucent only: multiplies the texture's alpha
+    /// Scale (xy) and offset (zw) of texture1's coordinates, set for atlas textures
+    glm::vec4 uvTransform{1.0f, 1.0f, 0.0f, 0.0f};
+    /// CPU copy of the interleaved vertices, kept by createCube for StaticBatchSystem
+    std::shared_ptr<const std::vector<float>> vertices;
+};
+
+struct Bounds {
+    AABB local; ///< Mesh-space box, see MeshSystem::computeBounds
+};
+
+struct MeshLODLevel {
+    unsigned int VAO{0};
+    unsigned int VBO{0};
+    unsigned int vertexCount{0};
+    float minScreenSize{0.0f}; ///< Used while the object covers at least this fraction of the
+                               ///< screen height; the last level should use 0
+};
+
+struct MeshLOD {
+    std::vector<MeshLODLevel> levels; ///< Finest first
+    int current{0};                   ///< Level picked last frame, drives the hysteresis
+};
+
+struct Occluder {
+    // Mesh-space triangle list rasterized into the occlusion buffer; usually a simplified hull
+    std::shared_ptr<const std::vector<glm::vec3>> triangles;
+};
+
+struct Static {};        // Never moves once loaded, so StaticBatchSystem may merge it
+struct StaticBatched {}; // Merged into a StaticChunk, which draws it instead
+struct StaticChunk {};   // Pre-transformed geometry of many Static entities
+
+struct Light {
+    enum class Type : std::uint8_t { Point, Spot, Directional };
+
+    Type type{Type::Point};
+    glm::vec3 color{1.0f};
+    float intensity{1.0f};
+    float range{10.0f};      ///< Point and spot lights fade out completely at this distance
+    float innerAngle{20.0f}; ///< Spot cone, degrees from the axis, full intensity inside
+    float outerAngle{30.0f}; ///< Spot cone edge, degrees from the axis
+    bool castShadows{false}; ///< Directional only; the first such light gets cascaded shadows
+    // Spot and directional lights point down the Transform's local -Z
+};
+
+struct ParticleEmitter {
+    float rate{100.0f};                 ///< Particles spawned per second
+    size_t maxParticles{10000};         ///< Spawning pauses while this many are alive
+    float minLifetime{1.0f};            ///< Seconds, picked uniformly per particle
+    float maxLifetime{2.0f};
+    glm::vec3 extent{0.0f};             ///< Half size of the spawn box around the Transform
+    glm::vec3 velocity{0.0f, 2.0f, 0.0f};
+    float spread{0.5f};                 ///< Random velocity added on each axis, up to this much
+    glm::vec3 gravity{0.0f, -9.81f, 0.0f};
+    float drag{0.0f};                   ///< Fraction of the velocity lost per second
+    glm::vec4 colorA{1.0f};             ///< Each particle's color lies between these two
+    glm::vec4 colorB{1.0f};
+    ParticleMaterial material;
+    ParticlePool particles;             ///< Live particles, managed by ParticleSystem
+    float pending{0.0f};                ///< Fraction of a particle carried to the next spawn
+    uint32_t seed{1};                   ///< Random state of the spawner, never 0
 };
 
 struct Scene {
@@ -81,6 +179,17 @@ struct ModelRenderer {
     std::vector<ModelMesh> meshes;
 };
 
+// --- Helpers ---
+inline glm::mat4 computeModelMatrix(const Transform& transform) {
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, transform.position);
+    model = glm::rotate(model, glm::radians(transform.rotation.x), glm::vec3(1, 0, 0));
+    model = glm::rotate(model, glm::radians(transform.rotation.y), glm::vec3(0, 1, 0));
+    model = glm::rotate(model, glm::radians(transform.rotation.z), glm::vec3(0, 0, 1));
+    model = glm::scale(model, transform.scale);
+    return model;
+}
+
 // --- Helper Enums ---
 enum class CameraMovement : std::uint8_t { FORWARD, BACKWARD, LEFT, RIGHT };
 
@@ -181,74 +290,1773 @@ class InputSystem {
 class MeshSystem {
   public:
     static MeshRenderer createCube(float* vertices, size_t vertSize, unsigned int texture1 = 0) {
+        MeshRenderer mesh = createMesh(vertices, vertSize);
+        mesh.vertices =
+            std::make_shared<std::vector<float>>(vertices, vertices + vertSize / sizeof(float));
+        mesh.texture1 = texture1;
+        return mesh;
+    }
+
+    /// Upload interleaved vertices like createCube, without keeping a CPU copy
+    static MeshRenderer createMesh(const float* vertices, size_t vertSize) {
+        RenderDevice& device = RenderDevice::current();
         MeshRenderer mesh;
-        glGenVertexArrays(1, &mesh.VAO);
-        glGenBuffers(1, &mesh.VBO);
+        mesh.VAO = device.createVertexArray();
+        mesh.VBO = device.createBuffer();
 
-        glBindVertexArray(mesh.VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertSize, vertices, GL_STATIC_DRAW);
+        device.bindVertexArray(mesh.VAO);
+        device.bindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+        device.bufferData(GL_ARRAY_BUFFER, vertSize, vertices, GL_STATIC_DRAW);
 
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(
-            1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(
-            2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-        glEnableVertexAttribArray(2);
+        device.vertexAttribPointer(0, 3, GL_FLOAT, false, 8 * sizeof(float), 0);
+        device.enableVertexAttribArray(0);
+        device.vertexAttribPointer(1, 3, GL_FLOAT, false, 8 * sizeof(float), 3 * sizeof(float));
+        device.enableVertexAttribArray(1);
+        device.vertexAttribPointer(2, 2, GL_FLOAT, false, 8 * sizeof(float), 6 * sizeof(float));
+        device.enableVertexAttribArray(2);
 
-        glBindVertexArray(0);
+        device.bindVertexArray(0);
 
         mesh.vertexCount = static_cast<unsigned int>(vertSize / (8 * sizeof(float)));
-        mesh.texture1 = texture1;
         return mesh;
     }
+
+    /// Sample @p texture, a 2D texture, an atlas region or an array layer depending on how it
+    /// was loaded
+    static void setTexture(MeshRenderer& mesh, const Texture& texture) {
+        mesh.texture1 = texture.getId();
+        mesh.textureLayer = texture.getLayer();
+        mesh.uvTransform = texture.getUVTransform();
+    }
+
+    /// setTexture, then use the variant of @p variants that samples the texture the way it was
+    /// loaded, so no shader has to branch on it
+    static void setTexture(MeshRenderer& mesh, const Texture& texture, ShaderVariants& variants) {
+        setTexture(mesh, texture);
+        mesh.shader = &variants.get(mesh.textureLayer ? variants.getFeature("TEXTURE_ARRAY") : 0);
+    }
+
+    /// Local AABB of interleaved vertices laid out like createCube expects (position first)
+    static Bounds computeBounds(const float* vertices, size_t vertSize, size_t stride = 8) {
+        Bounds bounds;
+        size_t count = vertSize / (stride * sizeof(float));
+        if (count == 0) {
+            return bounds;
+        }
+        bounds.local.min = bounds.local.max = glm::vec3(vertices[0], vertices[1], vertices[2]);
+        for (size_t i = 1; i < count; ++i) {
+            glm::vec3 position(
+                vertices[i * stride], vertices[i * stride + 1], vertices[i * stride + 2]);
+            bounds.local.min = glm::min(bounds.local.min, position);
+            bounds.local.max = glm::max(bounds.local.max, position);
+        }
+        return bounds;
+    }
+
+    /// One LOD level from an interleaved vertex buffer, uploaded like createCube
+    static MeshLODLevel createLODLevel(float* vertices, size_t vertSize, float minScreenSize) {
+        MeshRenderer mesh = createMesh(vertices, vertSize);
+        return MeshLODLevel{mesh.VAO, mesh.VBO, mesh.vertexCount, minScreenSize};
+    }
+
+    /// Occluder built from the positions of an interleaved triangle list
+    static Occluder createOccluder(const float* vertices, size_t vertSize, size_t stride = 8) {
+        size_t count = vertSize / (stride * sizeof(float));
+        auto triangles = std::make_shared<std::vector<glm::vec3>>();
+        triangles->reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            triangles->emplace_back(
+                vertices[i * stride], vertices[i * stride + 1], vertices[i * stride + 2]);
+        }
+        return Occluder{std::move(triangles)};
+    }
+};
+
+// --- Static Batch System ---
+/**
+ * @class StaticBatchSystem
+ * @brief Scene-load pass merging Static meshes that share a material into StaticChunk meshes.
+ *
+ * Each chunk is one pre-transformed vertex buffer covering a cell of space (see StaticMerger),
+ * with world Bounds and an identity Transform, so culling, shadows and batching treat it like
+ * any other mesh while the merged entities are skipped. Translucent meshes, meshes with LODs or
+ * an Occluder, and meshes without a CPU copy of their vertices are left alone.
+ */
+class StaticBatchSystem {
+  public:
+    /// Merge every Static entity not merged yet; returns the number of chunks created
+    static size_t build(entt::registry& registry, float cellSize = 32.0f) {
+        auto view = registry.view<Static, Transform, MeshRenderer>(
+            entt::exclude<StaticBatched, StaticChunk, MeshLOD, Occluder>);
+        std::vector<entt::entity> entities;
+        std::vector<StaticInstance> instances;
+        std::vector<MeshRenderer> materials; ///< First mesh seen of each material
+        for (auto entity : view) {
+            const MeshRenderer& mesh = view.get<MeshRenderer>(entity);
+            if (mesh.translucent || !mesh.vertices || mesh.vertices->empty()) {
+                continue;
+            }
+            uint32_t material = 0;
+            while (material < materials.size() && !sameMaterial(materials[material], mesh)) {
+                ++material;
+            }
+            if (material == materials.size()) {
+                materials.push_back(mesh);
+            }
+            StaticInstance instance;
+            instance.vertices = mesh.vertices->data();
+            instance.vertexCount =
+                static_cast<uint32_t>(mesh.vertices->size() / StaticMerger::STRIDE);
+            instance.material = material;
+            instance.uvTransform = mesh.uvTransform;
+            instances.push_back(instance);
+            entities.push_back(entity);
+        }
+        if (instances.empty()) {
+            return 0;
+        }
+
+        JobSystem::shared().parallelFor(instances.size(), GRAIN, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                instances[i].model = computeModelMatrix(view.get<Transform>(entities[i]));
+            }
+        });
+
+        StaticMerger merger;
+        merger.setCellSize(cellSize);
+        std::vector<StaticBatch> batches;
+        merger.merge(instances, batches);
+
+        for (const StaticBatch& batch : batches) {
+            const MeshRenderer& source = materials[batch.material];
+            size_t bytes = batch.vertices.size() * sizeof(float);
+            MeshRenderer mesh = MeshSystem::createMesh(batch.vertices.data(), bytes);
+            mesh.texture1 = source.texture1;
+            mesh.textureLayer = source.textureLayer;
+            mesh.shader = source.shader;
+
+            auto chunk = registry.create();
+            registry.emplace<Transform>(chunk);
+            registry.emplace<MeshRenderer>(chunk, mesh);
+            registry.emplace<Bounds>(chunk, Bounds{batch.bounds});
+            registry.emplace<StaticChunk>(chunk);
+        }
+        registry.insert<StaticBatched>(entities.begin(), entities.end());
+        return batches.size();
+    }
+
+    /// Delete the chunks and draw the merged entities on their own again
+    static void clear(entt::registry& registry) {
+        RenderDevice& device = RenderDevice::current();
+        auto chunks = registry.view<StaticChunk, MeshRenderer>();
+        for (auto chunk : chunks) {
+            const MeshRenderer& mesh = chunks.get<MeshRenderer>(chunk);
+            device.deleteVertexArray(mesh.VAO);
+            device.deleteBuffer(mesh.VBO);
+        }
+        std::vector<entt::entity> entities(chunks.begin(), chunks.end());
+        registry.destroy(entities.begin(), entities.end());
+        registry.clear<StaticBatched>();
+    }
+
+  private:
+    static constexpr size_t GRAIN = 1024; ///< Entities per job
+
+    static bool sameMaterial(const MeshRenderer& a, const MeshRenderer& b) {
+        return a.shader == b.shader && a.texture1 == b.texture1 &&
+               a.textureLayer.array == b.textureLayer.array &&
+               a.textureLayer.layer == b.textureLayer.layer;
+    }
+};
+
+// --- LOD System ---
+class LODSystem {
+  public:
+    /// Values above 1 make every object switch to coarser levels sooner (e.g. under load)
+    void setBias(float value) {
+        bias = std::max(value, 0.01f);
+    }
+
+    float getBias() const {
+        return bias;
+    }
+
+    /// Relative margin a screen size must cross past a threshold before the level changes
+    void setHysteresis(float value) {
+        hysteresis = std::clamp(value, 0.0f, 0.9f);
+    }
+
+    /**
+     * @brief Projected height of a bounding sphere as a fraction of the screen height.
+     * @param center Sphere center in world space.
+     * @param radius Sphere radius.
+     * @param cam Camera looking at it.
+     */
+    static float screenSize(const glm::vec3& center, float radius, const Camera& cam) {
+        float distance = glm::length(center - cam.position);
+        if (distance <= radius) {
+            return 1.0f;
+        }
+        return radius / (distance * std::tan(glm::radians(cam.fov) * 0.5f));
+    }
+
+    /**
+     * @brief Pick the level to draw and remember it in lod.current.
+     * @return The selected level, or nullptr if the component has no levels.
+     */
+    const MeshLODLevel* select(MeshLOD& lod, float size) const {
+        if (lod.levels.empty()) {
+            return nullptr;
+        }
+
+        int last = static_cast<int>(lod.levels.size()) - 1;
+        int current = std::clamp(lod.current, 0, last);
+        size /= bias;
+
+        int target = last;
+        for (int i = 0; i < last; ++i) {
+            if (size >= lod.levels[i].minScreenSize) {
+                target = i;
+                break;
+            }
+        }
+
+        // Only move once the size is clearly past the threshold being crossed, so objects
+        // sitting right on a boundary don't flicker between levels
+        if (target > current) {
+            if (size < lod.levels[current].minScreenSize * (1.0f - hysteresis)) {
+                current = target;
+            }
+        } else if (target < current) {
+            for (int i = target; i < current; ++i) {
+                if (size >= lod.levels[i].minScreenSize * (1.0f + hysteresis)) {
+                    current = i;
+                    break;
+                }
+            }
+        }
+
+        lod.current = current;
+        return &lod.levels[current];
+    }
+
+  private:
+    float bias{1.0f};
+    float hysteresis{0.1f};
+};
+
+// --- Culling System ---
+struct VisibleEntity {
+    entt::entity entity;
+    glm::mat4 model;
+};
+
+class CullingSystem {
+  public:
+    CullingSystem(entt::registry& reg) : registry(reg) {}
+
+    /// Spread bounds computation and plane tests over JobSystem::shared()
+    void setParallel(bool enabled) {
+        parallel = enabled;
+    }
+
+    /// Rasterize Occluder meshes into a CPU depth buffer and drop what they fully hide
+    void setOcclusionCulling(bool enabled) {
+        occlusion = enabled;
+    }
+
+    /// Gpu mode asks the renderer to test on the GPU; whether it can is up to it, see update()
+    void setMode(CullingMode value) {
+        mode = value;
+    }
+
+    CullingMode getMode() const {
+        return mode;
+    }
+
+    const OcclusionBuffer& getOcclusionBuffer() const {
+        return occlusionBuffer;
+    }
+
+    /**
+     * @brief Collect this frame's visible renderables.
+     *
+     * Entities with a Bounds component are tested against the frustum of @p viewProj, unless
+     * @p gpuCulling leaves that to the GPU this frame; those without one can't be tested and
+     * are always kept. World bounds are computed either way, for cullCandidates().
+     */
+    void update(const glm::mat4& viewProj, bool gpuCulling = false) {
+        candidates.clear();
+        visible.clear();
+
+        auto bounded =
+            registry.view<Transform, MeshRenderer, Bounds>(entt::exclude<StaticBatched>);
+        for (auto entity : bounded) {
+            candidates.push_back(entity);
+        }
+
+        size_t count = candidates.size();
+        candidateModels.resize(count);
+        culler.resize(count);
+        auto gather = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                glm::mat4 model = computeModelMatrix(bounded.get<Transform>(candidates[i]));
+                glm::vec3 center;
+                glm::vec3 extents;
+                transformBounds(model, bounded.get<Bounds>(candidates[i]).local, center, extents);
+                candidateModels[i] = model;
+                culler.set(i, center, extents);
+            }
+        };
+
+        Frustum frustum = Frustum::fromMatrix(viewProj);
+        if (parallel) {
+            JobSystem::shared().parallelFor(count, CHUNK_SIZE, gather);
+        } else {
+            gather(0, count);
+        }
+        if (gpuCulling) {
+            visibleIndices.resize(count);
+            std::iota(visibleIndices.begin(), visibleIndices.end(), 0u);
+        } else if (parallel) {
+            culler.cullParallel(frustum, visibleIndices, JobSystem::shared(), CHUNK_SIZE);
+        } else {
+            culler.cull(frustum, visibleIndices);
+        }
+
+        for (uint32_t index : visibleIndices) {
+            visible.push_back(VisibleEntity{candidates[index], candidateModels[index]});
+        }
+        culledCount = count - visibleIndices.size();
+
+        auto unbounded =
+            registry.view<Transform, MeshRenderer>(entt::exclude<Bounds, StaticBatched>);
+        unbounded.each([&](auto entity, auto& tf, auto&) {
+            visible.push_back(VisibleEntity{entity, computeModelMatrix(tf)});
+        });
+
+        occludedCount = 0;
+        if (occlusion) {
+            cullOccluded(viewProj);
+        }
+    }
+
+    const std::vector<VisibleEntity>& getVisible() const {
+        return visible;
+    }
+
+    size_t getCulledCount() const {
+        return culledCount;
+    }
+
+    size_t getOccludedCount() const {
+        return occludedCount;
+    }
+
+    /**
+     * @brief Test the bounded renderables of the last update() against another frustum.
+     * @param viewProj Matrix the frustum is extracted from, e.g. a shadow cascade's.
+     * @param indices Receives the candidates inside, see getCandidate()/getCandidateModel().
+     *
+     * Reuses the world bounds computed by update(), so it only costs the plane tests.
+     */
+    void cullCandidates(const glm::mat4& viewProj, std::vector<uint32_t>& indices) {
+        Frustum frustum = Frustum::fromMatrix(viewProj);
+        if (parallel) {
+            culler.cullParallel(frustum, indices, JobSystem::shared(), CHUNK_SIZE);
+        } else {
+            culler.cull(frustum, indices);
+        }
+    }
+
+    entt::entity getCandidate(uint32_t index) const {
+        return candidates[index];
+    }
+
+    const glm::mat4& getCandidateModel(uint32_t index) const {
+        return candidateModels[index];
+    }
+
+  private:
+    static constexpr size_t CHUNK_SIZE = 16384;
+
+    entt::registry& registry;
+    bool parallel{false};
+    bool occlusion{false};
+    CullingMode mode{CullingMode::Cpu};
+    FrustumCuller culler;
+    OcclusionBuffer occlusionBuffer;
+    std::vector<entt::entity> candidates;
+    std::vector<glm::mat4> candidateModels;
+    std::vector<uint32_t> visibleIndices;
+    std::vector<VisibleEntity> visible;
+    size_t culledCount{0};
+    size_t occludedCount{0};
+
+    // Only occluders that survived the frustum test are rasterized
+    void cullOccluded(const glm::mat4& viewProj) {
+        occlusionBuffer.begin(viewProj);
+        for (const auto& [entity, model] : visible) {
+            if (const auto* occluder = registry.try_get<Occluder>(entity)) {
+                if (occluder->triangles) {
+                    occlusionBuffer.rasterize(
+                        model, occluder->triangles->data(), occluder->triangles->size());
+                }
+            }
+        }
+        occlusionBuffer.finish();
+
+        auto hidden = [&](const VisibleEntity& candidate) {
+            const auto* bounds = registry.try_get<Bounds>(candidate.entity);
+            if (bounds == nullptr) {
+                return false;
+            }
+            glm::vec3 center;
+            glm::vec3 extents;
+            transformBounds(candidate.model, bounds->local, center, extents);
+            return !occlusionBuffer.isVisible(center, extents);
+        };
+        auto end = std::remove_if(visible.begin(), visible.end(), hidden);
+        occludedCount = static_cast<size_t>(visible.end() - end);
+        visible.erase(end, visible.end());
+    }
+};
+
+// --- Lighting System ---
+class LightingSystem {
+  public:
+    LightingSystem(entt::registry& reg) : registry(reg) {}
+
+    /// Spread the cluster assignment over JobSystem::shared()
+    void setParallel(bool enabled) {
+        parallel = enabled;
+    }
+
+    /// Ambient term once the scene has lights; scenes without any are drawn unlit, as before
+    void setAmbient(const glm::vec3& value) {
+        ambient = value;
+    }
+
+    /// Lights sent to the shaders last frame, directional ones included
+    size_t getLightCount() const {
+        return lightCount;
+    }
+
+    /**
+     * @brief Gather the Light entities in view space and bin them into the cluster grid.
+     *
+     * Directional lights go first in @p out and reach every fragment; point and spot lights are
+     * only listed in the clusters they touch. Makes no GL calls.
+     */
+    void record(const glm::mat4& view,
+                const glm::mat4& projection,
+                float nearPlane,
+                float farPlane,
+                int width,
+                int height,
+                LightFrame& out) {
+        out.lights.clear();
+        out.shadowLight = -1;
+        auto lights = registry.view<Transform, Light>();
+        for (auto entity : lights) {
+            const auto& light = lights.get<Light>(entity);
+            if (light.type != Light::Type::Directional) {
+                continue;
+            }
+            const auto& transform = lights.get<Transform>(entity);
+            if (light.castShadows && out.shadowLight < 0) {
+                out.shadowLight = static_cast<int>(out.lights.size());
+                out.shadowDirection = worldDirection(transform);
+            }
+            out.lights.push_back(toView(transform, light, view));
+        }
+        int directionalCount = static_cast<int>(out.lights.size());
+        for (auto entity : lights) {
+            const auto& light = lights.get<Light>(entity);
+            if (light.type != Light::Type::Directional) {
+                out.lights.push_back(toView(lights.get<Transform>(entity), light, view));
+            }
+        }
+        lightCount = out.lights.size();
+
+        grid.setProjection(projection, nearPlane, farPlane);
+        grid.assign(
+            out.lights, out.clusters, out.indices, parallel ? &JobSystem::shared() : nullptr);
+
+        out.grid.gridSize = glm::ivec4(LightClusterGrid::GRID_X,
+                                       LightClusterGrid::GRID_Y,
+                                       LightClusterGrid::GRID_Z,
+                                       directionalCount);
+        out.grid.gridScale = glm::vec4(float(LightClusterGrid::GRID_X) / width,
+                                       float(LightClusterGrid::GRID_Y) / height,
+                                       grid.getSliceScale(),
+                                       grid.getSliceBias());
+        out.grid.ambient = glm::vec4(out.lights.empty() ? glm::vec3(1.0f) : ambient, 0.0f);
+    }
+
+  private:
+    entt::registry& registry;
+    bool parallel{true};
+    glm::vec3 ambient{0.05f};
+    size_t lightCount{0};
+    LightClusterGrid grid;
+
+    static glm::vec3 worldDirection(const Transform& transform) {
+        glm::mat3 rotation(computeModelMatrix(Transform{glm::vec3(0.0f), transform.rotation}));
+        return glm::normalize(rotation * glm::vec3(0, 0, -1));
+    }
+
+    static GPULight toView(const Transform& transform, const Light& light, const glm::mat4& view) {
+        GPULight gpu;
+        glm::vec3 radiance = light.color * light.intensity;
+        if (light.type == Light::Type::Point) {
+            gpu.positionRange = glm::vec4(glm::vec3(view * glm::vec4(transform.position, 1.0f)),
+                                          std::max(light.range, 0.001f));
+            gpu.colorInnerCos = glm::vec4(radiance, -1.0f);
+            gpu.directionOuterCos = glm::vec4(0.0f, 0.0f, 0.0f, -2.0f);
+            return gpu;
+        }
+
+        glm::vec3 direction = glm::normalize(glm::mat3(view) * worldDirection(transform));
+        if (light.type == Light::Type::Directional) {
+            gpu.colorInnerCos = glm::vec4(radiance, 1.0f);
+            gpu.directionOuterCos = glm::vec4(direction, 1.0f);
+            return gpu;
+        }
+
+        float outer = glm::clamp(light.outerAngle, 0.1f, 179.9f);
+        float inner = glm::clamp(light.innerAngle, 0.0f, outer - 0.05f);
+        gpu.positionRange = glm::vec4(glm::vec3(view * glm::vec4(transform.position, 1.0f)),
+                                      std::max(light.range, 0.001f));
+        gpu.colorInnerCos = glm::vec4(radiance, std::cos(glm::radians(inner)));
+        gpu.directionOuterCos = glm::vec4(direction, std::cos(glm::radians(outer)));
+        return gpu;
+    }
+};
+
+// --- Shadow System ---
+class ShadowSystem {
+  public:
+    ShadowSystem(entt::registry& reg) : registry(reg) {}
+
+    void setEnabled(bool value) {
+        enabled = value;
+    }
+
+    bool isEnabled() const {
+        return enabled;
+    }
+
+    CascadedShadowMap& getCascades() {
+        return cascades;
+    }
+
+    /**
+     * @brief Fit the cascades of the shadowed light and work out which ones must be redrawn.
+     *
+     * Every cascade gets its own caster culling pass over the renderables CullingSystem
+     * gathered, opaque ones with Bounds only. A cascade whose matrix and casters (meshes and
+     * model matrices) match the previous frame is not redrawn. Makes no GL calls.
+     */
+    void record(const glm::mat4& view,
+                const Camera& cam,
+                float aspect,
+                float nearPlane,
+                const LightFrame& lights,
+                CullingSystem& culling,
+                const Shader* depthShader,
+                ShadowFrame& out) {
+        out.redrawMask = 0;
+        out.shader = depthShader;
+        out.data.params = glm::ivec4(-1, 0, 0, 0);
+        casterCount = 0;
+        redrawCount = 0;
+        if (!enabled || lights.shadowLight < 0 || depthShader == nullptr) {
+            cascades.invalidate();
+            return;
+        }
+
+        cascades.fit(view, glm::radians(cam.fov), aspect, nearPlane, lights.shadowDirection, out);
+        out.data.params.x = lights.shadowLight;
+        for (int cascade = 0; cascade < CascadedShadowMap::CASCADE_COUNT; ++cascade) {
+            culling.cullCandidates(out.lightViewProj[cascade], indices);
+            casters.clear();
+            for (uint32_t index : indices) {
+                const auto& mesh = registry.get<MeshRenderer>(culling.getCandidate(index));
+                if (!mesh.translucent) {
+                    casters.push_back(ShadowCaster{
+                        mesh.VAO, mesh.vertexCount, culling.getCandidateModel(index)});
+                }
+            }
+            // Stable, so the order only changes when the casters do
+            std::stable_sort(casters.begin(),
+                             casters.end(),
+                             [](const ShadowCaster& a, const ShadowCaster& b) {
+                                 return a.VAO < b.VAO;
+                             });
+            casterCount += casters.size();
+
+            out.casters[cascade].clear();
+            if (cascades.update(cascade, out.lightViewProj[cascade], casters)) {
+                out.casters[cascade] = casters;
+                out.redrawMask |= 1u << cascade;
+                ++redrawCount;
+            }
+        }
+    }
+
+    /// Casters found over every cascade last frame, counted once per cascade
+    size_t getCasterCount() const {
+        return casterCount;
+    }
+
+    /// Cascades that had to be drawn again last frame
+    int getRedrawCount() const {
+        return redrawCount;
+    }
+
+  private:
+    entt::registry& registry;
+    bool enabled{true};
+    CascadedShadowMap cascades;
+    std::vector<uint32_t> indices;
+    std::vector<ShadowCaster> casters;
+    size_t casterCount{0};
+    int redrawCount{0};
+};
+
+// --- Particle System ---
+class ParticleSystem {
+  public:
+    static constexpr size_t CHUNK_SIZE = 16384; ///< Particles per simulation or copy job
+
+    ParticleSystem(entt::registry& reg) : registry(reg) {}
+
+    /**
+     * @brief Advance every ParticleEmitter by @p dt, then drop dead particles and spawn new ones.
+     *
+     * Chunks of CHUNK_SIZE particles, over all emitters, are simulated in parallel on
+     * JobSystem::shared(); each emitter is then compacted and refilled by a job of its own.
+     */
+    void update(float dt) {
+        sources.clear();
+        for (auto [entity, emitter] : registry.view<ParticleEmitter>().each()) {
+            const auto* transform = registry.try_get<Transform>(entity);
+            sources.push_back(
+                Source{&emitter, transform != nullptr ? transform->position : glm::vec3(0.0f)});
+        }
+
+        JobSystem& jobs = JobSystem::shared();
+        buildChunks();
+        jobs.parallelFor(chunks.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const Chunk& chunk = chunks[i];
+                ParticleEmitter& emitter = *sources[chunk.source].emitter;
+                emitter.particles.simulate(
+                    chunk.begin, chunk.end, dt, emitter.gravity, emitter.drag);
+            }
+        });
+        jobs.parallelFor(sources.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                sources[i].emitter->particles.compact();
+                spawn(*sources[i].emitter, sources[i].origin, dt);
+            }
+        });
+    }
+
+    /// Copy the particles left by the last update() into @p out, emitters sharing a material
+    /// next to each other so they are drawn together
+    void record(ParticleFrame& out) {
+        out.clear();
+        std::stable_sort(sources.begin(), sources.end(), [](const Source& a, const Source& b) {
+            const ParticleMaterial& left = a.emitter->material;
+            const ParticleMaterial& right = b.emitter->material;
+            return std::tie(left.texture, left.additive, left.size, left.fadeTime) <
+                   std::tie(right.texture, right.additive, right.size, right.fadeTime);
+        });
+
+        firsts.resize(sources.size());
+        for (size_t i = 0; i < sources.size(); ++i) {
+            const ParticleEmitter& emitter = *sources[i].emitter;
+            size_t count = emitter.particles.size();
+            firsts[i] = out.count;
+            if (count == 0) {
+                continue;
+            }
+            if (!out.draws.empty() && out.draws.back().material == emitter.material) {
+                out.draws.back().count += count;
+            } else {
+                out.draws.push_back(ParticleDraw{emitter.material, out.count, count});
+            }
+            out.count += count;
+        }
+        out.columns.resize(out.count * ParticleFrame::COLUMN_COUNT);
+        out.colors.resize(out.count);
+
+        buildChunks();
+        JobSystem::shared().parallelFor(chunks.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const Chunk& chunk = chunks[i];
+                const ParticlePool& pool = sources[chunk.source].emitter->particles;
+                size_t first = firsts[chunk.source] + chunk.begin;
+                size_t bytes = (chunk.end - chunk.begin) * sizeof(float);
+                std::memcpy(out.column(ParticleFrame::X) + first, &pool.x[chunk.begin], bytes);
+                std::memcpy(out.column(ParticleFrame::Y) + first, &pool.y[chunk.begin], bytes);
+                std::memcpy(out.column(ParticleFrame::Z) + first, &pool.z[chunk.begin], bytes);
+                std::memcpy(
+                    out.column(ParticleFrame::Life) + first, &pool.life[chunk.begin], bytes);
+                std::memcpy(&out.colors[first], &pool.color[chunk.begin], bytes);
+            }
+        });
+    }
+
+  private:
+    struct Source {
+        ParticleEmitter* emitter;
+        glm::vec3 origin; ///< Where the emitter's Transform puts it
+    };
+
+    struct Chunk {
+        size_t source;
+        size_t begin;
+        size_t end;
+    };
+
+    entt::registry& registry;
+    std::vector<Source> sources; ///< Emitters found by the last update()
+    std::vector<Chunk> chunks;
+    std::vector<size_t> firsts;  ///< First particle of each source in the recorded frame
+
+    void buildChunks() {
+        chunks.clear();
+        for (size_t i = 0; i < sources.size(); ++i) {
+            size_t count = sources[i].emitter->particles.size();
+            for (size_t begin = 0; begin < count; begin += CHUNK_SIZE) {
+                chunks.push_back(Chunk{i, begin, std::min(begin + CHUNK_SIZE, count)});
+            }
+        }
+    }
+
+    static void spawn(ParticleEmitter& emitter, const glm::vec3& origin, float dt) {
+        emitter.pending += emitter.rate * dt;
+        size_t wanted = static_cast<size_t>(emitter.pending);
+        emitter.pending -= static_cast<float>(wanted);
+        size_t alive = std::min(emitter.particles.size(), emitter.maxParticles);
+        size_t count = std::min(wanted, emitter.maxParticles - alive);
+        if (count == 0) {
+            return;
+        }
+
+        uint32_t state = emitter.seed != 0u ? emitter.seed : 1u;
+        auto random = [&state]() {
+            // xorshift32, top 24 bits mapped to [0, 1)
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return static_cast<float>(state >> 8) * (1.0f / 16777216.0f);
+        };
+        emitter.particles.reserve(emitter.maxParticles); // Once, not a few more every frame
+        for (size_t i = 0; i < count; ++i) {
+            glm::vec3 box(random(), random(), random());
+            glm::vec3 jitter(random(), random(), random());
+            float lifetime = glm::mix(emitter.minLifetime, emitter.maxLifetime, random());
+            glm::vec4 color = glm::mix(emitter.colorA, emitter.colorB, random());
+            emitter.particles.push(origin + (box * 2.0f - 1.0f) * emitter.extent,
+                                   emitter.velocity + (jitter * 2.0f - 1.0f) * emitter.spread,
+                                   lifetime,
+                                   color);
+        }
+        emitter.seed = state;
+    }
 };
 
 // --- Rendering System ---
+struct RenderStats {
+    uint32_t visible{0};         ///< Entities that reached the render queue
+    uint32_t frustumCulled{0};   ///< Entities outside the camera frustum
+    uint32_t occlusionCulled{0}; ///< Entities hidden behind Occluder meshes
+    uint32_t drawCalls{0};
+    uint32_t shadowCasters{0};   ///< Casters over every shadow cascade
+    uint32_t shadowRedraws{0};   ///< Cascades drawn again rather than reused
+    uint32_t particles{0};       ///< Particles recorded for drawing
+    bool depthPrepass{false};    ///< Whether the last submitted frame ran the depth prepass
+    float overdraw{0.0f};        ///< Opaque fragments per pixel, measured in Auto prepass mode
+    float renderScale{1.0f};     ///< Fraction of the back buffer size the scene was drawn at
+    float gpuFrameTime{0.0f};    ///< Milliseconds, from a recent submitted frame
+    uint32_t renderPasses{0};    ///< Render graph passes run by the last submitted frame
+    uint32_t culledPasses{0};    ///< Passes the graph dropped as unused
+    uint64_t targetBytes{0};     ///< Memory held by the graph's pool of transient targets
+    GLStateStats stateCalls;     ///< GL state calls of the last submitted frame, see GLState
+    TimingStats cpuTimings;      ///< Phases of record(), smoothed
+    TimingStats gpuTimings;      ///< Render graph passes, smoothed, from a recent frame
+
+    static constexpr int MAX_LOD_LEVELS = CommandList::MAX_LOD_LEVELS;
+    uint32_t lodLevels[MAX_LOD_LEVELS] = {}; ///< Entities drawn at each MeshLOD level (last
+                                             ///< bucket also counts coarser levels)
+};
+
+/**
+ * @struct FrameSnapshot
+ * @brief Immutable result of RenderingSystem::record(), everything submit() needs to draw a frame.
+ *
+ * Holds no registry references, so it can be handed to a render thread while the simulation
+ * moves on. Shader pointers and GL object ids must stay alive until the snapshot is submitted.
+ */
+struct FrameSnapshot {
+    FrameData frameData; ///< Camera matrices and time
+    RenderQueue queue;   ///< Sorted draw packets with their world matrices
+    RenderStats stats;   ///< CPU-side counters of the frame that produced it
+    bool batching{true}; ///< RenderingSystem::isBatching() at record time
+    LightFrame lighting; ///< View-space lights and their cluster lists
+    ShadowFrame shadows; ///< Cascade matrices and the casters of cascades to redraw
+    /// Resolves weighted transparency; null when every translucent item was recorded sorted
+    const Shader* compositeShader{nullptr};
+    DepthPrepassMode depthPrepass{DepthPrepassMode::Off};
+    const Shader* depthShader{nullptr};   ///< Position-only program of the depth prepass
+    float renderScale{1.0f};              ///< DynamicResolution scale picked at record time
+    const Shader* upscaleShader{nullptr}; ///< Resamples a scaled scene to the back buffer
+    bool gpuCulling{false};               ///< Frustum test left to GpuCuller, see CullingMode
+    bool prepareGpuCuller{false};         ///< CullingMode::Gpu is wanted; build GpuCuller
+    ParticleFrame particles;              ///< Live particles, drawn after transparent meshes
+    const Shader* particleShader{nullptr};
+};
+
 class RenderingSystem {
   public:
-    RenderingSystem(entt::registry& reg) : registry(reg) {}
+    RenderingSystem(entt::registry& reg)
+        : registry(reg), culling(reg), lighting(reg), shadows(reg), particles(reg) {
+        graph.setProfiler(&gpuProfiler);
+    }
+
+    static constexpr float NEAR_PLANE = 0.1f;
+    static constexpr float FAR_PLANE = 100.0f;
+
+    /// When enabled, consecutive queue items with identical state are drawn as one instanced call
+    void setBatching(bool enabled) {
+        batching = enabled;
+    }
+
+    bool isBatching() const {
+        return batching;
+    }
+
+    CullingSystem& getCulling() {
+        return culling;
+    }
+
+    LODSystem& getLOD() {
+        return lod;
+    }
+
+    /// Frustum test of CullingMode::Gpu; give it its shaders before switching the mode
+    GpuCuller& getGpuCuller() {
+        return gpuCuller;
+    }
+
+    LightingSystem& getLighting() {
+        return lighting;
+    }
+
+    ShadowSystem& getShadows() {
+        return shadows;
+    }
+
+    ParticleSystem& getParticles() {
+        return particles;
+    }
+
+    /// Depth-only program shadow casters are drawn with; without one there are no shadows
+    void setShadowShader(const Shader* shader) {
+        shadowShader = shader;
+    }
+
+    /// Fullscreen program resolving weighted transparency; without one every translucent mesh
+    /// takes the sorted path
+    void setCompositeShader(const Shader* shader) {
+        compositeShader = shader;
+    }
+
+    /// Draw opaque depth first and shade with GL_EQUAL; Auto decides from measured overdraw
+    void setDepthPrepass(DepthPrepassMode mode) {
+        depthPrepass = mode;
+    }
+
+    DepthPrepassMode getDepthPrepass() const {
+        return depthPrepass;
+    }
+
+    /// Position-only program the prepass draws with; without one there is no prepass. It must
+    /// place vertices exactly like the opaque shaders do.
+    void setDepthShader(const Shader* shader) {
+        depthShader = shader;
+    }
+
+    /// Render scale control; enable it to trade resolution for GPU time
+    DynamicResolution& getDynamicResolution() {
+        return resolution;
+    }
+
+    /// Billboard program of ParticleEmitter particles; without one they are simulated but not
+    /// drawn
+    void setParticleShader(const Shader* shader) {
+        particleShader = shader;
+    }
+
+    /// Fullscreen program upscaling frames drawn below full resolution; a bilinear blit is used
+    /// without one
+    void setUpscaleShader(const Shader* shader) {
+        upscaleShader = shader;
+    }
+
+    /// Counters of the last recorded frame; drawCalls and what submit culled instead of record,
+    /// on the GPU or item by item, come from the last submitted one
+    RenderStats getStats() const {
+        RenderStats result = stats;
+        result.drawCalls = submittedDrawCalls.load(std::memory_order_relaxed);
+        result.depthPrepass = submittedPrepass.load(std::memory_order_relaxed);
+        result.overdraw = submittedOverdraw.load(std::memory_order_relaxed);
+        result.gpuFrameTime = gpuTimer.getMilliseconds();
+        result.renderPasses = submittedPasses.load(std::memory_order_relaxed);
+        result.culledPasses = submittedCulled.load(std::memory_order_relaxed);
+        result.targetBytes = submittedTargetBytes.load(std::memory_order_relaxed);
+        result.stateCalls.issued = submittedStateIssued.load(std::memory_order_relaxed);
+        result.stateCalls.elided = submittedStateElided.load(std::memory_order_relaxed);
+        result.gpuTimings = gpuProfiler.getTimings();
+        result.frustumCulled += submittedFrustumCulled.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    /// Delete the GL objects owned by this system; call on the context thread before teardown
+    void release() {
+        frameUniforms.release();
+        lightBuffers.release();
+        shadowMaps.release();
+        transparency.release();
+        sceneTarget.release();
+        graph.release();
+        overdraw.release();
+        gpuTimer.release();
+        gpuProfiler.release();
+        gpuCuller.release();
+        particleRenderer.release();
+        instanceStream.release();
+        shadowInstanceStream.release();
+        instancedVAOs.clear();
+    }
 
     void update(Shader& shader, const Camera& cam, int width, int height) {
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        record(shader, cam, width, height, frame);
+        submit(frame);
+    }
 
-        glm::mat4 view = glm::lookAt(cam.position, cam.position + cam.front, cam.up);
-        glm::mat4 projection =
-            glm::perspective(glm::radians(cam.fov), float(width) / height, 0.1f, 100.0f);
+    /**
+     * @brief CPU half of the frame: culling, lights and shadows, LOD, matrices and sort keys,
+     * then the particle simulation.
+     *
+     * Visible entities are split into chunks recorded in parallel into per-chunk CommandLists,
+     * which are then merged and sorted into @p out. Makes no GL calls.
+     */
+    void record(Shader& shader, const Camera& cam, int width, int height, FrameSnapshot& out) {
+        view = glm::lookAt(cam.position, cam.position + cam.front, cam.up);
+        projection = glm::perspective(
+            glm::radians(cam.fov), float(width) / height, NEAR_PLANE, FAR_PLANE);
+        out.frameData = makeFrameData(cam);
+        out.batching = batching;
+        out.compositeShader = compositeShader;
+        out.depthPrepass = depthPrepass;
+        out.depthShader = depthShader;
+        out.renderScale = resolution.update(gpuTimer);
+        out.upscaleShader = upscaleShader;
+        // GpuCuller is built on the context thread: until a submit has managed that, and
+        // without batching, the frustum test stays on the CPU
+        out.prepareGpuCuller = culling.getMode() == CullingMode::Gpu && batching;
+        out.gpuCulling = out.prepareGpuCuller && gpuCullerReady.load(std::memory_order_relaxed);
+        gpuCulling = out.gpuCulling;
 
-        shader.use();
-        shader.setMat4("view", view);
-        shader.setMat4("projection", projection);
+        stats = RenderStats{};
+        stats.renderScale = out.renderScale;
+        {
+            ScopedTimer timer(cpuTimings, "culling");
+            culling.update(projection * view, gpuCulling);
+        }
+        stats.frustumCulled = static_cast<uint32_t>(culling.getCulledCount());
+        stats.occlusionCulled = static_cast<uint32_t>(culling.getOccludedCount());
+        {
+            // Clusters are looked up by pixel, so the grid follows the size actually drawn
+            ScopedTimer timer(cpuTimings, "lights");
+            int renderWidth = std::max(1, int(std::floor(width * out.renderScale + 0.5f)));
+            int renderHeight = std::max(1, int(std::floor(height * out.renderScale + 0.5f)));
+            lighting.record(
+                view, projection, NEAR_PLANE, FAR_PLANE, renderWidth, renderHeight, out.lighting);
+        }
+        {
+            ScopedTimer timer(cpuTimings, "shadows");
+            shadows.record(view,
+                           cam,
+                           float(width) / height,
+                           NEAR_PLANE,
+                           out.lighting,
+                           culling,
+                           shadowShader,
+                           out.shadows);
+        }
+        stats.shadowCasters = static_cast<uint32_t>(shadows.getCasterCount());
+        stats.shadowRedraws = static_cast<uint32_t>(shadows.getRedrawCount());
+
+        {
+            ScopedTimer timer(cpuTimings, "commands");
+            recordCommandLists(shader, cam);
+        }
+        {
+            ScopedTimer timer(cpuTimings, "sort");
+            out.queue.clear();
+            for (const auto& list : commandLists) {
+                out.queue.append(list.getKeys(), list.getItems());
+                for (int level = 0; level < RenderStats::MAX_LOD_LEVELS; ++level) {
+                    stats.lodLevels[level] += list.lodLevels[level];
+                }
+            }
+            out.queue.sort();
+        }
+        stats.visible = static_cast<uint32_t>(out.queue.size());
+        {
+            ScopedTimer timer(cpuTimings, "particles");
+            particles.update(out.frameData.time.y);
+            out.particles.clear();
+            if (particleShader != nullptr) {
+                particles.record(out.particles);
+            }
+        }
+        out.particleShader = particleShader;
+        stats.particles = static_cast<uint32_t>(out.particles.count);
+        stats.cpuTimings = cpuTimings;
+        out.stats = stats;
+    }
+
+    /**
+     * @brief GL half of the frame: replays a snapshot produced by record().
+     *
+     * The passes are declared to a RenderGraph, which orders them, drops unused ones and
+     * allocates their offscreen targets from a pool. Must run on the thread that owns the GL
+     * context. Only touches the snapshot and the GL resources owned by this system, never the
+     * registry, so it may overlap the next record().
+     */
+    void submit(const FrameSnapshot& snapshot) {
+        RenderDevice& device = RenderDevice::current();
+        gpuTimer.begin();
+        gpuProfiler.beginFrame();
+        int viewport[4];
+        device.getViewport(viewport);
+
+        frameUniforms.update(snapshot.frameData);
+        lightBuffers.update(snapshot.lighting);
+        if (snapshot.prepareGpuCuller) {
+            gpuCullerReady.store(gpuCuller.prepare(), std::memory_order_relaxed);
+        }
+        // Without instance data (mapping failed) fall back to one draw per item
+        instanced = snapshot.batching && !snapshot.queue.empty() &&
+                    uploadInstances(snapshot.queue, snapshot.gpuCulling);
+        gpuCulled = instanced && snapshot.gpuCulling && cullInstances(snapshot);
+        // Recorded without the CPU frustum test, yet not culled on the GPU: draw item by item
+        // and test each one here instead
+        itemCulled.clear();
+        size_t itemsCulled = 0;
+        if (snapshot.gpuCulling && !gpuCulled) {
+            instanced = false;
+            itemsCulled = cullItems(snapshot);
+        }
+        frameDrawCalls = 0;
 
-        auto viewMesh = registry.view<Transform, MeshRenderer>();
-        viewMesh.each([&](auto& tf, auto& mesh) { renderEntity(tf, mesh, shader); });
+        graph.beginFrame(viewport);
+        declarePasses(snapshot, viewport);
+        graph.execute();
+
+        submittedDrawCalls.store(frameDrawCalls, std::memory_order_relaxed);
+        submittedPasses.store(graph.getExecutedCount(), std::memory_order_relaxed);
+        submittedCulled.store(graph.getCulledCount(), std::memory_order_relaxed);
+        submittedTargetBytes.store(graph.getPoolBytes(), std::memory_order_relaxed);
+        // The GPU culler counts runs as their draws read them back, so only now is it complete
+        size_t frustumCulled = gpuCulled ? gpuCuller.getCulledCount() : itemsCulled;
+        submittedFrustumCulled.store(static_cast<uint32_t>(frustumCulled),
+                                     std::memory_order_relaxed);
+        // Counted since the caller's GLState::resetFrameStats(), so up to here
+        submittedStateIssued.store(GLState::frameStats().issued, std::memory_order_relaxed);
+        submittedStateElided.store(GLState::frameStats().elided, std::memory_order_relaxed);
+        gpuProfiler.endFrame();
+        gpuTimer.end();
     }
 
   private:
+    static constexpr size_t RECORD_CHUNK_SIZE = 2048; ///< Visible entities per CommandList
+    /// Model matrix, texture layer and uvTransform
+    static constexpr size_t INSTANCE_BYTES = sizeof(glm::mat4) + sizeof(float) + sizeof(glm::vec4);
+    static constexpr size_t BOUNDS_BYTES = 2 * sizeof(glm::vec3); ///< Only with GPU culling
+    static constexpr GLsizeiptr INSTANCE_STREAM_CAPACITY = 4096 * INSTANCE_BYTES;
+
     entt::registry& registry;
+    CullingSystem culling;
+    LODSystem lod;
+    LightingSystem lighting;
+    ShadowSystem shadows;
+    ParticleSystem particles;
+    const Shader* shadowShader{nullptr};
+    const Shader* compositeShader{nullptr};
+    const Shader* depthShader{nullptr};
+    DepthPrepassMode depthPrepass{DepthPrepassMode::Auto};
+    const Shader* upscaleShader{nullptr};
+    const Shader* particleShader{nullptr};
+    DynamicResolution resolution;
+    RenderStats stats;
+    bool batching{true};
+    bool gpuCulling{false}; ///< This frame's frustum test is left to gpuCuller
+    glm::mat4 view{1.0f};
+    glm::mat4 projection{1.0f};
+    std::vector<CommandList> commandLists; ///< One per recording chunk, reused every frame
+    FrameSnapshot frame;                   ///< Recorded and submitted inline by update()
+
+    // Submit side, only touched by the thread that owns the GL context
+    std::atomic<uint32_t> submittedDrawCalls{0};
+    std::atomic<bool> submittedPrepass{false};
+    std::atomic<float> submittedOverdraw{0.0f};
+    std::atomic<uint32_t> submittedPasses{0};
+    std::atomic<uint32_t> submittedCulled{0};
+    std::atomic<uint64_t> submittedTargetBytes{0};
+    std::atomic<uint32_t> submittedFrustumCulled{0};
+    std::atomic<uint32_t> submittedStateIssued{0};
+    std::atomic<uint32_t> submittedStateElided{0};
+    std::atomic<bool> gpuCullerReady{false}; ///< gpuCuller's program is built
+    RenderGraph graph;
+    FrameUniformBuffer frameUniforms;
+    LightBuffers lightBuffers;
+    ShadowMaps shadowMaps;
+    SceneTarget sceneTarget;
+    WeightedTransparency transparency;
+    OverdrawMonitor overdraw;
+    GpuFrameTimer gpuTimer;
+    GpuProfiler gpuProfiler; ///< Times the graph's passes
+    TimingStats cpuTimings;  ///< Phases of record()
+    StreamBuffer instanceStream{GL_ARRAY_BUFFER, INSTANCE_STREAM_CAPACITY};
+    StreamBuffer shadowInstanceStream{GL_ARRAY_BUFFER, INSTANCE_STREAM_CAPACITY};
+    InstanceStreams instances;               ///< This frame's per-instance data in the stream
+    std::vector<unsigned int> instancedVAOs; ///< VAOs with instance attributes enabled
+    GpuCuller gpuCuller;
+    ParticleRenderer particleRenderer;
+    bool instanced{false};                   ///< This frame's matrices are in the stream
+    bool gpuCulled{false};                   ///< This frame's runs went through gpuCuller
+    std::vector<uint8_t> itemCulled;         ///< Per queue position, see cullItems()
+    bool weightedFrame{false};               ///< This frame resolves weighted transparency
+    uint32_t frameDrawCalls{0};
+
+    FrameData makeFrameData(const Camera& cam) const {
+        FrameData data;
+        data.view = view;
+        data.projection = projection;
+        data.cameraPosition = glm::vec4(cam.position, 1.0f);
+        if (const auto* dt = registry.ctx().find<DeltaTime>()) {
+            data.time = glm::vec4(dt->getTime().elapsedTime, dt->getTime().deltaTime, 0.0f, 0.0f);
+        }
+        return data;
+    }
+
+    void recordCommandLists(Shader& defaultShader, const Camera& cam) {
+        const auto& visible = culling.getVisible();
+        size_t chunks = JobSystem::chunkCount(visible.size(), RECORD_CHUNK_SIZE);
+        if (commandLists.size() < chunks) {
+            commandLists.resize(chunks);
+        }
+        for (auto& list : commandLists) {
+            list.clear();
+        }
+
+        // Workers only use get/try_get, which never create pools; the one write is
+        // MeshLOD::current, and each entity belongs to a single chunk
+        auto recordChunk = [&](size_t begin, size_t end) {
+            CommandList& list = commandLists[begin / RECORD_CHUNK_SIZE];
+            list.reserve(end - begin);
+            for (size_t i = begin; i < end; ++i) {
+                recordEntity(visible[i], defaultShader, cam, list);
+            }
+        };
+        JobSystem::shared().parallelFor(visible.size(), RECORD_CHUNK_SIZE, recordChunk);
+    }
+
+    void recordEntity(const VisibleEntity& visible,
+                      Shader& defaultShader,
+                      const Camera& cam,
+                      CommandList& list) {
+        const auto& mesh = std::as_const(registry).get<MeshRenderer>(visible.entity);
+        DrawItem item;
+        item.shader = mesh.shader != nullptr ? mesh.shader : &defaultShader;
+        item.VAO = mesh.VAO;
+        item.texture1 = mesh.texture1;
+        item.textureArray = mesh.textureLayer.array;
+        item.layer = static_cast<float>(mesh.textureLayer.layer);
+        item.uvTransform = mesh.uvTransform;
+        item.vertexCount = mesh.vertexCount;
+        item.opacity = mesh.translucent ? mesh.opacity : 1.0f;
+        item.model = visible.model;
+        if (gpuCulling) {
+            if (const auto* bounds = registry.try_get<Bounds>(visible.entity)) {
+                item.boundsMin = bounds->local.min;
+                item.boundsMax = bounds->local.max;
+            }
+        }
+        applyLOD(visible.entity, item, cam, list);
+
+        RenderBucket bucket = RenderBucket::Opaque;
+        if (mesh.translucent) {
+            bool sorted = mesh.sortedBlending || compositeShader == nullptr;
+            bucket = sorted ? RenderBucket::SortedTransparent : RenderBucket::Transparent;
+        }
+
+        // Layers of one array sort together, whatever image they hold
+        float distance = glm::dot(glm::vec3(item.model[3]) - cam.position, cam.front);
+        float depth = (distance - NEAR_PLANE) / (FAR_PLANE - NEAR_PLANE);
+        uint64_t key = RenderQueue::makeKey(bucket,
+                                            item.shader->getShaderProgramID(),
+                                            item.textureArray != 0u ? item.textureArray
+                                                                    : item.texture1,
+                                            item.VAO,
+                                            depth);
+        list.push(key, item);
+    }
+
+    // Swap in the MeshLOD level matching the entity's projected size, if it has one
+    void applyLOD(entt::entity entity, DrawItem& item, const Camera& cam, CommandList& list) {
+        auto* meshLOD = registry.try_get<MeshLOD>(entity);
+        if (meshLOD == nullptr) {
+            return;
+        }
+
+        glm::vec3 center(item.model[3]);
+        glm::vec3 extents(0.5f);
+        if (const auto* bounds = registry.try_get<Bounds>(entity)) {
+            transformBounds(item.model, bounds->local, center, extents);
+        }
+
+        float size = LODSystem::screenSize(center, glm::length(extents), cam);
+        if (const MeshLODLevel* level = lod.select(*meshLOD, size)) {
+            item.VAO = level->VAO;
+            item.vertexCount = level->vertexCount;
+            ++list.lodLevels[std::min(meshLOD->current, RenderStats::MAX_LOD_LEVELS - 1)];
+        }
+    }
+
+    static bool sameState(const DrawItem& a, const DrawItem& b) {
+        return a.shader == b.shader && a.VAO == b.VAO && a.texture1 == b.texture1 &&
+               a.textureArray == b.textureArray && a.vertexCount == b.vertexCount &&
+               a.opacity == b.opacity;
+    }
+
+    // Shadows, opaque, weighted and sorted transparency and, when the scene is drawn offscreen,
+    // the pass bringing it to the back buffer. Pass lambdas only capture this and the snapshot,
+    // which std::function keeps without allocating; the rest of the frame's state is members.
+    void declarePasses(const FrameSnapshot& snapshot, const int viewport[4]) {
+        const RenderQueue& queue = snapshot.queue;
+        size_t transparentBegin = queue.bucketStart(RenderBucket::Transparent);
+        size_t sortedBegin = queue.bucketStart(RenderBucket::SortedTransparent);
+        bool hasViewport = viewport[2] > 0 && viewport[3] > 0;
+
+        // Drawing below full resolution, and weighted transparency, which needs the opaque depth
+        // in a framebuffer of its own, both go through the scene target
+        weightedFrame =
+            snapshot.compositeShader != nullptr && transparentBegin < sortedBegin && hasViewport;
+        bool offscreen = weightedFrame || (snapshot.renderScale < 1.0f && hasViewport);
+
+        RenderGraph::Resource shadowMap = graph.importTexture("shadowMap",
+                                                              shadowMaps.getTexture(),
+                                                              CascadedShadowMap::RESOLUTION,
+                                                              CascadedShadowMap::RESOLUTION);
+        graph.addPass("shadows",
+                      [this, &snapshot](RenderGraph&) { submitShadows(snapshot.shadows); })
+            .modify(shadowMap);
+
+        RenderGraph::Resource color = RenderGraph::BACK_BUFFER;
+        RenderGraph::Resource depth = RenderGraph::BACK_BUFFER;
+        int width = viewport[2];
+        int height = viewport[3];
+        if (offscreen) {
+            sceneTarget.declare(graph, viewport, snapshot.renderScale);
+            color = sceneTarget.getColor();
+            depth = sceneTarget.getDepth();
+            width = sceneTarget.getRenderWidth();
+            height = sceneTarget.getRenderHeight();
+        }
+
+        graph
+            .addPass("opaque",
+                     [this, &snapshot](RenderGraph&) {
+                         RenderDevice::current().clear(glm::vec4(0.2f, 0.3f, 0.3f, 1.0f),
+                                                       GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                         shadowMaps.bind(snapshot.shadows.data);
+                         if (!snapshot.queue.empty()) {
+                             frameDrawCalls += submitOpaque(snapshot);
+                         }
+                     })
+            .write(color)
+            .writeDepth(depth)
+            .read(shadowMap)
+            .viewport(width, height);
+
+        if (weightedFrame) {
+            transparency.declare(graph, sceneTarget);
+            graph
+                .addPass("accumulate",
+                         [this, &snapshot](RenderGraph&) {
+                             const RenderQueue& queue = snapshot.queue;
+                             RenderDevice& device = RenderDevice::current();
+                             device.setEnabled(GL_BLEND, true);
+                             device.depthMask(false);
+                             transparency.beginAccumulation();
+                             frameDrawCalls +=
+                                 drawRange(queue,
+                                           queue.bucketStart(RenderBucket::Transparent),
+                                           queue.bucketStart(RenderBucket::SortedTransparent),
+                                           instanced,
+                                           true);
+                             device.setEnabled(GL_BLEND, false);
+                             device.depthMask(true);
+                         })
+                .write(transparency.getAccumulation())
+                .write(transparency.getWeights())
+                .readDepth(depth)
+                .read(shadowMap)
+                .viewport(width, height);
+            graph
+                .addPass("composite",
+                         [this, &snapshot](RenderGraph& frame) {
+                             transparency.composite(*snapshot.compositeShader, frame);
+                             ++frameDrawCalls;
+                         })
+                .read(transparency.getAccumulation())
+                .read(transparency.getWeights())
+                .write(color)
+                .viewport(width, height);
+        }
+
+        if ((!weightedFrame && transparentBegin < sortedBegin) || sortedBegin < queue.size()) {
+            graph
+                .addPass("transparent",
+                         [this, &snapshot](RenderGraph&) { drawTransparent(snapshot.queue); })
+                .write(color)
+                .readDepth(depth)
+                .read(shadowMap)
+                .viewport(width, height);
+        }
+
+        if (snapshot.particleShader != nullptr && !snapshot.particles.draws.empty()) {
+            graph
+                .addPass("particles",
+                         [this, &snapshot](RenderGraph&) {
+                             frameDrawCalls += particleRenderer.draw(snapshot.particles,
+                                                                     *snapshot.particleShader);
+                         })
+                .write(color)
+                .readDepth(depth)
+                .viewport(width, height);
+        }
+
+        if (offscreen) {
+            sceneTarget.addPresentPass(graph, snapshot.upscaleShader);
+        }
+    }
+
+    // Sorted items back to front, after the weighted ones when those couldn't be resolved
+    void drawTransparent(const RenderQueue& queue) {
+        size_t transparentBegin = queue.bucketStart(RenderBucket::Transparent);
+        size_t sortedBegin = queue.bucketStart(RenderBucket::SortedTransparent);
+        RenderDevice& device = RenderDevice::current();
+        device.setEnabled(GL_BLEND, true);
+        device.depthMask(false);
+        device.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        if (!weightedFrame) {
+            // No scene target: plain blending, in state order rather than depth order
+            frameDrawCalls += drawRange(queue, transparentBegin, sortedBegin, instanced, false);
+        }
+        frameDrawCalls += drawRange(queue, sortedBegin, queue.size(), instanced, false);
+        device.setEnabled(GL_BLEND, false);
+        device.depthMask(true);
+    }
+
+    // Opaque items, behind a depth prepass when the snapshot asks for one or, in Auto mode,
+    // when the overdraw measured on earlier frames says it pays off
+    uint32_t submitOpaque(const FrameSnapshot& snapshot) {
+        const RenderQueue& queue = snapshot.queue;
+        size_t end = queue.bucketStart(RenderBucket::Transparent);
+        bool batching = instanced;
+        const Shader* shader = snapshot.depthShader;
+        bool measure = snapshot.depthPrepass == DepthPrepassMode::Auto && shader != nullptr;
+        bool prepass = shader != nullptr && end > 0 &&
+                       (snapshot.depthPrepass == DepthPrepassMode::On ||
+                        (measure && overdraw.prefersPrepass()));
+        submittedPrepass.store(prepass, std::memory_order_relaxed);
+
+        RenderDevice& device = RenderDevice::current();
+        uint64_t pixels = 0;
+        if (measure) {
+            int viewport[4];
+            device.getViewport(viewport);
+            pixels = uint64_t(std::max(viewport[2], 0)) * uint64_t(std::max(viewport[3], 0));
+            overdraw.begin();
+        }
+
+        uint32_t drawCalls = 0;
+        if (!prepass) {
+            drawCalls += drawRange(queue, 0, end, batching, false);
+            overdraw.end(pixels);
+        } else {
+            device.colorMask(false);
+            drawCalls += drawDepthRange(queue, 0, end, batching, *shader);
+            overdraw.end(pixels);
+            device.colorMask(true);
+            device.depthFunc(GL_EQUAL);
+            device.depthMask(false);
+            drawCalls += drawRange(queue, 0, end, batching, false);
+            device.depthFunc(GL_LESS);
+            device.depthMask(true);
+        }
+        submittedOverdraw.store(overdraw.getOverdraw(), std::memory_order_relaxed);
+        return drawCalls;
+    }
+
+    // Depth-only draws of sorted positions [begin, end). Only positions and matrices matter, so
+    // runs merge across shaders and textures wherever the VAO repeats, unless they were culled
+    // on the GPU, whose output follows drawRange's runs.
+    uint32_t drawDepthRange(const RenderQueue& queue,
+                            size_t begin,
+                            size_t end,
+                            bool batching,
+                            const Shader& shader) {
+        RenderDevice& device = RenderDevice::current();
+        shader.use();
+        shader.setBool("instanced", batching);
+        uint32_t drawCalls = 0;
+
+        size_t i = begin;
+        while (i < end) {
+            const DrawItem& item = queue[i];
+            if (!batching && culledItem(i)) {
+                ++i;
+                continue;
+            }
+            size_t runEnd = i + 1;
+            if (batching) {
+                while (runEnd < end && joinsDepthRun(item, queue[runEnd])) {
+                    ++runEnd;
+                }
+            }
+
+            device.bindVertexArray(item.VAO);
+            if (batching) {
+                drawCalls += drawInstances(item, i, runEnd - i);
+            } else {
+                shader.setMat4("model", item.model);
+                device.drawArrays(GL_TRIANGLES, 0, item.vertexCount);
+                ++drawCalls;
+            }
+            i = runEnd;
+        }
+        return drawCalls;
+    }
+
+    // Draw sorted positions [begin, end) and return the draw call count. Shaders are bound
+    // afresh in every range since their pass uniforms differ.
+    uint32_t
+    drawRange(const RenderQueue& queue, size_t begin, size_t end, bool batching, bool weighted) {
+        RenderDevice& device = RenderDevice::current();
+        const Shader* boundShader = nullptr;
+        float boundOpacity = 1.0f;
+        glm::vec4 boundUVTransform(1.0f, 1.0f, 0.0f, 0.0f);
+        uint32_t drawCalls = 0;
+
+        size_t i = begin;
+        while (i < end) {
+            const DrawItem& item = queue[i];
+            if (!batching && culledItem(i)) {
+                ++i;
+                continue;
+            }
+
+            // Group consecutive items sharing all state; sorted order keeps them adjacent
+            size_t runEnd = i + 1;
+            if (batching) {
+                while (runEnd < end && sameState(item, queue[runEnd])) {
+                    ++runEnd;
+                }
+            }
+
+            // View and projection come from the FrameData block; only the pass flags and opacity
+            // are per program. Which texture gets sampled is up to the shader variant.
+            bool layered = item.textureArray != 0u;
+            if (item.shader != boundShader) {
+                item.shader->use();
+                item.shader->setBool("instanced", batching);
+                item.shader->setBool("weightedBlend", weighted);
+                item.shader->setFloat("opacity", item.opacity);
+                item.shader->setVec4("uvTransform", item.uvTransform);
+                boundShader = item.shader;
+                boundOpacity = item.opacity;
+                boundUVTransform = item.uvTransform;
+            } else if (item.opacity != boundOpacity) {
+                item.shader->setFloat("opacity", item.opacity);
+                boundOpacity = item.opacity;
+            }
+
+            if (layered) {
+                device.bindTexture(TextureArrayPool::UNIT, GL_TEXTURE_2D_ARRAY, item.textureArray);
+            } else if (item.texture1 != 0u) {
+                device.bindTexture(0, GL_TEXTURE_2D, item.texture1);
+            }
+            device.bindVertexArray(item.VAO);
+
+            if (batching) {
+                drawCalls += drawInstances(item, i, runEnd - i);
+            } else {
+                item.shader->setMat4("model", item.model);
+                if (layered) {
+                    item.shader->setFloat("layer", item.layer);
+                }
+                if (item.uvTransform != boundUVTransform) {
+                    item.shader->setVec4("uvTransform", item.uvTransform);
+                    boundUVTransform = item.uvTransform;
+                }
+                device.drawArrays(GL_TRIANGLES, 0, item.vertexCount);
+                ++drawCalls;
+            }
+            i = runEnd;
+        }
+        return drawCalls;
+    }
+
+    // Frustum test of every item of a frame recorded for GPU culling that couldn't cull on the
+    // GPU, so its items are drawn one by one and skipped here instead; items without bounds are
+    // always drawn. Returns the number culled.
+    size_t cullItems(const FrameSnapshot& snapshot) {
+        const RenderQueue& queue = snapshot.queue;
+        Frustum frustum =
+            Frustum::fromMatrix(snapshot.frameData.projection * snapshot.frameData.view);
+        itemCulled.assign(queue.size(), 0);
+        size_t culled = 0;
+        for (size_t i = 0; i < queue.size(); ++i) {
+            const DrawItem& item = queue[i];
+            if (item.boundsMin.x > item.boundsMax.x) {
+                continue;
+            }
+            glm::vec3 center;
+            glm::vec3 extents;
+            transformBounds(item.model, AABB{item.boundsMin, item.boundsMax}, center, extents);
+            if (!frustum.intersects(center, extents)) {
+                itemCulled[i] = 1;
+                ++culled;
+            }
+        }
+        return culled;
+    }
+
+    bool culledItem(size_t position) const {
+        return position < itemCulled.size() && itemCulled[position] != 0;
+    }
+
+    bool joinsDepthRun(const DrawItem& run, const DrawItem& item) const {
+        if (gpuCulled) {
+            return sameState(run, item);
+        }
+        return item.VAO == run.VAO && item.vertexCount == run.vertexCount;
+    }
+
+    // Instanced draw of the run at sorted positions [first, first + count), whose VAO is bound.
+    // A run culled on the GPU draws only its visible instances, from the culler's output, and
+    // nothing at all when none is left. Returns the draw calls issued.
+    uint32_t drawInstances(const DrawItem& item, size_t first, size_t count) {
+        RenderDevice& device = RenderDevice::current();
+        int run = gpuCulled ? gpuCuller.findRun(first) : -1;
+        if (run < 0) {
+            bindInstanceRange(item.VAO, instances, first);
+            device.drawArraysInstanced(
+                GL_TRIANGLES, 0, item.vertexCount, static_cast<GLsizei>(count));
+            return 1;
+        }
+
+        GLsizei visible = gpuCuller.getVisibleCount(run);
+        if (visible == 0) {
+            return 0;
+        }
+        bindInstanceRange(item.VAO, gpuCuller.getOutput(run), 0);
+        device.drawArraysInstanced(GL_TRIANGLES, 0, item.vertexCount, visible);
+        return 1;
+    }
+
+    // Queue the frustum test of every instanced run before any of them is drawn. Runs are the
+    // ones drawRange forms: items sharing state within one bucket.
+    bool cullInstances(const FrameSnapshot& snapshot) {
+        const RenderQueue& queue = snapshot.queue;
+        glm::mat4 viewProj = snapshot.frameData.projection * snapshot.frameData.view;
+        GpuProfiler::Scope scope(&gpuProfiler, "cull");
+        if (!gpuCuller.beginFrame(instances, queue.size(), viewProj)) {
+            return false;
+        }
+
+        size_t bucketEnds[] = {queue.bucketStart(RenderBucket::Transparent),
+                               queue.bucketStart(RenderBucket::SortedTransparent),
+                               queue.size()};
+        size_t i = 0;
+        for (size_t end : bucketEnds) {
+            while (i < end) {
+                size_t runEnd = i + 1;
+                while (runEnd < end && sameState(queue[i], queue[runEnd])) {
+                    ++runEnd;
+                }
+                gpuCuller.cull(i, runEnd - i);
+                i = runEnd;
+            }
+        }
+        gpuCuller.endFrame();
+        return true;
+    }
 
-    static void renderEntity(const Transform& transform, const MeshRenderer& mesh, Shader& shader) {
-        if (mesh.texture1 != 0u) {
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, mesh.texture1);
+    // One upload per frame: every model matrix, in the order the queue will be submitted, then
+    // every uvTransform and texture layer in the same order, written straight into this frame's
+    // region of the instance stream. GPU culling also needs every mesh-space box, last.
+    bool uploadInstances(const RenderQueue& queue, bool withBounds) {
+        size_t count = queue.size();
+        GLsizeiptr bytes =
+            static_cast<GLsizeiptr>(count * (INSTANCE_BYTES + (withBounds ? BOUNDS_BYTES : 0)));
+        instanceStream.beginFrame(bytes);
+        StreamAllocation allocation = instanceStream.allocate(bytes, sizeof(glm::mat4));
+        if (!allocation) {
+            return false;
         }
 
-        glBindVertexArray(mesh.VAO);
+        auto* models = static_cast<glm::mat4*>(allocation.data);
+        auto* uvTransforms = reinterpret_cast<glm::vec4*>(models + count);
+        auto* layers = reinterpret_cast<float*>(uvTransforms + count);
+        for (size_t i = 0; i < count; ++i) {
+            models[i] = queue[i].model;
+            uvTransforms[i] = queue[i].uvTransform;
+            layers[i] = queue[i].layer;
+        }
+        auto* bounds = reinterpret_cast<glm::vec3*>(layers + count);
+        for (size_t i = 0; withBounds && i < count; ++i) {
+            bounds[2 * i] = queue[i].boundsMin;
+            bounds[2 * i + 1] = queue[i].boundsMax;
+        }
+        instanceStream.flush();
+        instances.buffer = allocation.buffer;
+        instances.matrices = allocation.offset;
+        instances.uvTransforms =
+            instances.matrices + static_cast<GLintptr>(count * sizeof(glm::mat4));
+        instances.layers =
+            instances.uvTransforms + static_cast<GLintptr>(count * sizeof(glm::vec4));
+        instances.bounds = instances.layers + static_cast<GLintptr>(count * sizeof(float));
+        return true;
+    }
 
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, transform.position);
-        model = glm::rotate(model, glm::radians(transform.rotation.x), glm::vec3(1, 0, 0));
-        model = glm::rotate(model, glm::radians(transform.rotation.y), glm::vec3(0, 1, 0));
-        model = glm::rotate(model, glm::radians(transform.rotation.z), glm::vec3(0, 0, 1));
-        model = glm::scale(model, transform.scale);
+    // Draw the cascades flagged in the snapshot into their layers, then go back to the back
+    // buffer. Casters of every redrawn cascade share one upload; runs of the same VAO are
+    // instanced.
+    void submitShadows(const ShadowFrame& shadows) {
+        if (!shadows.enabled() || shadows.redrawMask == 0 || shadows.shader == nullptr) {
+            return;
+        }
 
-        shader.setMat4("model", model);
-        glDrawArrays(GL_TRIANGLES, 0, mesh.vertexCount);
+        GLsizeiptr bytes = 0;
+        for (const auto& casters : shadows.casters) {
+            bytes += static_cast<GLsizeiptr>(casters.size() * sizeof(glm::mat4));
+        }
+        shadowInstanceStream.beginFrame(bytes);
+        StreamAllocation allocation = shadowInstanceStream.allocate(bytes, sizeof(glm::mat4));
+        if (bytes > 0 && !allocation) {
+            return;
+        }
+        auto* models = static_cast<glm::mat4*>(allocation.data);
+        for (const auto& casters : shadows.casters) {
+            for (const ShadowCaster& caster : casters) {
+                *models++ = caster.model;
+            }
+        }
+        shadowInstanceStream.flush();
+
+        RenderDevice& device = RenderDevice::current();
+        int viewport[4];
+        device.getViewport(viewport);
+        shadows.shader->use();
+        device.setEnabled(GL_POLYGON_OFFSET_FILL, true);
+        device.polygonOffset(1.5f, 2.0f);
 
-        glBindVertexArray(0);
+        GLintptr offset = allocation.offset;
+        for (int cascade = 0; cascade < CascadedShadowMap::CASCADE_COUNT; ++cascade) {
+            const auto& casters = shadows.casters[cascade];
+            if ((shadows.redrawMask & (1u << cascade)) == 0u ||
+                !shadowMaps.beginCascade(cascade)) {
+                offset += static_cast<GLintptr>(casters.size() * sizeof(glm::mat4));
+                continue;
+            }
+            shadows.shader->setMat4("lightViewProj", shadows.lightViewProj[cascade]);
+
+            size_t i = 0;
+            while (i < casters.size()) {
+                size_t runEnd = i + 1;
+                while (runEnd < casters.size() && casters[runEnd].VAO == casters[i].VAO &&
+                       casters[runEnd].vertexCount == casters[i].vertexCount) {
+                    ++runEnd;
+                }
+                device.bindVertexArray(casters[i].VAO);
+                // The shadow program only reads matrices; the other attributes just need to
+                // point inside the buffer
+                InstanceStreams streams{allocation.buffer, offset, offset, offset};
+                bindInstanceRange(casters[i].VAO, streams, 0);
+                device.drawArraysInstanced(
+                    GL_TRIANGLES, 0, casters[i].vertexCount, static_cast<GLsizei>(runEnd - i));
+                offset += static_cast<GLintptr>((runEnd - i) * sizeof(glm::mat4));
+                i = runEnd;
+            }
+        }
+
+        device.setEnabled(GL_POLYGON_OFFSET_FILL, false);
+        device.bindFramebuffer(0);
+        device.viewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    }
+
+    // GL 3.3 has no base instance, so each run re-points the instance attributes at the data
+    // of its @p first instance: matrix (3..6), texture layer (7) and uvTransform (8). Expects
+    // the VAO to be bound.
+    void bindInstanceRange(unsigned int VAO, const InstanceStreams& streams, size_t first) {
+        bool enabled =
+            std::find(instancedVAOs.begin(), instancedVAOs.end(), VAO) != instancedVAOs.end();
+
+        // Interleaved records share one stride; separate arrays step by their element size
+        GLsizei matrixStride = streams.stride != 0 ? streams.stride : sizeof(glm::mat4);
+        GLsizei layerStride = streams.stride != 0 ? streams.stride : sizeof(float);
+        GLsizei vectorStride = streams.stride != 0 ? streams.stride : sizeof(glm::vec4);
+
+        RenderDevice& device = RenderDevice::current();
+        device.bindBuffer(GL_ARRAY_BUFFER, streams.buffer);
+        size_t matrix = static_cast<size_t>(streams.matrices) + first * matrixStride;
+        for (unsigned int column = 0; column < 4; ++column) {
+            device.vertexAttribPointer(
+                3 + column, 4, GL_FLOAT, false, matrixStride, matrix + column * sizeof(glm::vec4));
+        }
+        device.vertexAttribPointer(7,
+                                   1,
+                                   GL_FLOAT,
+                                   false,
+                                   layerStride,
+                                   static_cast<size_t>(streams.layers) + first * layerStride);
+        device.vertexAttribPointer(
+            8,
+            4,
+            GL_FLOAT,
+            false,
+            vectorStride,
+            static_cast<size_t>(streams.uvTransforms) + first * vectorStride);
+
+        if (!enabled) {
+            for (unsigned int attribute = 3; attribute <= 8; ++attribute) {
+                device.enableVertexAttribArray(attribute);
+                device.vertexAttribDivisor(attribute, 1);
+            }
+            instancedVAOs.push_back(VAO);
+        }
     }
 };
 
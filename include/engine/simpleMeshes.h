@@ -1,5 +1,8 @@
 #pragma once
+#include <cmath>
+#include <vector>
 #include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
 
 // clang-format off
 float CUBE_VERTICES[] = {
@@ -56,4 +59,40 @@ glm::vec3 CUBE_POSITIONS[] = {
     glm::vec3(1.5f, 2.0f, -2.5f),
     glm::vec3(1.5f, 0.2f, -1.5f)
 };
-// clang-format on
\ No newline at end of file
+// clang-format on
+
+// Unit-diameter UV sphere laid out like CUBE_VERTICES (position, normal, uv); fewer segments and
+// rings make the coarser MeshLOD levels of the same shape
+inline std::vector<float> sphereVertices(int segments, int rings) {
+    auto vertex = [&](std::vector<float>& out, int segment, int ring) {
+        float theta = glm::pi<float>() * ring / rings;
+        float phi = glm::two_pi<float>() * segment / segments;
+        glm::vec3 normal(std::sin(theta) * std::cos(phi),
+                         std::cos(theta),
+                         std::sin(theta) * std::sin(phi));
+        glm::vec3 position = normal * 0.5f;
+        out.insert(out.end(),
+                   {position.x,
+                    position.y,
+                    position.z,
+                    normal.x,
+                    normal.y,
+                    normal.z,
+                    float(segment) / segments,
+                    1.0f - float(ring) / rings});
+    };
+    std::vector<float> vertices;
+    vertices.reserve(size_t(segments) * rings * 6 * 8);
+    for (int ring = 0; ring < rings; ++ring) {
+        for (int segment = 0; segment < segments; ++segment) {
+            // Counter-clockwise seen from outside
+            vertex(vertices, segment, ring);
+            vertex(vertices, segment + 1, ring + 1);
+            vertex(vertices, segment, ring + 1);
+            vertex(vertices, segment, ring);
+            vertex(vertices, segment + 1, ring);
+            vertex(vertices, segment + 1, ring + 1);
+        }
+    }
+    return vertices;
+}
@@ -0,0 +1,19 @@
+#version 330 core
+out vec4 FragColor;
+
+// Weighted blended transparency targets, see WeightedTransparency
+uniform sampler2D accumulation; // rgb = sum of color * weight, a = product of (1 - alpha)
+uniform sampler2D weights;      // r = sum of alpha * weight
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec4 accumulated = texelFetch(accumulation, texel, 0);
+    float revealage = accumulated.a;
+    if (revealage >= 1.0) {
+        discard; // Nothing transparent covers this pixel
+    }
+
+    float weight = texelFetch(weights, texel, 0).r;
+    FragColor = vec4(accumulated.rgb / max(weight, 1e-5), 1.0 - revealage);
+}
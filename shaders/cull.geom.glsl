@@ -0,0 +1,26 @@
+#version 330 core
+// Emits the instances cull.vert.glsl found visible; transform feedback packs them together
+layout (points) in;
+layout (points, max_vertices = 1) out;
+
+in mat4 vModel[];
+in vec4 vUVTransform[];
+in float vLayer[];
+flat in int vVisible[];
+
+// Captured interleaved in this order, see GpuCuller::OUTPUT_STRIDE
+out mat4 outModel;
+out vec4 outUVTransform;
+out float outLayer;
+
+void main()
+{
+    if (vVisible[0] == 0) {
+        return;
+    }
+    outModel = vModel[0];
+    outUVTransform = vUVTransform[0];
+    outLayer = vLayer[0];
+    EmitVertex();
+    EndPrimitive();
+}
@@ -0,0 +1,36 @@
+#version 330 core
+// One point per instance, see GpuCuller; the geometry shader keeps the visible ones
+layout (location = 0) in mat4 aModel; // Occupies locations 0..3
+layout (location = 4) in vec4 aUVTransform;
+layout (location = 5) in float aLayer;
+layout (location = 6) in vec3 aBoundsMin; // Mesh space; min > max for unbounded instances
+layout (location = 7) in vec3 aBoundsMax;
+
+uniform vec4 planes[6]; // World-space frustum, inward-facing, see Frustum
+
+out mat4 vModel;
+out vec4 vUVTransform;
+out float vLayer;
+flat out int vVisible;
+
+void main()
+{
+    vModel = aModel;
+    vUVTransform = aUVTransform;
+    vLayer = aLayer;
+    vVisible = 1;
+    if (any(greaterThan(aBoundsMin, aBoundsMax))) {
+        return;
+    }
+
+    // World box of the transformed mesh box (Arvo), same test as FrustumCuller
+    vec3 center = vec3(aModel * vec4((aBoundsMin + aBoundsMax) * 0.5, 1.0));
+    vec3 halfSize = (aBoundsMax - aBoundsMin) * 0.5;
+    vec3 extents = mat3(abs(aModel[0].xyz), abs(aModel[1].xyz), abs(aModel[2].xyz)) * halfSize;
+    for (int i = 0; i < 6; ++i) {
+        float distance = dot(planes[i].xyz, center) + planes[i].w;
+        if (distance + dot(abs(planes[i].xyz), extents) < 0.0) {
+            vVisible = 0;
+        }
+    }
+}
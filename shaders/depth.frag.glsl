@@ -0,0 +1,6 @@
+#version 330 core
+
+// Depth only, color writes are masked during the prepass
+void main()
+{
+}
@@ -0,0 +1,22 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 3) in mat4 aInstanceModel; // Per-instance, occupies locations 3..6
+
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    vec4 time;
+};
+
+uniform mat4 model;
+uniform bool instanced;
+
+// Must match shader.vert.glsl bit for bit, the color pass tests depth with GL_EQUAL
+invariant gl_Position;
+
+void main()
+{
+    mat4 world = instanced ? aInstanceModel : model;
+    gl_Position = projection * view * world * vec4(aPos, 1.0f);
+}
@@ -0,0 +1,15 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 Corner;
+in vec4 Color;
+
+uniform sampler2D texture1;
+uniform bool textured; // Otherwise a soft round dot
+
+void main()
+{
+    float disc = 1.0 - smoothstep(0.25, 0.5, length(Corner - 0.5));
+    vec4 sprite = textured ? texture(texture1, Corner) : vec4(1.0, 1.0, 1.0, disc);
+    FragColor = Color * sprite;
+}
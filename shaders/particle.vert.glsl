@@ -0,0 +1,32 @@
+#version 330 core
+layout (location = 0) in vec2 aCorner; // Quad corner, -0.5..0.5
+// Per-instance columns of a ParticleFrame, one float each, then its RGBA8 color
+layout (location = 1) in float aX;
+layout (location = 2) in float aY;
+layout (location = 3) in float aZ;
+layout (location = 4) in float aLife;
+layout (location = 5) in vec4 aColor;
+
+out vec2 Corner;
+out vec4 Color;
+
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    vec4 time; // x = elapsed, y = delta
+};
+
+uniform float size;     // Billboard edge, world units
+uniform float fadeTime; // Seconds of life over which particles fade out
+
+void main()
+{
+    // Camera right and up are the first two rows of the view rotation
+    vec3 right = vec3(view[0][0], view[1][0], view[2][0]);
+    vec3 up = vec3(view[0][1], view[1][1], view[2][1]);
+    vec3 position = vec3(aX, aY, aZ) + (right * aCorner.x + up * aCorner.y) * size;
+    gl_Position = projection * view * vec4(position, 1.0);
+    Corner = aCorner + 0.5;
+    Color = vec4(aColor.rgb, aColor.a * clamp(aLife / fadeTime, 0.0, 1.0));
+}
@@ -1,12 +1,141 @@
 #version 330 core
-out vec4 FragColor;
-  
+#pragma features TEXTURE_ARRAY
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec4 Weight; // Only written to by the weighted transparency pass
+
 in vec3 ourColor;
 in vec2 TexCoord;
+in vec3 ViewPosition;
+flat in float Layer;
 
+#ifdef TEXTURE_ARRAY
+uniform sampler2DArray textureLayers; // Same-size textures packed together, see TextureArrayPool
+#else
 uniform sampler2D texture1;
+#endif
+uniform float opacity;      // Multiplies the texture's alpha
+uniform bool weightedBlend; // Output for WeightedTransparency instead of plain color
+
+// Clustered lights, see LightClusterGrid / LightBuffers
+uniform usamplerBuffer lightClusters; // (offset, count) per cluster
+uniform usamplerBuffer lightIndices;  // light indices of every cluster, back to back
+uniform samplerBuffer lights;         // 3 texels per light, view space
+
+layout (std140) uniform LightGrid {
+    ivec4 gridSize;  // xyz = clusters per axis, w = directional light count
+    vec4 gridScale;  // xy = clusters per pixel, z/w = depth slice scale/bias
+    vec4 ambient;
+};
+
+// Cascaded shadows of one directional light, see CascadedShadowMap / ShadowMaps
+uniform sampler2DArrayShadow shadowMap;
+
+layout (std140) uniform ShadowData {
+    mat4 cascades[4];   // view space -> shadow map coordinates and depth
+    vec4 cascadeSplits; // view depth where each cascade ends
+    vec4 texelSizes;    // world size of a shadow map texel per cascade
+    ivec4 shadowParams; // x = shadowed light index (-1 for none), y = cascade count
+    vec4 shadowBias;    // x = depth bias, y = texel size in texture space, z = normal offset
+};
+
+float shadowFactor(vec3 position, vec3 normal)
+{
+    float depth = -position.z;
+    int last = shadowParams.y - 1;
+    if (depth > cascadeSplits[last]) {
+        return 1.0;
+    }
+    int cascade = 0;
+    while (cascade < last && depth > cascadeSplits[cascade]) {
+        ++cascade;
+    }
+
+    // Push the lookup off the surface by a few texels to keep self-shadowing acne away
+    vec3 offset = normal * texelSizes[cascade] * shadowBias.z;
+    vec3 coord = (cascades[cascade] * vec4(position + offset, 1.0)).xyz;
+    if (any(lessThan(coord.xy, vec2(0.0))) || any(greaterThan(coord.xy, vec2(1.0)))) {
+        return 1.0;
+    }
+
+    // 3x3 taps, each already a bilinear 2x2 comparison
+    float reference = coord.z - shadowBias.x;
+    float lit = 0.0;
+    for (int y = -1; y <= 1; ++y) {
+        for (int x = -1; x <= 1; ++x) {
+            vec2 uv = coord.xy + vec2(x, y) * shadowBias.y;
+            lit += texture(shadowMap, vec4(uv, float(cascade), reference));
+        }
+    }
+    return lit / 9.0;
+}
+
+vec3 shadeLight(int index, vec3 position, vec3 normal, vec3 viewDir)
+{
+    vec4 positionRange = texelFetch(lights, index * 3);
+    vec4 colorInnerCos = texelFetch(lights, index * 3 + 1);
+    vec4 directionOuterCos = texelFetch(lights, index * 3 + 2);
+
+    vec3 toLight = -directionOuterCos.xyz;
+    float attenuation = 1.0;
+    if (positionRange.w > 0.0) {
+        toLight = positionRange.xyz - position;
+        float distance = length(toLight);
+        toLight /= max(distance, 0.0001);
+        // Smooth window reaching zero at the range, times inverse square
+        float window = clamp(1.0 - pow(distance / positionRange.w, 4.0), 0.0, 1.0);
+        attenuation = window * window / (distance * distance + 1.0);
+        attenuation *= smoothstep(directionOuterCos.w, colorInnerCos.w,
+                                  dot(-toLight, directionOuterCos.xyz));
+    }
+
+    float diffuse = max(dot(normal, toLight), 0.0);
+    float specular = pow(max(dot(normal, normalize(toLight + viewDir)), 0.0), 32.0) * 0.25;
+    return colorInnerCos.rgb * (diffuse + specular * step(0.0, diffuse)) * attenuation;
+}
 
 void main()
 {
-    FragColor = texture(texture1, TexCoord);
-}
\ No newline at end of file
+#ifdef TEXTURE_ARRAY
+    vec4 albedo = texture(textureLayers, vec3(TexCoord, Layer));
+#else
+    vec4 albedo = texture(texture1, TexCoord);
+#endif
+
+    // Meshes carry no normals; the face normal comes from the view-space position derivatives
+    vec3 normal = normalize(cross(dFdx(ViewPosition), dFdy(ViewPosition)));
+    vec3 viewDir = normalize(-ViewPosition);
+
+    vec3 light = ambient.rgb;
+    for (int i = 0; i < gridSize.w; ++i) {
+        vec3 contribution = shadeLight(i, ViewPosition, normal, viewDir);
+        if (i == shadowParams.x) {
+            contribution *= shadowFactor(ViewPosition, normal);
+        }
+        light += contribution;
+    }
+
+    ivec3 cell = ivec3(ivec2(gl_FragCoord.xy * gridScale.xy),
+                       int(log(max(-ViewPosition.z, 0.0001)) * gridScale.z + gridScale.w));
+    cell = clamp(cell, ivec3(0), max(gridSize.xyz - 1, ivec3(0)));
+    int cluster = cell.x + gridSize.x * (cell.y + gridSize.y * cell.z);
+    uvec2 range = texelFetch(lightClusters, cluster).xy;
+    for (uint i = 0u; i < range.y; ++i) {
+        int index = int(texelFetch(lightIndices, int(range.x + i)).x);
+        light += shadeLight(index, ViewPosition, normal, viewDir);
+    }
+
+    vec3 color = albedo.rgb * light;
+    float alpha = albedo.a * opacity;
+    if (!weightedBlend) {
+        FragColor = vec4(color, alpha);
+        return;
+    }
+
+    // Nearer and more opaque surfaces weigh more (McGuire & Bavoil, equation 7); the color sum
+    // is added, while alpha multiplies into how much of the background stays revealed
+    float depth = -ViewPosition.z;
+    float weight = alpha * clamp(10.0 / (1e-5 + pow(depth / 5.0, 2.0) + pow(depth / 200.0, 6.0)),
+                                 1e-2, 3e3);
+    FragColor = vec4(color * alpha * weight, alpha);
+    Weight = vec4(alpha * weight);
+}
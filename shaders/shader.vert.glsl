@@ -2,18 +2,38 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aColor;
 layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in mat4 aInstanceModel; // Per-instance, occupies locations 3..6
+layout (location = 7) in float aLayer;         // Per-instance layer of textureLayers
+layout (location = 8) in vec4 aUVTransform;    // Per-instance atlas region, see TextureAtlas
 
 out vec3 ourColor;
 out vec2 TexCoord;
+out vec3 ViewPosition;
+flat out float Layer;
+
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    vec4 time; // x = elapsed, y = delta
+};
 
 // uniform mat4 transform;
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform bool instanced;
+uniform float layer;      // aLayer when not instanced
+uniform vec4 uvTransform; // aUVTransform when not instanced
+
+// Same position as depth.vert.glsl, so the depth prepass can be tested with GL_EQUAL
+invariant gl_Position;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0f);
+    mat4 world = instanced ? aInstanceModel : model;
+    gl_Position = projection * view * world * vec4(aPos, 1.0f);
+    ViewPosition = vec3(view * world * vec4(aPos, 1.0f));
     // ourColor = aColor;
-    TexCoord = vec2(aTexCoord.x, aTexCoord.y);
-}
\ No newline at end of file
+    vec4 region = instanced ? aUVTransform : uvTransform;
+    TexCoord = aTexCoord * region.xy + region.zw;
+    Layer = instanced ? aLayer : layer;
+}
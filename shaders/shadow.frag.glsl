@@ -0,0 +1,6 @@
+#version 330 core
+
+// Depth only, the cascade framebuffer has no color attachment
+void main()
+{
+}
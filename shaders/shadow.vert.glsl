@@ -0,0 +1,10 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 3) in mat4 aInstanceModel; // Per-instance, occupies locations 3..6
+
+uniform mat4 lightViewProj;
+
+void main()
+{
+    gl_Position = lightViewProj * aInstanceModel * vec4(aPos, 1.0f);
+}
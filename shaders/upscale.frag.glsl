@@ -0,0 +1,33 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+// Scene drawn at a reduced resolution, see SceneTarget
+uniform sampler2D sceneColor;
+uniform vec2 sourceSize;   // Pixels drawn this frame
+uniform vec2 textureScale; // Drawn region over the texture size
+uniform float sharpness;   // 0 = plain bilinear
+
+void main()
+{
+    // Taps stay inside the drawn region, the rest of the texture holds older frames
+    vec2 texel = textureScale / sourceSize;
+    vec2 low = texel * 0.5;
+    vec2 high = textureScale - texel * 0.5;
+    vec2 uv = clamp(TexCoord * textureScale, low, high);
+    vec3 center = texture(sceneColor, uv).rgb;
+    if (sharpness <= 0.0) {
+        FragColor = vec4(center, 1.0);
+        return;
+    }
+
+    // Unsharp mask: push each pixel away from the average of its neighbours, restoring some of
+    // the edge contrast bilinear filtering smooths out
+    vec3 neighbours = texture(sceneColor, clamp(uv + vec2(texel.x, 0.0), low, high)).rgb +
+                      texture(sceneColor, clamp(uv - vec2(texel.x, 0.0), low, high)).rgb +
+                      texture(sceneColor, clamp(uv + vec2(0.0, texel.y), low, high)).rgb +
+                      texture(sceneColor, clamp(uv - vec2(0.0, texel.y), low, high)).rgb;
+    vec3 sharpened = center + (center - neighbours * 0.25) * sharpness;
+    FragColor = vec4(clamp(sharpened, 0.0, 1.0), 1.0);
+}
@@ -0,0 +1,488 @@
+#include "engine/ClusteredLighting.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <engine/RenderDevice.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+constexpr float INFINITE = std::numeric_limits<float>::infinity();
+
+int countTrailingZeros(unsigned int value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(value);
+#else
+    int bits = 0;
+    while ((value & 1u) == 0u) {
+        value >>= 1;
+        ++bits;
+    }
+    return bits;
+#endif
+}
+
+/// Append the indices of the set bits of @p mask, lane 0 being @p base
+size_t emitMask(unsigned int mask, size_t base, uint32_t* out) {
+    size_t written = 0;
+    while (mask != 0) {
+        int lane = countTrailingZeros(mask);
+        mask &= mask - 1;
+        out[written++] = static_cast<uint32_t>(base + lane);
+    }
+    return written;
+}
+
+void encloseBox(glm::vec3& min, glm::vec3& max, glm::vec3& center, float& radius) {
+    center = (min + max) * 0.5f;
+    radius = glm::length(max - center);
+}
+} // namespace
+
+// --- Light columns ---
+void LightClusterGrid::LightColumns::clear() {
+    for (auto* column : {&x, &y, &z, &range, &dirX, &dirY, &dirZ, &cosAngle, &sinAngle, &back}) {
+        column->clear();
+    }
+    ids.clear();
+    count = 0;
+}
+
+void LightClusterGrid::LightColumns::push(const LightColumns& from, size_t index) {
+    x.push_back(from.x[index]);
+    y.push_back(from.y[index]);
+    z.push_back(from.z[index]);
+    range.push_back(from.range[index]);
+    dirX.push_back(from.dirX[index]);
+    dirY.push_back(from.dirY[index]);
+    dirZ.push_back(from.dirZ[index]);
+    cosAngle.push_back(from.cosAngle[index]);
+    sinAngle.push_back(from.sinAngle[index]);
+    back.push_back(from.back[index]);
+    ids.push_back(from.ids[index]);
+    ++count;
+}
+
+// Padding lights have a NaN range, so the range comparison of the sphere test always fails
+// (a NaN position wouldn't do: max() with NaN returns the other operand on SSE)
+void LightClusterGrid::LightColumns::pad() {
+    size_t padded = (count + LANES - 1) / LANES * LANES;
+    x.resize(padded, 0.0f);
+    y.resize(padded, 0.0f);
+    z.resize(padded, 0.0f);
+    range.resize(padded, NAN);
+    dirX.resize(padded, 0.0f);
+    dirY.resize(padded, 0.0f);
+    dirZ.resize(padded, 0.0f);
+    cosAngle.resize(padded, -1.0f);
+    sinAngle.resize(padded, 0.0f);
+    back.resize(padded, INFINITE);
+    ids.resize(padded, 0);
+}
+
+// --- Grid ---
+void LightClusterGrid::setProjection(const glm::mat4& projection, float nearPlane, float farPlane) {
+    if (!bounds.empty() && projection == this->projection && nearPlane == this->nearPlane &&
+        farPlane == this->farPlane) {
+        return;
+    }
+    this->projection = projection;
+    this->nearPlane = nearPlane;
+    this->farPlane = farPlane;
+
+    float logRatio = std::log(farPlane / nearPlane);
+    sliceScale = GRID_Z / logRatio;
+    sliceBias = -GRID_Z * std::log(nearPlane) / logRatio;
+    sliceDepths.resize(GRID_Z + 1);
+    for (int slice = 0; slice <= GRID_Z; ++slice) {
+        sliceDepths[slice] = nearPlane * std::pow(farPlane / nearPlane, float(slice) / GRID_Z);
+    }
+
+    // Tile corners on the near plane, then pushed along their eye rays to each slice's depths
+    glm::mat4 inverse = glm::inverse(projection);
+    auto cornerRay = [&](int x, int y) {
+        glm::vec4 ndc(-1.0f + 2.0f * x / GRID_X, -1.0f + 2.0f * y / GRID_Y, -1.0f, 1.0f);
+        glm::vec4 point = inverse * ndc;
+        glm::vec3 view = glm::vec3(point) / point.w;
+        return view / -view.z; // Point at depth 1
+    };
+
+    bounds.resize(CLUSTER_COUNT);
+    rowBounds.resize(GRID_Y * GRID_Z);
+    for (int z = 0; z < GRID_Z; ++z) {
+        for (int y = 0; y < GRID_Y; ++y) {
+            ClusterBounds& row = rowBounds[y + GRID_Y * z];
+            row.min = glm::vec3(INFINITE);
+            row.max = glm::vec3(-INFINITE);
+            for (int x = 0; x < GRID_X; ++x) {
+                glm::vec3 rays[4] = {cornerRay(x, y),
+                                     cornerRay(x + 1, y),
+                                     cornerRay(x, y + 1),
+                                     cornerRay(x + 1, y + 1)};
+                ClusterBounds& cluster = bounds[x + GRID_X * (y + GRID_Y * z)];
+                cluster.min = glm::vec3(INFINITE);
+                cluster.max = glm::vec3(-INFINITE);
+                for (float depth : {sliceDepths[z], sliceDepths[z + 1]}) {
+                    for (const glm::vec3& ray : rays) {
+                        cluster.min = glm::min(cluster.min, ray * depth);
+                        cluster.max = glm::max(cluster.max, ray * depth);
+                    }
+                }
+                encloseBox(cluster.min, cluster.max, cluster.center, cluster.radius);
+                row.min = glm::min(row.min, cluster.min);
+                row.max = glm::max(row.max, cluster.max);
+            }
+            encloseBox(row.min, row.max, row.center, row.radius);
+        }
+    }
+}
+
+void LightClusterGrid::assign(const std::vector<GPULight>& lights,
+                              std::vector<uint32_t>& clusters,
+                              std::vector<uint32_t>& indices,
+                              JobSystem* jobs) {
+    lightColumns.clear();
+    for (size_t i = 0; i < lights.size(); ++i) {
+        const GPULight& light = lights[i];
+        float range = light.positionRange.w;
+        if (range <= 0.0f) {
+            continue;
+        }
+        lightColumns.x.push_back(light.positionRange.x);
+        lightColumns.y.push_back(light.positionRange.y);
+        lightColumns.z.push_back(light.positionRange.z);
+        lightColumns.range.push_back(range);
+
+        float cosOuter = light.directionOuterCos.w;
+        bool spot = cosOuter >= -1.0f;
+        glm::vec3 direction = spot ? glm::vec3(light.directionOuterCos) : glm::vec3(0.0f);
+        lightColumns.dirX.push_back(direction.x);
+        lightColumns.dirY.push_back(direction.y);
+        lightColumns.dirZ.push_back(direction.z);
+        lightColumns.cosAngle.push_back(spot ? cosOuter : -1.0f);
+        lightColumns.sinAngle.push_back(spot ? std::sqrt(1.0f - cosOuter * cosOuter) : 0.0f);
+        // The back test only holds for cones narrower than a half space
+        lightColumns.back.push_back(spot && cosOuter >= 0.0f ? 0.0f : INFINITE);
+        lightColumns.ids.push_back(static_cast<uint32_t>(i));
+        ++lightColumns.count;
+    }
+
+    slices.resize(GRID_Z);
+    auto assignSlices = [&](size_t begin, size_t end) {
+        for (size_t slice = begin; slice < end; ++slice) {
+            assignSlice(static_cast<int>(slice));
+        }
+    };
+    if (jobs != nullptr) {
+        jobs->parallelFor(GRID_Z, 1, assignSlices);
+    } else {
+        assignSlices(0, GRID_Z);
+    }
+
+    // Join the per-slice lists; slices are contiguous in cluster order
+    clusters.resize(CLUSTER_COUNT * 2);
+    indices.clear();
+    uint32_t offset = 0;
+    for (int slice = 0; slice < GRID_Z; ++slice) {
+        const SliceWork& work = slices[slice];
+        for (int tile = 0; tile < GRID_X * GRID_Y; ++tile) {
+            size_t cluster = static_cast<size_t>(slice) * GRID_X * GRID_Y + tile;
+            clusters[cluster * 2] = offset;
+            clusters[cluster * 2 + 1] = work.counts[tile];
+            offset += work.counts[tile];
+        }
+        indices.insert(indices.end(), work.indices.begin(), work.indices.end());
+    }
+}
+
+void LightClusterGrid::assignSlice(int slice) {
+    SliceWork& work = slices[slice];
+    work.candidates.clear();
+    work.indices.clear();
+
+    // Only lights reaching this slice's depth range take part in the per-cluster tests
+    float nearDepth = sliceDepths[slice];
+    float farDepth = sliceDepths[slice + 1];
+    for (size_t i = 0; i < lightColumns.count; ++i) {
+        float depth = -lightColumns.z[i];
+        float range = lightColumns.range[i];
+        if (depth + range >= nearDepth && depth - range <= farDepth) {
+            work.candidates.push(lightColumns, i);
+        }
+    }
+    work.candidates.pad();
+    if (work.candidates.count == 0) {
+        std::fill(std::begin(work.counts), std::end(work.counts), 0u);
+        return;
+    }
+
+    // Narrow down to each row of tiles first, then test the row's clusters
+    for (int y = 0; y < GRID_Y; ++y) {
+        work.hits.resize(work.candidates.x.size());
+        size_t rowHits = testCluster(
+            rowBounds[y + GRID_Y * slice], work.candidates, work.hits.data());
+        work.rowCandidates.clear();
+        for (size_t i = 0; i < rowHits; ++i) {
+            work.rowCandidates.push(work.candidates, work.hits[i]);
+        }
+        work.rowCandidates.pad();
+
+        for (int x = 0; x < GRID_X; ++x) {
+            int tile = x + GRID_X * y;
+            size_t written = 0;
+            if (rowHits > 0) {
+                const ClusterBounds& cluster = bounds[tile + slice * GRID_X * GRID_Y];
+                written = testCluster(cluster, work.rowCandidates, work.hits.data());
+                for (size_t i = 0; i < written; ++i) {
+                    work.indices.push_back(work.rowCandidates.ids[work.hits[i]]);
+                }
+            }
+            work.counts[tile] = static_cast<uint32_t>(written);
+        }
+    }
+}
+
+// Sphere vs box: squared distance from the light to the box within range squared.
+// Cone vs sphere (spot lights), with v from the light to the cluster sphere center:
+// outside if cos * |v x dir| - sin * (v . dir) > radius, or beyond the range, or behind.
+size_t LightClusterGrid::testCluster(const ClusterBounds& cluster,
+                                     const LightColumns& lights,
+                                     uint32_t* out) {
+    size_t written = 0;
+    size_t padded = lights.x.size();
+
+#if defined(__AVX__)
+    __m256 minX = _mm256_set1_ps(cluster.min.x), maxX = _mm256_set1_ps(cluster.max.x);
+    __m256 minY = _mm256_set1_ps(cluster.min.y), maxY = _mm256_set1_ps(cluster.max.y);
+    __m256 minZ = _mm256_set1_ps(cluster.min.z), maxZ = _mm256_set1_ps(cluster.max.z);
+    __m256 centerX = _mm256_set1_ps(cluster.center.x);
+    __m256 centerY = _mm256_set1_ps(cluster.center.y);
+    __m256 centerZ = _mm256_set1_ps(cluster.center.z);
+    __m256 radius = _mm256_set1_ps(cluster.radius);
+    __m256 zero = _mm256_setzero_ps();
+
+    for (size_t i = 0; i < padded; i += 8) {
+        __m256 x = _mm256_loadu_ps(&lights.x[i]);
+        __m256 y = _mm256_loadu_ps(&lights.y[i]);
+        __m256 z = _mm256_loadu_ps(&lights.z[i]);
+        __m256 range = _mm256_loadu_ps(&lights.range[i]);
+
+        __m256 dx = _mm256_max_ps(_mm256_sub_ps(minX, x), _mm256_sub_ps(x, maxX));
+        __m256 dy = _mm256_max_ps(_mm256_sub_ps(minY, y), _mm256_sub_ps(y, maxY));
+        __m256 dz = _mm256_max_ps(_mm256_sub_ps(minZ, z), _mm256_sub_ps(z, maxZ));
+        dx = _mm256_max_ps(dx, zero);
+        dy = _mm256_max_ps(dy, zero);
+        dz = _mm256_max_ps(dz, zero);
+        __m256 distanceSq = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+        // Ordered compare: false for the NaN padding range
+        __m256 hit = _mm256_cmp_ps(distanceSq, _mm256_mul_ps(range, range), _CMP_LE_OQ);
+        if (_mm256_movemask_ps(hit) == 0) {
+            continue;
+        }
+
+        __m256 vx = _mm256_sub_ps(centerX, x);
+        __m256 vy = _mm256_sub_ps(centerY, y);
+        __m256 vz = _mm256_sub_ps(centerZ, z);
+        __m256 lengthSq = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(vz, vz));
+        __m256 along = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(vx, _mm256_loadu_ps(&lights.dirX[i])),
+                          _mm256_mul_ps(vy, _mm256_loadu_ps(&lights.dirY[i]))),
+            _mm256_mul_ps(vz, _mm256_loadu_ps(&lights.dirZ[i])));
+        __m256 acrossSq = _mm256_sub_ps(lengthSq, _mm256_mul_ps(along, along));
+        __m256 across = _mm256_sqrt_ps(_mm256_max_ps(acrossSq, zero));
+        __m256 closest = _mm256_sub_ps(_mm256_mul_ps(_mm256_loadu_ps(&lights.cosAngle[i]), across),
+                                       _mm256_mul_ps(along, _mm256_loadu_ps(&lights.sinAngle[i])));
+        __m256 behind =
+            _mm256_add_ps(along, _mm256_add_ps(radius, _mm256_loadu_ps(&lights.back[i])));
+        __m256 outside = _mm256_or_ps(
+            _mm256_or_ps(_mm256_cmp_ps(closest, radius, _CMP_GT_OQ),
+                         _mm256_cmp_ps(along, _mm256_add_ps(radius, range), _CMP_GT_OQ)),
+            _mm256_cmp_ps(behind, zero, _CMP_LT_OQ));
+        int mask = _mm256_movemask_ps(_mm256_andnot_ps(outside, hit));
+        written += emitMask(static_cast<unsigned int>(mask), i, out + written);
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    __m128 minX = _mm_set1_ps(cluster.min.x), maxX = _mm_set1_ps(cluster.max.x);
+    __m128 minY = _mm_set1_ps(cluster.min.y), maxY = _mm_set1_ps(cluster.max.y);
+    __m128 minZ = _mm_set1_ps(cluster.min.z), maxZ = _mm_set1_ps(cluster.max.z);
+    __m128 centerX = _mm_set1_ps(cluster.center.x);
+    __m128 centerY = _mm_set1_ps(cluster.center.y);
+    __m128 centerZ = _mm_set1_ps(cluster.center.z);
+    __m128 radius = _mm_set1_ps(cluster.radius);
+    __m128 zero = _mm_setzero_ps();
+
+    for (size_t i = 0; i < padded; i += 4) {
+        __m128 x = _mm_loadu_ps(&lights.x[i]);
+        __m128 y = _mm_loadu_ps(&lights.y[i]);
+        __m128 z = _mm_loadu_ps(&lights.z[i]);
+        __m128 range = _mm_loadu_ps(&lights.range[i]);
+
+        __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minX, x), _mm_sub_ps(x, maxX)), zero);
+        __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minY, y), _mm_sub_ps(y, maxY)), zero);
+        __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minZ, z), _mm_sub_ps(z, maxZ)), zero);
+        __m128 distanceSq =
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        // Ordered compare: false for the NaN padding range
+        __m128 hit = _mm_cmple_ps(distanceSq, _mm_mul_ps(range, range));
+        if (_mm_movemask_ps(hit) == 0) {
+            continue;
+        }
+
+        __m128 vx = _mm_sub_ps(centerX, x);
+        __m128 vy = _mm_sub_ps(centerY, y);
+        __m128 vz = _mm_sub_ps(centerZ, z);
+        __m128 lengthSq =
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+        __m128 along = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, _mm_loadu_ps(&lights.dirX[i])),
+                                             _mm_mul_ps(vy, _mm_loadu_ps(&lights.dirY[i]))),
+                                  _mm_mul_ps(vz, _mm_loadu_ps(&lights.dirZ[i])));
+        __m128 acrossSq = _mm_sub_ps(lengthSq, _mm_mul_ps(along, along));
+        __m128 across = _mm_sqrt_ps(_mm_max_ps(acrossSq, zero));
+        __m128 closest = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(&lights.cosAngle[i]), across),
+                                    _mm_mul_ps(along, _mm_loadu_ps(&lights.sinAngle[i])));
+        __m128 behind = _mm_add_ps(along, _mm_add_ps(radius, _mm_loadu_ps(&lights.back[i])));
+        __m128 outside = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(closest, radius),
+                                             _mm_cmpgt_ps(along, _mm_add_ps(radius, range))),
+                                   _mm_cmplt_ps(behind, zero));
+        int mask = _mm_movemask_ps(_mm_andnot_ps(outside, hit));
+        written += emitMask(static_cast<unsigned int>(mask), i, out + written);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    float32x4_t zero = vdupq_n_f32(0.0f);
+    float32x4_t radius = vdupq_n_f32(cluster.radius);
+    for (size_t i = 0; i < padded; i += 4) {
+        float32x4_t x = vld1q_f32(&lights.x[i]);
+        float32x4_t y = vld1q_f32(&lights.y[i]);
+        float32x4_t z = vld1q_f32(&lights.z[i]);
+        float32x4_t range = vld1q_f32(&lights.range[i]);
+
+        float32x4_t dx = vmaxq_f32(vmaxq_f32(vsubq_f32(vdupq_n_f32(cluster.min.x), x),
+                                             vsubq_f32(x, vdupq_n_f32(cluster.max.x))),
+                                   zero);
+        float32x4_t dy = vmaxq_f32(vmaxq_f32(vsubq_f32(vdupq_n_f32(cluster.min.y), y),
+                                             vsubq_f32(y, vdupq_n_f32(cluster.max.y))),
+                                   zero);
+        float32x4_t dz = vmaxq_f32(vmaxq_f32(vsubq_f32(vdupq_n_f32(cluster.min.z), z),
+                                             vsubq_f32(z, vdupq_n_f32(cluster.max.z))),
+                                   zero);
+        float32x4_t distanceSq = vmlaq_f32(vmlaq_f32(vmulq_f32(dx, dx), dy, dy), dz, dz);
+        // "<=" is false for the NaN padding range
+        uint32x4_t hit = vcleq_f32(distanceSq, vmulq_f32(range, range));
+        if (vmaxvq_u32(hit) == 0) {
+            continue;
+        }
+
+        float32x4_t vx = vsubq_f32(vdupq_n_f32(cluster.center.x), x);
+        float32x4_t vy = vsubq_f32(vdupq_n_f32(cluster.center.y), y);
+        float32x4_t vz = vsubq_f32(vdupq_n_f32(cluster.center.z), z);
+        float32x4_t lengthSq = vmlaq_f32(vmlaq_f32(vmulq_f32(vx, vx), vy, vy), vz, vz);
+        float32x4_t along = vmlaq_f32(vmlaq_f32(vmulq_f32(vx, vld1q_f32(&lights.dirX[i])),
+                                                vy,
+                                                vld1q_f32(&lights.dirY[i])),
+                                      vz,
+                                      vld1q_f32(&lights.dirZ[i]));
+        float32x4_t across = vsqrtq_f32(vmaxq_f32(vmlsq_f32(lengthSq, along, along), zero));
+        float32x4_t closest = vmlsq_f32(vmulq_f32(vld1q_f32(&lights.cosAngle[i]), across),
+                                        along,
+                                        vld1q_f32(&lights.sinAngle[i]));
+        uint32x4_t outside = vorrq_u32(
+            vorrq_u32(vcgtq_f32(closest, radius), vcgtq_f32(along, vaddq_f32(radius, range))),
+            vcltq_f32(vaddq_f32(along, vaddq_f32(radius, vld1q_f32(&lights.back[i]))), zero));
+        uint32x4_t inside = vbicq_u32(hit, outside);
+        unsigned int mask = (vgetq_lane_u32(inside, 0) & 1) | (vgetq_lane_u32(inside, 1) & 2) |
+                            (vgetq_lane_u32(inside, 2) & 4) | (vgetq_lane_u32(inside, 3) & 8);
+        written += emitMask(mask, i, out + written);
+    }
+#else
+    for (size_t i = 0; i < padded; ++i) {
+        glm::vec3 position(lights.x[i], lights.y[i], lights.z[i]);
+        glm::vec3 delta = glm::max(glm::max(cluster.min - position, position - cluster.max), 0.0f);
+        float range = lights.range[i];
+        // "<=" is false for the NaN padding range
+        if (!(glm::dot(delta, delta) <= range * range)) {
+            continue;
+        }
+
+        glm::vec3 v = cluster.center - position;
+        float along = glm::dot(v, glm::vec3(lights.dirX[i], lights.dirY[i], lights.dirZ[i]));
+        float across = std::sqrt(std::max(glm::dot(v, v) - along * along, 0.0f));
+        float closest = lights.cosAngle[i] * across - along * lights.sinAngle[i];
+        if (closest > cluster.radius || along > cluster.radius + range ||
+            along + cluster.radius + lights.back[i] < 0.0f) {
+            continue;
+        }
+        out[written++] = static_cast<uint32_t>(i);
+    }
+#endif
+    return written;
+}
+
+// --- GPU buffers ---
+void LightBuffers::BufferTexture::upload(const void* data, GLsizeiptr size) {
+    RenderDevice& device = RenderDevice::current();
+    if (texture == 0) {
+        texture = device.createTexture();
+    }
+
+    // Never empty, so the texture always has storage to view
+    GLsizeiptr capacity = std::max<GLsizeiptr>(size, 16);
+    stream.beginFrame(capacity);
+    StreamAllocation allocation = stream.allocate(capacity);
+    if (allocation && size > 0) {
+        std::memcpy(allocation.data, data, static_cast<size_t>(size));
+    }
+    stream.flush();
+
+    if (attached != stream.getBuffer()) {
+        attached = stream.getBuffer();
+        device.texBuffer(unit, texture, format, attached);
+    } else {
+        device.bindTexture(unit, GL_TEXTURE_BUFFER, texture);
+    }
+}
+
+void LightBuffers::BufferTexture::release() {
+    if (texture != 0) {
+        RenderDevice::current().deleteTexture(texture);
+        texture = 0;
+    }
+    attached = 0;
+    stream.release();
+}
+
+void LightBuffers::update(const LightFrame& frame) {
+    clusters.upload(frame.clusters.data(), frame.clusters.size() * sizeof(uint32_t));
+    indices.upload(frame.indices.data(), frame.indices.size() * sizeof(uint32_t));
+    lights.upload(frame.lights.data(), frame.lights.size() * sizeof(GPULight));
+
+    RenderDevice& device = RenderDevice::current();
+    if (alignment == 0) {
+        alignment = std::max(device.getInteger(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT), 1);
+    }
+    gridUniforms.beginFrame(sizeof(LightGridData) + alignment);
+    StreamAllocation allocation = gridUniforms.allocate(sizeof(LightGridData), alignment);
+    if (!allocation) {
+        return;
+    }
+    std::memcpy(allocation.data, &frame.grid, sizeof(LightGridData));
+    gridUniforms.flush();
+    device.bindBufferRange(
+        GL_UNIFORM_BUFFER, BINDING, allocation.buffer, allocation.offset, sizeof(LightGridData));
+}
+
+void LightBuffers::release() {
+    clusters.release();
+    indices.release();
+    lights.release();
+    gridUniforms.release();
+}
@@ -0,0 +1,72 @@
+#include "engine/DepthPrepass.h"
+
+#include <engine/RenderDevice.h>
+
+namespace {
+constexpr float SMOOTHING = 0.1f; ///< Weight of each new result in the running average
+} // namespace
+
+void OverdrawMonitor::collect() {
+    // Oldest first, so the smoothing sees frames in order
+    RenderDevice& device = RenderDevice::current();
+    for (int i = 0; i < LATENCY; ++i) {
+        Slot& slot = slots[(next + i) % LATENCY];
+        uint64_t samples = 0;
+        if (!slot.pending || !device.queryResult(slot.query, samples)) {
+            continue;
+        }
+        slot.pending = false;
+        if (slot.pixels == 0) {
+            continue;
+        }
+
+        float sample = float(samples) / float(slot.pixels);
+        overdraw = measured ? overdraw + (sample - overdraw) * SMOOTHING : sample;
+        measured = true;
+        if (!prepass && overdraw > enableThreshold) {
+            prepass = true;
+        } else if (prepass && overdraw < disableThreshold) {
+            prepass = false;
+        }
+    }
+}
+
+void OverdrawMonitor::begin() {
+    collect();
+
+    // Skip the measurement rather than wait if the GPU hasn't finished with this slot yet
+    Slot& slot = slots[next];
+    if (slot.pending) {
+        return;
+    }
+
+    RenderDevice& device = RenderDevice::current();
+    if (slot.query == 0) {
+        slot.query = device.createQuery();
+    }
+    device.beginQuery(GL_SAMPLES_PASSED, slot.query);
+    active = true;
+}
+
+void OverdrawMonitor::end(uint64_t pixels) {
+    if (!active) {
+        return;
+    }
+
+    RenderDevice::current().endQuery(GL_SAMPLES_PASSED);
+    slots[next].pixels = pixels;
+    slots[next].pending = true;
+    next = (next + 1) % LATENCY;
+    active = false;
+}
+
+void OverdrawMonitor::release() {
+    RenderDevice& device = RenderDevice::current();
+    for (Slot& slot : slots) {
+        if (slot.query != 0) {
+            device.deleteQuery(slot.query);
+        }
+        slot = Slot{};
+    }
+    active = false;
+}
@@ -0,0 +1,84 @@
+#include "engine/DynamicResolution.h"
+
+#include <cmath>
+#include <engine/RenderDevice.h>
+
+namespace {
+constexpr float TARGET_FRACTION = 0.9f; ///< Aim this far into the budget, leaving headroom
+constexpr float RAISE_FRACTION = 0.85f; ///< Raise the scale once under this much of the target
+constexpr float RAISE_RATE = 0.1f;      ///< Part of the way up taken per result
+} // namespace
+
+// --- GpuFrameTimer ---
+void GpuFrameTimer::begin() {
+    // Oldest first, so the newest finished frame is the one left in milliseconds
+    RenderDevice& device = RenderDevice::current();
+    for (int i = 0; i < LATENCY; ++i) {
+        Slot& slot = slots[(next + i) % LATENCY];
+        uint64_t nanoseconds = 0;
+        if (slot.pending && device.queryResult(slot.query, nanoseconds)) {
+            slot.pending = false;
+            milliseconds.store(float(nanoseconds) * 1e-6f, std::memory_order_relaxed);
+            results.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    Slot& slot = slots[next];
+    if (slot.pending) {
+        return;
+    }
+    if (slot.query == 0) {
+        slot.query = device.createQuery();
+    }
+    device.beginQuery(GL_TIME_ELAPSED, slot.query);
+    active = true;
+}
+
+void GpuFrameTimer::end() {
+    if (!active) {
+        return;
+    }
+    RenderDevice::current().endQuery(GL_TIME_ELAPSED);
+    slots[next].pending = true;
+    next = (next + 1) % LATENCY;
+    active = false;
+}
+
+void GpuFrameTimer::release() {
+    RenderDevice& device = RenderDevice::current();
+    for (Slot& slot : slots) {
+        if (slot.query != 0) {
+            device.deleteQuery(slot.query);
+        }
+        slot = Slot{};
+    }
+    active = false;
+}
+
+// --- FrameBudgetController ---
+float FrameBudgetController::update(float gpuMilliseconds, float scale) {
+    if (gpuMilliseconds <= 0.0f) {
+        return scale; // Nothing measured (e.g. the null device)
+    }
+
+    float target = budget * TARGET_FRACTION;
+    float ideal = scale * std::sqrt(target / gpuMilliseconds);
+    if (gpuMilliseconds > budget) {
+        return ideal;
+    }
+    if (gpuMilliseconds < target * RAISE_FRACTION) {
+        return scale + (ideal - scale) * RAISE_RATE;
+    }
+    return scale;
+}
+
+// --- DynamicResolution ---
+float DynamicResolution::update(const GpuFrameTimer& timer) {
+    uint32_t count = timer.getResultCount();
+    if (enabled && count != seenResults) {
+        float next = controller->update(timer.getMilliseconds(), scale);
+        scale = std::max(minScale, std::min(next, maxScale));
+    }
+    seenResults = count;
+    return getScale();
+}
@@ -0,0 +1,180 @@
+#include "engine/GpuCulling.h"
+
+#include <algorithm>
+#include <iostream>
+#include <engine/Culling.h>
+#include <engine/Shader.h>
+
+void GpuCuller::setSources(const std::string& vertex, const std::string& geometry) {
+    vertexPath = vertex;
+    geometryPath = geometry;
+    failed = false;
+}
+
+bool GpuCuller::prepare() {
+    return program != 0 || build();
+}
+
+bool GpuCuller::beginFrame(const InstanceStreams& input, size_t count, const glm::mat4& viewProj) {
+    runs.clear();
+    culledCount = 0;
+    if (!prepare()) {
+        return false;
+    }
+
+    RenderDevice& device = RenderDevice::current();
+    GLsizeiptr bytes = static_cast<GLsizeiptr>(count) * OUTPUT_STRIDE;
+    device.bindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, output);
+    if (bytes > outputCapacity) {
+        outputCapacity = std::max(bytes, outputCapacity * 2);
+    }
+    // Orphaned every frame, so this frame's capture never waits on last frame's draws
+    device.bufferData(GL_TRANSFORM_FEEDBACK_BUFFER, outputCapacity, nullptr, GL_DYNAMIC_COPY);
+
+    device.useProgram(program);
+    Frustum frustum = Frustum::fromMatrix(viewProj);
+    for (int plane = 0; plane < 6; ++plane) {
+        device.setUniform(planeLocations[plane], frustum.planes[plane]);
+    }
+
+    // The instances are read as plain vertices here, one point each
+    GLsizei matrixStride = input.stride != 0 ? input.stride : sizeof(glm::mat4);
+    GLsizei vectorStride = input.stride != 0 ? input.stride : sizeof(glm::vec4);
+    GLsizei layerStride = input.stride != 0 ? input.stride : sizeof(float);
+    GLsizei boundsStride = input.stride != 0 ? input.stride : 2 * sizeof(glm::vec3);
+    size_t matrices = static_cast<size_t>(input.matrices);
+    size_t bounds = static_cast<size_t>(input.bounds);
+    device.bindVertexArray(vertexArray);
+    device.bindBuffer(GL_ARRAY_BUFFER, input.buffer);
+    for (unsigned int column = 0; column < 4; ++column) {
+        device.vertexAttribPointer(
+            column, 4, GL_FLOAT, false, matrixStride, matrices + column * sizeof(glm::vec4));
+    }
+    device.vertexAttribPointer(
+        4, 4, GL_FLOAT, false, vectorStride, static_cast<size_t>(input.uvTransforms));
+    device.vertexAttribPointer(
+        5, 1, GL_FLOAT, false, layerStride, static_cast<size_t>(input.layers));
+    device.vertexAttribPointer(6, 3, GL_FLOAT, false, boundsStride, bounds);
+    device.vertexAttribPointer(7, 3, GL_FLOAT, false, boundsStride, bounds + sizeof(glm::vec3));
+    device.setEnabled(GL_RASTERIZER_DISCARD, true);
+    return true;
+}
+
+void GpuCuller::cull(size_t first, size_t count) {
+    RenderDevice& device = RenderDevice::current();
+    if (queries.size() == runs.size()) {
+        queries.push_back(device.createQuery());
+    }
+    unsigned int query = queries[runs.size()];
+    runs.push_back(Run{first, count, query});
+
+    device.bindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER,
+                           0,
+                           output,
+                           static_cast<GLintptr>(first) * OUTPUT_STRIDE,
+                           static_cast<GLsizeiptr>(count) * OUTPUT_STRIDE);
+    device.beginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, query);
+    device.beginTransformFeedback(GL_POINTS);
+    device.drawArrays(GL_POINTS, static_cast<int>(first), static_cast<GLsizei>(count));
+    device.endTransformFeedback();
+    device.endQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+}
+
+void GpuCuller::endFrame() {
+    RenderDevice& device = RenderDevice::current();
+    device.setEnabled(GL_RASTERIZER_DISCARD, false);
+    device.bindVertexArray(0);
+}
+
+int GpuCuller::findRun(size_t first) const {
+    auto it = std::lower_bound(
+        runs.begin(), runs.end(), first, [](const Run& run, size_t value) {
+            return run.first < value;
+        });
+    return it != runs.end() && it->first == first ? static_cast<int>(it - runs.begin()) : -1;
+}
+
+GLsizei GpuCuller::getVisibleCount(int run) {
+    Run& entry = runs[run];
+    if (entry.visible < 0) {
+        uint64_t written = RenderDevice::current().waitQueryResult(entry.query);
+        entry.visible = static_cast<GLsizei>(std::min<uint64_t>(written, entry.count));
+        culledCount += entry.count - static_cast<size_t>(entry.visible);
+    }
+    return entry.visible;
+}
+
+InstanceStreams GpuCuller::getOutput(int run) const {
+    GLintptr base = static_cast<GLintptr>(runs[run].first) * OUTPUT_STRIDE;
+    InstanceStreams streams;
+    streams.buffer = output;
+    streams.matrices = base;
+    streams.uvTransforms = base + static_cast<GLintptr>(sizeof(glm::mat4));
+    streams.layers = streams.uvTransforms + static_cast<GLintptr>(sizeof(glm::vec4));
+    streams.stride = OUTPUT_STRIDE;
+    return streams;
+}
+
+void GpuCuller::release() {
+    RenderDevice& device = RenderDevice::current();
+    if (program != 0) {
+        device.deleteProgram(program);
+        device.deleteVertexArray(vertexArray);
+        device.deleteBuffer(output);
+    }
+    for (unsigned int query : queries) {
+        device.deleteQuery(query);
+    }
+    program = 0;
+    vertexArray = 0;
+    output = 0;
+    outputCapacity = 0;
+    queries.clear();
+    runs.clear();
+}
+
+bool GpuCuller::build() {
+    if (failed || vertexPath.empty() || geometryPath.empty()) {
+        return false;
+    }
+    failed = true;
+
+    RenderDevice& device = RenderDevice::current();
+    std::string vertexCode = Shader::readShaderFile(vertexPath.c_str()).str();
+    std::string geometryCode = Shader::readShaderFile(geometryPath.c_str()).str();
+    std::string log;
+    unsigned int vertex = device.compileShader(GL_VERTEX_SHADER, vertexCode.c_str(), log);
+    if (vertex == 0) {
+        std::cerr << "ERROR::GPU_CULLER::COMPILATION_FAILED\n" << log << '\n';
+        return false;
+    }
+    unsigned int geometry = device.compileShader(GL_GEOMETRY_SHADER, geometryCode.c_str(), log);
+    if (geometry == 0) {
+        std::cerr << "ERROR::GPU_CULLER::COMPILATION_FAILED\n" << log << '\n';
+        device.deleteShader(vertex);
+        return false;
+    }
+
+    const char* const varyings[] = {"outModel", "outUVTransform", "outLayer"};
+    program = device.linkFeedbackProgram(vertex, geometry, varyings, 3, log);
+    device.deleteShader(vertex);
+    device.deleteShader(geometry);
+    if (program == 0) {
+        std::cerr << "ERROR::GPU_CULLER::LINKING_FAILED\n" << log << '\n';
+        return false;
+    }
+    for (int plane = 0; plane < 6; ++plane) {
+        std::string name = "planes[" + std::to_string(plane) + "]";
+        planeLocations[plane] = device.getUniformLocation(program, name.c_str());
+    }
+
+    vertexArray = device.createVertexArray();
+    device.bindVertexArray(vertexArray);
+    for (unsigned int attribute = 0; attribute <= 7; ++attribute) {
+        device.enableVertexAttribArray(attribute);
+    }
+    device.bindVertexArray(0);
+    output = device.createBuffer();
+    failed = false;
+    return true;
+}
@@ -0,0 +1,207 @@
+#include "engine/Headless.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <numeric>
+#include <glad/glad.h>
+#include <engine/GLState.h>
+#include <engine/RenderDevice.h>
+
+#ifdef ENGINE_HEADLESS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstring>
+
+namespace {
+EGLDisplay openDisplay() {
+    // Prefer Mesa's surfaceless platform: no X server, no DRM device needed
+    const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (extensions != nullptr && std::strstr(extensions, "EGL_MESA_platform_surfaceless") &&
+        getPlatformDisplay != nullptr) {
+        EGLDisplay display =
+            getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (display != EGL_NO_DISPLAY) {
+            return display;
+        }
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+} // namespace
+
+bool HeadlessContext::create(int width, int height) {
+    this->width = width;
+    this->height = height;
+
+    EGLDisplay eglDisplay = openDisplay();
+    EGLint major = 0;
+    EGLint minor = 0;
+    if (eglDisplay == EGL_NO_DISPLAY || eglInitialize(eglDisplay, &major, &minor) == EGL_FALSE) {
+        std::cout << "Failed to initialize EGL\n";
+        return false;
+    }
+    display = eglDisplay;
+
+    const char* extensions = eglQueryString(eglDisplay, EGL_EXTENSIONS);
+    if (extensions == nullptr || !std::strstr(extensions, "EGL_KHR_surfaceless_context")) {
+        std::cout << "EGL display doesn't support surfaceless contexts\n";
+        destroy();
+        return false;
+    }
+
+    const EGLint configAttributes[] = {EGL_SURFACE_TYPE,
+                                       EGL_DONT_CARE,
+                                       EGL_RENDERABLE_TYPE,
+                                       EGL_OPENGL_BIT,
+                                       EGL_NONE};
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (eglBindAPI(EGL_OPENGL_API) == EGL_FALSE ||
+        eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configCount) == EGL_FALSE ||
+        configCount == 0) {
+        std::cout << "No EGL config with desktop OpenGL support\n";
+        destroy();
+        return false;
+    }
+
+    const EGLint contextAttributes[] = {EGL_CONTEXT_MAJOR_VERSION,
+                                        3,
+                                        EGL_CONTEXT_MINOR_VERSION,
+                                        3,
+                                        EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                        EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                        EGL_NONE};
+    EGLContext eglContext =
+        eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttributes);
+    if (eglContext == EGL_NO_CONTEXT ||
+        eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext) == EGL_FALSE) {
+        std::cout << "Failed to create a GL 3.3 core EGL context\n";
+        if (eglContext != EGL_NO_CONTEXT) {
+            eglDestroyContext(eglDisplay, eglContext);
+        }
+        destroy();
+        return false;
+    }
+    context = eglContext;
+
+    if (gladLoadGLLoader((GLADloadproc)eglGetProcAddress) == 0) {
+        std::cout << "Failed to initialize GLAD\n";
+        destroy();
+        return false;
+    }
+    GLRenderDevice::loadExtensions((GLADloadproc)eglGetProcAddress);
+    GLState::invalidate();
+
+    if (!createFramebuffer()) {
+        destroy();
+        return false;
+    }
+    std::cout << "Headless context: EGL " << major << "." << minor << ", "
+              << glGetString(GL_RENDERER) << ", " << width << "x" << height << "\n";
+    return true;
+}
+
+void HeadlessContext::destroy() {
+    if (context != nullptr) {
+        if (framebuffer != 0) {
+            GLState::setDefaultFramebuffer(0);
+            GLState::bindFramebuffer(0);
+            GLState::deleteFramebuffer(framebuffer);
+            glDeleteRenderbuffers(1, &colorBuffer);
+            glDeleteRenderbuffers(1, &depthBuffer);
+            framebuffer = 0;
+            colorBuffer = 0;
+            depthBuffer = 0;
+        }
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(display, static_cast<EGLContext>(context));
+        context = nullptr;
+    }
+    if (display != nullptr) {
+        eglTerminate(display);
+        display = nullptr;
+    }
+}
+#else
+bool HeadlessContext::create(int width, int height) {
+    std::cout << "Headless mode unavailable: build with -DENGINE_HEADLESS and link -lEGL\n";
+    return false;
+}
+
+void HeadlessContext::destroy() {}
+#endif
+
+bool HeadlessContext::createFramebuffer() {
+    glGenRenderbuffers(1, &colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+    glGenFramebuffers(1, &framebuffer);
+    GLState::bindFramebuffer(framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+    glFramebufferRenderbuffer(
+        GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "Headless framebuffer is incomplete\n";
+        return false;
+    }
+
+    GLState::setDefaultFramebuffer(framebuffer);
+    GLState::viewport(0, 0, width, height);
+    return true;
+}
+
+bool HeadlessContext::saveImage(const std::string& path) const {
+    if (framebuffer == 0) {
+        return false;
+    }
+
+    std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 3);
+    GLState::bindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        std::cout << "Failed to write image: " << path << "\n";
+        return false;
+    }
+    std::fprintf(file, "P6\n%d %d\n255\n", width, height);
+    // GL rows start at the bottom, PPM rows at the top
+    size_t rowSize = static_cast<size_t>(width) * 3;
+    for (int y = height - 1; y >= 0; --y) {
+        std::fwrite(&pixels[y * rowSize], 1, rowSize, file);
+    }
+    std::fclose(file);
+    return true;
+}
+
+void FrameTimeStats::report(std::ostream& out) const {
+    if (samples.empty()) {
+        out << "No frames recorded\n";
+        return;
+    }
+
+    std::vector<double> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&](double p) {
+        size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+        return sorted[index];
+    };
+    double total = std::accumulate(sorted.begin(), sorted.end(), 0.0);
+    double mean = total / sorted.size();
+
+    out << "frames: " << sorted.size() << "\n"
+        << "mean:   " << mean << " ms (" << 1000.0 / mean << " fps)\n"
+        << "min:    " << sorted.front() << " ms\n"
+        << "p50:    " << percentile(0.50) << " ms\n"
+        << "p95:    " << percentile(0.95) << " ms\n"
+        << "p99:    " << percentile(0.99) << " ms\n"
+        << "max:    " << sorted.back() << " ms\n";
+}
@@ -0,0 +1,215 @@
+#include "engine/OcclusionCulling.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OCCLUSION_SSE 1
+#endif
+
+namespace {
+// Vertices closer than this to the camera plane aren't projected
+constexpr float MIN_CLIP_W = 1e-4f;
+} // namespace
+
+OcclusionBuffer::OcclusionBuffer(int width, int height)
+    : width((std::max(width, TILE_WIDTH) + TILE_WIDTH - 1) / TILE_WIDTH * TILE_WIDTH),
+      height((std::max(height, TILE_HEIGHT) + TILE_HEIGHT - 1) / TILE_HEIGHT * TILE_HEIGHT),
+      tilesX(this->width / TILE_WIDTH), tilesY(this->height / TILE_HEIGHT),
+      depth(static_cast<size_t>(this->width) * this->height, 1.0f),
+      tileMaxDepth(static_cast<size_t>(tilesX) * tilesY, 1.0f) {}
+
+void OcclusionBuffer::begin(const glm::mat4& viewProj) {
+    this->viewProj = viewProj;
+    std::fill(depth.begin(), depth.end(), 1.0f);
+    std::fill(tileMaxDepth.begin(), tileMaxDepth.end(), 1.0f);
+}
+
+void OcclusionBuffer::rasterize(const glm::mat4& model, const glm::vec3* vertices, size_t count) {
+    glm::mat4 mvp = viewProj * model;
+    float halfWidth = width * 0.5f;
+    float halfHeight = height * 0.5f;
+
+    for (size_t i = 0; i + 2 < count; i += 3) {
+        ScreenVertex screen[3];
+        bool clipped = false;
+        for (int v = 0; v < 3; ++v) {
+            glm::vec4 clip = mvp * glm::vec4(vertices[i + v], 1.0f);
+            if (clip.w < MIN_CLIP_W) {
+                clipped = true;
+                break;
+            }
+            float invW = 1.0f / clip.w;
+            screen[v].x = (clip.x * invW + 1.0f) * halfWidth;
+            screen[v].y = (clip.y * invW + 1.0f) * halfHeight;
+            screen[v].z = clip.z * invW * 0.5f + 0.5f;
+        }
+        if (!clipped) {
+            rasterizeTriangle(screen[0], screen[1], screen[2]);
+        }
+    }
+}
+
+void OcclusionBuffer::rasterizeTriangle(ScreenVertex v0, ScreenVertex v1, ScreenVertex v2) {
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+    if (std::fabs(area) < 1e-6f) {
+        return;
+    }
+    // Both windings are rasterized; flipping makes every edge function positive inside
+    if (area < 0.0f) {
+        std::swap(v1, v2);
+        area = -area;
+    }
+
+    int minX = std::max(0, static_cast<int>(std::floor(std::min({v0.x, v1.x, v2.x}))));
+    int maxX = std::min(width - 1, static_cast<int>(std::floor(std::max({v0.x, v1.x, v2.x}))));
+    int minY = std::max(0, static_cast<int>(std::floor(std::min({v0.y, v1.y, v2.y}))));
+    int maxY = std::min(height - 1, static_cast<int>(std::floor(std::max({v0.y, v1.y, v2.y}))));
+    if (minX > maxX || minY > maxY) {
+        return;
+    }
+
+    // Edge functions E(x, y) = A * x + B * y + C, each paired with the opposite vertex
+    auto edge = [](const ScreenVertex& a, const ScreenVertex& b, float& A, float& B, float& C) {
+        A = a.y - b.y;
+        B = b.x - a.x;
+        C = a.x * b.y - a.y * b.x;
+    };
+    float A0, B0, C0, A1, B1, C1, A2, B2, C2;
+    edge(v1, v2, A0, B0, C0);
+    edge(v2, v0, A1, B1, C1);
+    edge(v0, v1, A2, B2, C2);
+
+    // Depth is affine in screen space: z = Az * x + Bz * y + Cz
+    float invArea = 1.0f / area;
+    float Az = (A0 * v0.z + A1 * v1.z + A2 * v2.z) * invArea;
+    float Bz = (B0 * v0.z + B1 * v1.z + B2 * v2.z) * invArea;
+    float Cz = (C0 * v0.z + C1 * v1.z + C2 * v2.z) * invArea;
+
+#ifdef OCCLUSION_SSE
+    // Four pixels per step. Blocks start 4-aligned; the extra columns fail the edge tests and
+    // the width is a multiple of 4, so they never leave the row.
+    int startX = minX & ~3;
+    __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+    for (int y = minY; y <= maxY; ++y) {
+        float py = y + 0.5f;
+        __m128 rowE0 = _mm_set1_ps(B0 * py + C0);
+        __m128 rowE1 = _mm_set1_ps(B1 * py + C1);
+        __m128 rowE2 = _mm_set1_ps(B2 * py + C2);
+        __m128 rowZ = _mm_set1_ps(Bz * py + Cz);
+        float* row = &depth[static_cast<size_t>(y) * width];
+
+        for (int x = startX; x <= maxX; x += 4) {
+            __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+            __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A0), px), rowE0);
+            __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A1), px), rowE1);
+            __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A2), px), rowE2);
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+                                       _mm_cmpge_ps(e2, zero));
+            if (_mm_movemask_ps(inside) == 0) {
+                continue;
+            }
+
+            __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(Az), px), rowZ);
+            z = _mm_min_ps(_mm_max_ps(z, zero), one);
+            __m128 old = _mm_loadu_ps(row + x);
+            __m128 nearest = _mm_min_ps(old, z);
+            __m128 blended = _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, old));
+            _mm_storeu_ps(row + x, blended);
+        }
+    }
+#else
+    for (int y = minY; y <= maxY; ++y) {
+        float py = y + 0.5f;
+        float* row = &depth[static_cast<size_t>(y) * width];
+        for (int x = minX; x <= maxX; ++x) {
+            float px = x + 0.5f;
+            if (A0 * px + B0 * py + C0 < 0.0f || A1 * px + B1 * py + C1 < 0.0f ||
+                A2 * px + B2 * py + C2 < 0.0f) {
+                continue;
+            }
+            float z = std::clamp(Az * px + Bz * py + Cz, 0.0f, 1.0f);
+            row[x] = std::min(row[x], z);
+        }
+    }
+#endif
+}
+
+void OcclusionBuffer::finish() {
+    for (int tileY = 0; tileY < tilesY; ++tileY) {
+        for (int tileX = 0; tileX < tilesX; ++tileX) {
+            float farthest = 0.0f;
+            for (int y = tileY * TILE_HEIGHT; y < (tileY + 1) * TILE_HEIGHT; ++y) {
+                const float* row = &depth[static_cast<size_t>(y) * width + tileX * TILE_WIDTH];
+                for (int x = 0; x < TILE_WIDTH; ++x) {
+                    farthest = std::max(farthest, row[x]);
+                }
+            }
+            tileMaxDepth[static_cast<size_t>(tileY) * tilesX + tileX] = farthest;
+        }
+    }
+}
+
+bool OcclusionBuffer::isVisible(const glm::vec3& center, const glm::vec3& extents) const {
+    float minX = static_cast<float>(width);
+    float minY = static_cast<float>(height);
+    float maxX = 0.0f;
+    float maxY = 0.0f;
+    float nearestDepth = 1.0f;
+
+    for (int corner = 0; corner < 8; ++corner) {
+        glm::vec3 sign((corner & 1) ? 1.0f : -1.0f,
+                       (corner & 2) ? 1.0f : -1.0f,
+                       (corner & 4) ? 1.0f : -1.0f);
+        glm::vec4 clip = viewProj * glm::vec4(center + sign * extents, 1.0f);
+        if (clip.w < MIN_CLIP_W) {
+            return true; // The box reaches behind the camera, its footprint is unbounded
+        }
+        float invW = 1.0f / clip.w;
+        float x = (clip.x * invW + 1.0f) * 0.5f * width;
+        float y = (clip.y * invW + 1.0f) * 0.5f * height;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        nearestDepth = std::min(nearestDepth, clip.z * invW * 0.5f + 0.5f);
+    }
+
+    int x0 = std::max(0, static_cast<int>(std::floor(minX)));
+    int y0 = std::max(0, static_cast<int>(std::floor(minY)));
+    int x1 = std::min(width - 1, static_cast<int>(std::floor(maxX)));
+    int y1 = std::min(height - 1, static_cast<int>(std::floor(maxY)));
+    if (x0 > x1 || y0 > y1) {
+        return true; // Off screen; leave that decision to the frustum test
+    }
+    return rectVisible(x0, y0, x1, y1, std::max(nearestDepth, 0.0f));
+}
+
+bool OcclusionBuffer::rectVisible(
+    int minX, int minY, int maxX, int maxY, float nearestDepth) const {
+    for (int tileY = minY / TILE_HEIGHT; tileY <= maxY / TILE_HEIGHT; ++tileY) {
+        for (int tileX = minX / TILE_WIDTH; tileX <= maxX / TILE_WIDTH; ++tileX) {
+            // Every pixel of this tile is nearer than the box: nothing to scan
+            if (tileMaxDepth[static_cast<size_t>(tileY) * tilesX + tileX] < nearestDepth) {
+                continue;
+            }
+
+            int y0 = std::max(minY, tileY * TILE_HEIGHT);
+            int y1 = std::min(maxY, (tileY + 1) * TILE_HEIGHT - 1);
+            int x0 = std::max(minX, tileX * TILE_WIDTH);
+            int x1 = std::min(maxX, (tileX + 1) * TILE_WIDTH - 1);
+            for (int y = y0; y <= y1; ++y) {
+                const float* row = &depth[static_cast<size_t>(y) * width];
+                for (int x = x0; x <= x1; ++x) {
+                    if (row[x] >= nearestDepth) {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,221 @@
+#include "engine/Particles.h"
+
+#include <algorithm>
+#include <cstring>
+#include <engine/RenderDevice.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+/// Instance attributes: the float columns from 1, then the color
+constexpr unsigned int COLOR_ATTRIBUTE = 1 + ParticleFrame::COLUMN_COUNT;
+} // namespace
+
+void ParticlePool::clear() {
+    forEachColumn([](auto& column) { column.clear(); });
+}
+
+void ParticlePool::reserve(size_t count) {
+    forEachColumn([count](auto& column) { column.reserve(count); });
+}
+
+void ParticlePool::push(const glm::vec3& position,
+                        const glm::vec3& velocity,
+                        float lifetime,
+                        const glm::vec4& color) {
+    x.push_back(position.x);
+    y.push_back(position.y);
+    z.push_back(position.z);
+    vx.push_back(velocity.x);
+    vy.push_back(velocity.y);
+    vz.push_back(velocity.z);
+    life.push_back(lifetime);
+    unsigned char bytes[4];
+    for (int channel = 0; channel < 4; ++channel) {
+        float value = std::clamp(color[channel], 0.0f, 1.0f);
+        bytes[channel] = static_cast<unsigned char>(value * 255.0f + 0.5f);
+    }
+    uint32_t packed;
+    std::memcpy(&packed, bytes, sizeof(packed));
+    this->color.push_back(packed);
+}
+
+// v = (v + gravity * dt) * damping, then p += v * dt; columns are only ever read and written at
+// the same index, so each lane is one particle
+void ParticlePool::simulate(
+    size_t begin, size_t end, float dt, const glm::vec3& gravity, float drag) {
+    float damping = std::max(1.0f - drag * dt, 0.0f);
+    glm::vec3 pull = gravity * dt;
+    size_t i = begin;
+
+#if defined(__AVX__)
+    __m256 pullX = _mm256_set1_ps(pull.x);
+    __m256 pullY = _mm256_set1_ps(pull.y);
+    __m256 pullZ = _mm256_set1_ps(pull.z);
+    __m256 keep = _mm256_set1_ps(damping);
+    __m256 step = _mm256_set1_ps(dt);
+    for (; i + 8 <= end; i += 8) {
+        __m256 velocityX = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(&vx[i]), pullX), keep);
+        __m256 velocityY = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(&vy[i]), pullY), keep);
+        __m256 velocityZ = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(&vz[i]), pullZ), keep);
+        _mm256_storeu_ps(&vx[i], velocityX);
+        _mm256_storeu_ps(&vy[i], velocityY);
+        _mm256_storeu_ps(&vz[i], velocityZ);
+        _mm256_storeu_ps(&x[i],
+                         _mm256_add_ps(_mm256_loadu_ps(&x[i]), _mm256_mul_ps(velocityX, step)));
+        _mm256_storeu_ps(&y[i],
+                         _mm256_add_ps(_mm256_loadu_ps(&y[i]), _mm256_mul_ps(velocityY, step)));
+        _mm256_storeu_ps(&z[i],
+                         _mm256_add_ps(_mm256_loadu_ps(&z[i]), _mm256_mul_ps(velocityZ, step)));
+        _mm256_storeu_ps(&life[i], _mm256_sub_ps(_mm256_loadu_ps(&life[i]), step));
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    __m128 pullX = _mm_set1_ps(pull.x);
+    __m128 pullY = _mm_set1_ps(pull.y);
+    __m128 pullZ = _mm_set1_ps(pull.z);
+    __m128 keep = _mm_set1_ps(damping);
+    __m128 step = _mm_set1_ps(dt);
+    for (; i + 4 <= end; i += 4) {
+        __m128 velocityX = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&vx[i]), pullX), keep);
+        __m128 velocityY = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&vy[i]), pullY), keep);
+        __m128 velocityZ = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&vz[i]), pullZ), keep);
+        _mm_storeu_ps(&vx[i], velocityX);
+        _mm_storeu_ps(&vy[i], velocityY);
+        _mm_storeu_ps(&vz[i], velocityZ);
+        _mm_storeu_ps(&x[i], _mm_add_ps(_mm_loadu_ps(&x[i]), _mm_mul_ps(velocityX, step)));
+        _mm_storeu_ps(&y[i], _mm_add_ps(_mm_loadu_ps(&y[i]), _mm_mul_ps(velocityY, step)));
+        _mm_storeu_ps(&z[i], _mm_add_ps(_mm_loadu_ps(&z[i]), _mm_mul_ps(velocityZ, step)));
+        _mm_storeu_ps(&life[i], _mm_sub_ps(_mm_loadu_ps(&life[i]), step));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    float32x4_t pullX = vdupq_n_f32(pull.x);
+    float32x4_t pullY = vdupq_n_f32(pull.y);
+    float32x4_t pullZ = vdupq_n_f32(pull.z);
+    for (; i + 4 <= end; i += 4) {
+        float32x4_t velocityX = vmulq_n_f32(vaddq_f32(vld1q_f32(&vx[i]), pullX), damping);
+        float32x4_t velocityY = vmulq_n_f32(vaddq_f32(vld1q_f32(&vy[i]), pullY), damping);
+        float32x4_t velocityZ = vmulq_n_f32(vaddq_f32(vld1q_f32(&vz[i]), pullZ), damping);
+        vst1q_f32(&vx[i], velocityX);
+        vst1q_f32(&vy[i], velocityY);
+        vst1q_f32(&vz[i], velocityZ);
+        vst1q_f32(&x[i], vmlaq_n_f32(vld1q_f32(&x[i]), velocityX, dt));
+        vst1q_f32(&y[i], vmlaq_n_f32(vld1q_f32(&y[i]), velocityY, dt));
+        vst1q_f32(&z[i], vmlaq_n_f32(vld1q_f32(&z[i]), velocityZ, dt));
+        vst1q_f32(&life[i], vsubq_f32(vld1q_f32(&life[i]), vdupq_n_f32(dt)));
+    }
+#endif
+
+    // Tail shorter than a vector, or everything without SIMD
+    for (; i < end; ++i) {
+        vx[i] = (vx[i] + pull.x) * damping;
+        vy[i] = (vy[i] + pull.y) * damping;
+        vz[i] = (vz[i] + pull.z) * damping;
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        z[i] += vz[i] * dt;
+        life[i] -= dt;
+    }
+}
+
+size_t ParticlePool::compact() {
+    size_t count = size();
+    size_t i = 0;
+    while (i < count) {
+        if (life[i] > 0.0f) {
+            ++i;
+            continue;
+        }
+        // The last particle takes the dead one's place and is tested in turn
+        --count;
+        forEachColumn([i, count](auto& column) { column[i] = column[count]; });
+    }
+    size_t removed = size() - count;
+    forEachColumn([count](auto& column) { column.resize(count); });
+    return removed;
+}
+
+uint32_t ParticleRenderer::draw(const ParticleFrame& frame, const Shader& shader) {
+    if (frame.count == 0 || frame.draws.empty()) {
+        return 0;
+    }
+
+    RenderDevice& device = RenderDevice::current();
+    size_t columnBytes = frame.count * ParticleFrame::COLUMN_COUNT * sizeof(float);
+    size_t colorBytes = frame.count * sizeof(uint32_t);
+    GLsizeiptr bytes = static_cast<GLsizeiptr>(columnBytes + colorBytes);
+    stream.beginFrame(bytes);
+    StreamAllocation allocation = stream.allocate(bytes, sizeof(float));
+    if (!allocation) {
+        return 0;
+    }
+    auto* data = static_cast<unsigned char*>(allocation.data);
+    std::memcpy(data, frame.columns.data(), columnBytes);
+    std::memcpy(data + columnBytes, frame.colors.data(), colorBytes);
+    stream.flush();
+
+    if (vertexArray == 0) {
+        const float corners[] = {-0.5f, -0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, 0.5f};
+        vertexArray = device.createVertexArray();
+        quad = device.createBuffer();
+        device.bindVertexArray(vertexArray);
+        device.bindBuffer(GL_ARRAY_BUFFER, quad);
+        device.bufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        device.vertexAttribPointer(0, 2, GL_FLOAT, false, 2 * sizeof(float), 0);
+        device.enableVertexAttribArray(0);
+        for (unsigned int attribute = 1; attribute <= COLOR_ATTRIBUTE; ++attribute) {
+            device.enableVertexAttribArray(attribute);
+            device.vertexAttribDivisor(attribute, 1);
+        }
+    }
+
+    shader.use();
+    device.bindVertexArray(vertexArray);
+    device.bindBuffer(GL_ARRAY_BUFFER, allocation.buffer);
+    device.setEnabled(GL_BLEND, true);
+    device.depthMask(false);
+    uint32_t drawCalls = 0;
+    size_t base = static_cast<size_t>(allocation.offset);
+    for (const ParticleDraw& draw : frame.draws) {
+        for (unsigned int column = 0; column < ParticleFrame::COLUMN_COUNT; ++column) {
+            size_t offset = base + (column * frame.count + draw.first) * sizeof(float);
+            device.vertexAttribPointer(1 + column, 1, GL_FLOAT, false, sizeof(float), offset);
+        }
+        device.vertexAttribPointer(COLOR_ATTRIBUTE,
+                                   4,
+                                   GL_UNSIGNED_BYTE,
+                                   true,
+                                   sizeof(uint32_t),
+                                   base + columnBytes + draw.first * sizeof(uint32_t));
+
+        const ParticleMaterial& material = draw.material;
+        device.blendFunc(GL_SRC_ALPHA, material.additive ? GL_ONE : GL_ONE_MINUS_SRC_ALPHA);
+        shader.setFloat("size", material.size);
+        shader.setFloat("fadeTime", std::max(material.fadeTime, 1e-4f));
+        shader.setBool("textured", material.texture != 0u);
+        if (material.texture != 0u) {
+            device.bindTexture(0, GL_TEXTURE_2D, material.texture);
+        }
+        device.drawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(draw.count));
+        ++drawCalls;
+    }
+    device.setEnabled(GL_BLEND, false);
+    device.depthMask(true);
+    return drawCalls;
+}
+
+void ParticleRenderer::release() {
+    RenderDevice& device = RenderDevice::current();
+    if (vertexArray != 0) {
+        device.deleteVertexArray(vertexArray);
+        device.deleteBuffer(quad);
+    }
+    vertexArray = 0;
+    quad = 0;
+    stream.release();
+}
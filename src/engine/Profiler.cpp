@@ -0,0 +1,151 @@
+#include "engine/Profiler.h"
+
+#include <cstring>
+#include <engine/RenderDevice.h>
+
+namespace {
+Timing* find(std::vector<Timing>& timings, const char* name) {
+    for (Timing& timing : timings) {
+        if (timing.name == name || std::strcmp(timing.name, name) == 0) {
+            return &timing;
+        }
+    }
+    return nullptr;
+}
+} // namespace
+
+// --- TimingStats ---
+void TimingStats::add(const char* name, float milliseconds) {
+    if (Timing* timing = find(timings, name)) {
+        timing->milliseconds += (milliseconds - timing->milliseconds) * SMOOTHING;
+    } else {
+        timings.push_back(Timing{name, milliseconds});
+    }
+}
+
+float TimingStats::get(const char* name) const {
+    for (const Timing& timing : timings) {
+        if (std::strcmp(timing.name, name) == 0) {
+            return timing.milliseconds;
+        }
+    }
+    return 0.0f;
+}
+
+void TimingStats::report(std::ostream& out, const char* title) const {
+    out << title << ":\n";
+    for (const Timing& timing : timings) {
+        out << "  " << timing.name << ": " << timing.milliseconds << " ms\n";
+    }
+}
+
+// --- GpuProfiler ---
+void GpuProfiler::beginFrame() {
+    // Oldest first, so the smoothing sees frames in order
+    RenderDevice& device = RenderDevice::current();
+    bool collected = false;
+    for (int i = 0; i < LATENCY; ++i) {
+        Frame& frame = frames[(next + i) % LATENCY];
+        uint64_t nanoseconds = 0;
+        if (frame.pending && device.queryResult(frame.last, nanoseconds)) {
+            collect(frame);
+            collected = true;
+        }
+    }
+    if (collected) {
+        std::lock_guard<std::mutex> lock(mutex);
+        published = timings;
+    }
+
+    active = !frames[next].pending;
+}
+
+void GpuProfiler::endFrame() {
+    if (!active) {
+        return;
+    }
+    while (!open.empty()) {
+        end();
+    }
+    Frame& frame = frames[next];
+    if (!frame.sections.empty()) {
+        frame.pending = true;
+        next = (next + 1) % LATENCY;
+    }
+    active = false;
+}
+
+void GpuProfiler::begin(const char* name) {
+    if (!active) {
+        return;
+    }
+    Frame& frame = frames[next];
+    open.push_back(frame.sections.size());
+    frame.sections.push_back(Section{name, timestamp()});
+}
+
+void GpuProfiler::end() {
+    if (!active || open.empty()) {
+        return;
+    }
+    frames[next].sections[open.back()].end = timestamp();
+    open.pop_back();
+}
+
+void GpuProfiler::release() {
+    RenderDevice& device = RenderDevice::current();
+    for (Frame& frame : frames) {
+        for (const Section& section : frame.sections) {
+            pool.push_back(section.begin);
+            if (section.end != 0) {
+                pool.push_back(section.end);
+            }
+        }
+        frame = Frame{};
+    }
+    for (unsigned int query : pool) {
+        device.deleteQuery(query);
+    }
+    pool.clear();
+    open.clear();
+    active = false;
+}
+
+unsigned int GpuProfiler::timestamp() {
+    RenderDevice& device = RenderDevice::current();
+    unsigned int query = 0;
+    if (pool.empty()) {
+        query = device.createQuery();
+    } else {
+        query = pool.back();
+        pool.pop_back();
+    }
+    device.queryCounter(query);
+    frames[next].last = query;
+    return query;
+}
+
+void GpuProfiler::collect(Frame& frame) {
+    RenderDevice& device = RenderDevice::current();
+    frameTotals.clear();
+    for (const Section& section : frame.sections) {
+        uint64_t begin = 0;
+        uint64_t end = 0;
+        if (device.queryResult(section.begin, begin) && device.queryResult(section.end, end)) {
+            float milliseconds = end > begin ? float(end - begin) * 1e-6f : 0.0f;
+            if (Timing* total = find(frameTotals, section.name)) {
+                total->milliseconds += milliseconds;
+            } else {
+                frameTotals.push_back(Timing{section.name, milliseconds});
+            }
+        }
+        pool.push_back(section.begin);
+        pool.push_back(section.end);
+    }
+    for (const Timing& total : frameTotals) {
+        timings.add(total.name, total.milliseconds);
+    }
+    frame.sections.clear();
+    frame.last = 0;
+    frame.pending = false;
+}
@@ -0,0 +1,563 @@
+#include "engine/RecordingRenderDevice.h"
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+
+namespace {
+const char* const COMMAND_NAMES[] = {
+    "CreateBuffer",           "DeleteBuffer",
+    "BindBuffer",             "BindBufferRange",
+    "BufferData",             "BufferSubData",
+    "BufferStorage",          "MapBufferRange",
+    "FlushMappedRange",       "UnmapBuffer",
+    "FenceSync",              "ClientWaitSync",
+    "DeleteSync",             "CreateQuery",
+    "DeleteQuery",            "BeginQuery",
+    "EndQuery",               "QueryCounter",
+    "QueryResult",            "WaitQueryResult",
+    "CreateVertexArray",      "DeleteVertexArray",
+    "BindVertexArray",        "VertexAttribPointer",
+    "EnableVertexAttrib",     "VertexAttribDivisor",
+    "CreateTexture",          "DeleteTexture",
+    "BindTexture",            "TexParameter",
+    "TexImage2D",             "TexImage3D",
+    "TexSubImage2D",          "TexSubImage3D",
+    "GenerateMipmap",         "TexBuffer",
+    "CreateFramebuffer",      "DeleteFramebuffer",
+    "BindFramebuffer",        "FramebufferTextureLayer",
+    "FramebufferTexture",     "DrawBuffer",
+    "DrawBuffers",            "ReadBuffer",
+    "CheckFramebufferStatus", "BlitFramebuffer",
+    "CompileShader",          "LinkProgram",
+    "LinkFeedbackProgram",    "DeleteShader",
+    "DeleteProgram",          "UseProgram",
+    "GetUniformLocation",     "UniformBlockBinding",
+    "SetUniform",             "SetEnabled",
+    "DepthMask",              "ColorMask",
+    "DepthFunc",              "BlendFunc",
+    "BlendFuncSeparate",      "PolygonOffset",
+    "Viewport",               "Clear",
+    "DrawArrays",             "DrawArraysInstanced",
+    "BeginTransformFeedback", "EndTransformFeedback",
+    "Finish",                 "GetInteger",
+    "GetViewport",
+};
+static_assert(sizeof(COMMAND_NAMES) / sizeof(COMMAND_NAMES[0]) ==
+                  static_cast<size_t>(RenderCommand::Count),
+              "every RenderCommand needs a name");
+
+uint32_t arg(int64_t value) {
+    return static_cast<uint32_t>(value);
+}
+} // namespace
+
+void RecordingRenderDevice::record(
+    RenderCommand command, uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    ++counts[static_cast<size_t>(command)];
+    if (capture) {
+        commands.push_back(RecordedCommand{command, {a, b, c, d}});
+    }
+}
+
+void RecordingRenderDevice::reset() {
+    commands.clear();
+    std::fill(std::begin(counts), std::end(counts), 0);
+    vertexCount = 0;
+    uploadedBytes = 0;
+}
+
+uint64_t RecordingRenderDevice::totalCommands() const {
+    return std::accumulate(std::begin(counts), std::end(counts), uint64_t{0});
+}
+
+void RecordingRenderDevice::report(std::ostream& out, uint64_t frames) const {
+    frames = std::max<uint64_t>(frames, 1);
+    out << name() << " device, per frame over " << frames << " frames:\n";
+    for (size_t i = 0; i < static_cast<size_t>(RenderCommand::Count); ++i) {
+        if (counts[i] != 0) {
+            out << "  " << COMMAND_NAMES[i] << ": " << double(counts[i]) / frames << "\n";
+        }
+    }
+    out << "  total commands: " << double(totalCommands()) / frames << "\n"
+        << "  vertices: " << double(vertexCount) / frames << "\n"
+        << "  uploaded bytes: " << double(uploadedBytes) / frames << "\n";
+}
+
+const char* RecordingRenderDevice::commandName(RenderCommand command) {
+    return COMMAND_NAMES[static_cast<size_t>(command)];
+}
+
+// --- Buffers ---
+unsigned int RecordingRenderDevice::createBuffer() {
+    unsigned int buffer = nextObject++;
+    record(RenderCommand::CreateBuffer, buffer);
+    return buffer;
+}
+
+void RecordingRenderDevice::deleteBuffer(unsigned int buffer) {
+    memory.erase(buffer);
+    record(RenderCommand::DeleteBuffer, buffer);
+}
+
+void RecordingRenderDevice::bindBuffer(GLenum target, unsigned int buffer) {
+    boundBuffers[target] = buffer;
+    record(RenderCommand::BindBuffer, target, buffer);
+}
+
+void RecordingRenderDevice::bindBufferRange(
+    GLenum target, unsigned int index, unsigned int buffer, GLintptr offset, GLsizeiptr size) {
+    record(RenderCommand::BindBufferRange, target, index, buffer, arg(offset));
+}
+
+void RecordingRenderDevice::bufferData(GLenum target,
+                                       GLsizeiptr size,
+                                       const void* data,
+                                       GLenum usage) {
+    if (data != nullptr) {
+        uploadedBytes += static_cast<uint64_t>(size);
+    }
+    boundMemory(target).resize(static_cast<size_t>(size));
+    record(RenderCommand::BufferData, target, arg(size), usage);
+}
+
+void RecordingRenderDevice::bufferSubData(GLenum target,
+                                          GLintptr offset,
+                                          GLsizeiptr size,
+                                          const void* data) {
+    uploadedBytes += static_cast<uint64_t>(size);
+    record(RenderCommand::BufferSubData, target, arg(offset), arg(size));
+}
+
+bool RecordingRenderDevice::bufferStorage(GLenum target,
+                                          GLsizeiptr size,
+                                          const void* data,
+                                          GLbitfield flags) {
+    if (!bufferStorageSupported) {
+        return false;
+    }
+    if (data != nullptr) {
+        uploadedBytes += static_cast<uint64_t>(size);
+    }
+    boundMemory(target).resize(static_cast<size_t>(size));
+    record(RenderCommand::BufferStorage, target, arg(size), flags);
+    return true;
+}
+
+bool RecordingRenderDevice::supportsBufferStorage() const {
+    return bufferStorageSupported;
+}
+
+void* RecordingRenderDevice::mapBufferRange(GLenum target,
+                                            GLintptr offset,
+                                            GLsizeiptr length,
+                                            GLbitfield access) {
+    record(RenderCommand::MapBufferRange, target, arg(offset), arg(length), access);
+    std::vector<unsigned char>& bytes = boundMemory(target);
+    if (static_cast<size_t>(offset + length) > bytes.size()) {
+        return nullptr;
+    }
+    return bytes.data() + offset;
+}
+
+void RecordingRenderDevice::flushMappedBufferRange(GLenum target,
+                                                   GLintptr offset,
+                                                   GLsizeiptr length) {
+    uploadedBytes += static_cast<uint64_t>(length);
+    record(RenderCommand::FlushMappedBufferRange, target, arg(offset), arg(length));
+}
+
+void RecordingRenderDevice::unmapBuffer(GLenum target) {
+    record(RenderCommand::UnmapBuffer, target);
+}
+
+// --- Synchronization ---
+GLsync RecordingRenderDevice::fenceSync() {
+    uintptr_t fence = nextFence++;
+    record(RenderCommand::FenceSync, arg(fence));
+    return reinterpret_cast<GLsync>(fence);
+}
+
+bool RecordingRenderDevice::clientWaitSync(GLsync fence, uint64_t timeout) {
+    record(RenderCommand::ClientWaitSync, arg(reinterpret_cast<uintptr_t>(fence)));
+    return true;
+}
+
+void RecordingRenderDevice::deleteSync(GLsync fence) {
+    record(RenderCommand::DeleteSync, arg(reinterpret_cast<uintptr_t>(fence)));
+}
+
+// --- Queries ---
+unsigned int RecordingRenderDevice::createQuery() {
+    unsigned int query = nextObject++;
+    record(RenderCommand::CreateQuery, query);
+    return query;
+}
+
+void RecordingRenderDevice::deleteQuery(unsigned int query) {
+    record(RenderCommand::DeleteQuery, query);
+}
+
+void RecordingRenderDevice::beginQuery(GLenum target, unsigned int query) {
+    record(RenderCommand::BeginQuery, target, query);
+}
+
+void RecordingRenderDevice::endQuery(GLenum target) {
+    record(RenderCommand::EndQuery, target);
+}
+
+void RecordingRenderDevice::queryCounter(unsigned int query) {
+    record(RenderCommand::QueryCounter, query);
+}
+
+bool RecordingRenderDevice::queryResult(unsigned int query, uint64_t& result) {
+    record(RenderCommand::QueryResult, query);
+    result = 0;
+    return true;
+}
+
+uint64_t RecordingRenderDevice::waitQueryResult(unsigned int query) {
+    record(RenderCommand::WaitQueryResult, query);
+    return 0;
+}
+
+// --- Vertex arrays ---
+unsigned int RecordingRenderDevice::createVertexArray() {
+    unsigned int vao = nextObject++;
+    record(RenderCommand::CreateVertexArray, vao);
+    return vao;
+}
+
+void RecordingRenderDevice::deleteVertexArray(unsigned int vao) {
+    record(RenderCommand::DeleteVertexArray, vao);
+}
+
+void RecordingRenderDevice::bindVertexArray(unsigned int vao) {
+    record(RenderCommand::BindVertexArray, vao);
+}
+
+void RecordingRenderDevice::vertexAttribPointer(
+    unsigned int index, int size, GLenum type, bool normalized, GLsizei stride, size_t offset) {
+    record(RenderCommand::VertexAttribPointer, index, arg(size), arg(stride), arg(offset));
+}
+
+void RecordingRenderDevice::enableVertexAttribArray(unsigned int index) {
+    record(RenderCommand::EnableVertexAttribArray, index);
+}
+
+void RecordingRenderDevice::vertexAttribDivisor(unsigned int index, unsigned int divisor) {
+    record(RenderCommand::VertexAttribDivisor, index, divisor);
+}
+
+// --- Textures ---
+unsigned int RecordingRenderDevice::createTexture() {
+    unsigned int texture = nextObject++;
+    record(RenderCommand::CreateTexture, texture);
+    return texture;
+}
+
+void RecordingRenderDevice::deleteTexture(unsigned int texture) {
+    record(RenderCommand::DeleteTexture, texture);
+}
+
+void RecordingRenderDevice::bindTexture(unsigned int unit, GLenum target, unsigned int texture) {
+    record(RenderCommand::BindTexture, unit, target, texture);
+}
+
+void RecordingRenderDevice::texParameter(GLenum target, GLenum name, int value) {
+    record(RenderCommand::TexParameter, target, name, arg(value));
+}
+
+void RecordingRenderDevice::texImage2D(GLenum target,
+                                       int level,
+                                       int internalFormat,
+                                       int width,
+                                       int height,
+                                       GLenum format,
+                                       GLenum type,
+                                       const void* pixels) {
+    if (pixels != nullptr) {
+        uploadedBytes += static_cast<uint64_t>(width) * height * 4;
+    }
+    record(RenderCommand::TexImage2D, target, arg(level), arg(width), arg(height));
+}
+
+void RecordingRenderDevice::texImage3D(GLenum target,
+                                       int level,
+                                       int internalFormat,
+                                       int width,
+                                       int height,
+                                       int depth,
+                                       GLenum format,
+                                       GLenum type,
+                                       const void* pixels) {
+    if (pixels != nullptr) {
+        uploadedBytes += static_cast<uint64_t>(width) * height * depth * 4;
+    }
+    record(RenderCommand::TexImage3D, target, arg(width), arg(height), arg(depth));
+}
+
+void RecordingRenderDevice::texSubImage2D(unsigned int unit,
+                                          unsigned int texture,
+                                          int level,
+                                          int x,
+                                          int y,
+                                          int width,
+                                          int height,
+                                          GLenum format,
+                                          GLenum type,
+                                          const void* pixels) {
+    if (pixels != nullptr) {
+        uploadedBytes += static_cast<uint64_t>(width) * height * 4;
+    }
+    record(RenderCommand::TexSubImage2D, texture, arg(level), arg(width), arg(height));
+}
+
+void RecordingRenderDevice::texSubImage3D(unsigned int unit,
+                                          unsigned int texture,
+                                          int level,
+                                          int layer,
+                                          int width,
+                                          int height,
+                                          GLenum format,
+                                          GLenum type,
+                                          const void* pixels) {
+    if (pixels != nullptr) {
+        uploadedBytes += static_cast<uint64_t>(width) * height * 4;
+    }
+    record(RenderCommand::TexSubImage3D, texture, arg(level), arg(layer), arg(width));
+}
+
+void RecordingRenderDevice::generateMipmap(GLenum target) {
+    record(RenderCommand::GenerateMipmap, target);
+}
+
+void RecordingRenderDevice::texBuffer(unsigned int unit,
+                                      unsigned int texture,
+                                      GLenum internalFormat,
+                                      unsigned int buffer) {
+    record(RenderCommand::TexBuffer, unit, texture, internalFormat, buffer);
+}
+
+// --- Framebuffers ---
+unsigned int RecordingRenderDevice::createFramebuffer() {
+    unsigned int framebuffer = nextObject++;
+    record(RenderCommand::CreateFramebuffer, framebuffer);
+    return framebuffer;
+}
+
+void RecordingRenderDevice::deleteFramebuffer(unsigned int framebuffer) {
+    record(RenderCommand::DeleteFramebuffer, framebuffer);
+}
+
+void RecordingRenderDevice::bindFramebuffer(unsigned int framebuffer) {
+    record(RenderCommand::BindFramebuffer, framebuffer);
+}
+
+void RecordingRenderDevice::framebufferTextureLayer(GLenum attachment,
+                                                    unsigned int texture,
+                                                    int level,
+                                                    int layer) {
+    record(RenderCommand::FramebufferTextureLayer, attachment, texture, arg(level), arg(layer));
+}
+
+void RecordingRenderDevice::framebufferTexture(GLenum attachment,
+                                               unsigned int texture,
+                                               int level) {
+    record(RenderCommand::FramebufferTexture, attachment, texture, arg(level));
+}
+
+void RecordingRenderDevice::drawBuffer(GLenum buffer) {
+    record(RenderCommand::DrawBuffer, buffer);
+}
+
+void RecordingRenderDevice::drawBuffers(GLsizei count, const GLenum* buffers) {
+    record(RenderCommand::DrawBuffers, arg(count), count > 0 ? buffers[0] : GL_NONE);
+}
+
+void RecordingRenderDevice::readBuffer(GLenum buffer) {
+    record(RenderCommand::ReadBuffer, buffer);
+}
+
+GLenum RecordingRenderDevice::checkFramebufferStatus() {
+    record(RenderCommand::CheckFramebufferStatus);
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+void RecordingRenderDevice::blitFramebuffer(unsigned int source,
+                                            unsigned int destination,
+                                            const int sourceRect[4],
+                                            const int destinationRect[4],
+                                            GLbitfield mask,
+                                            GLenum filter) {
+    record(RenderCommand::BlitFramebuffer, source, destination, mask, filter);
+}
+
+// --- Programs ---
+unsigned int RecordingRenderDevice::compileShader(GLenum type,
+                                                  const char* source,
+                                                  std::string& log) {
+    unsigned int shader = nextObject++;
+    record(RenderCommand::CompileShader, shader, type);
+    return shader;
+}
+
+unsigned int RecordingRenderDevice::linkProgram(unsigned int vertex,
+                                                unsigned int fragment,
+                                                std::string& log) {
+    unsigned int program = nextObject++;
+    record(RenderCommand::LinkProgram, program, vertex, fragment);
+    return program;
+}
+
+unsigned int RecordingRenderDevice::linkFeedbackProgram(unsigned int vertex,
+                                                        unsigned int geometry,
+                                                        const char* const* varyings,
+                                                        int varyingCount,
+                                                        std::string& log) {
+    unsigned int program = nextObject++;
+    record(RenderCommand::LinkFeedbackProgram, program, vertex, geometry, arg(varyingCount));
+    return program;
+}
+
+void RecordingRenderDevice::deleteShader(unsigned int shader) {
+    record(RenderCommand::DeleteShader, shader);
+}
+
+void RecordingRenderDevice::deleteProgram(unsigned int program) {
+    record(RenderCommand::DeleteProgram, program);
+}
+
+void RecordingRenderDevice::useProgram(unsigned int program) {
+    record(RenderCommand::UseProgram, program);
+}
+
+int RecordingRenderDevice::getUniformLocation(unsigned int program, const char* name) {
+    // One location per name across programs is enough to keep callers' caches consistent
+    auto it = uniformLocations.emplace(name, static_cast<int>(uniformLocations.size())).first;
+    record(RenderCommand::GetUniformLocation, program, arg(it->second));
+    return it->second;
+}
+
+void RecordingRenderDevice::uniformBlockBinding(unsigned int program,
+                                                const char* blockName,
+                                                unsigned int binding) {
+    record(RenderCommand::UniformBlockBinding, program, binding);
+}
+
+void RecordingRenderDevice::setUniform(int location, int value) {
+    record(RenderCommand::SetUniform, arg(location), arg(value));
+}
+
+void RecordingRenderDevice::setUniform(int location, float value) {
+    record(RenderCommand::SetUniform, arg(location));
+}
+
+void RecordingRenderDevice::setUniform(int location, const glm::vec2& value) {
+    record(RenderCommand::SetUniform, arg(location));
+}
+
+void RecordingRenderDevice::setUniform(int location, const glm::vec4& value) {
+    record(RenderCommand::SetUniform, arg(location));
+}
+
+void RecordingRenderDevice::setUniform(int location, const glm::mat4& value) {
+    record(RenderCommand::SetUniform, arg(location));
+}
+
+// --- Fixed-function state ---
+void RecordingRenderDevice::setEnabled(GLenum capability, bool enabled) {
+    record(RenderCommand::SetEnabled, capability, enabled ? 1u : 0u);
+}
+
+void RecordingRenderDevice::depthMask(bool enabled) {
+    record(RenderCommand::DepthMask, enabled ? 1u : 0u);
+}
+
+void RecordingRenderDevice::colorMask(bool enabled) {
+    record(RenderCommand::ColorMask, enabled ? 1u : 0u);
+}
+
+void RecordingRenderDevice::depthFunc(GLenum func) {
+    record(RenderCommand::DepthFunc, func);
+}
+
+void RecordingRenderDevice::blendFunc(GLenum source, GLenum destination) {
+    record(RenderCommand::BlendFunc, source, destination);
+}
+
+void RecordingRenderDevice::blendFuncSeparate(GLenum sourceColor,
+                                              GLenum destinationColor,
+                                              GLenum sourceAlpha,
+                                              GLenum destinationAlpha) {
+    record(RenderCommand::BlendFuncSeparate,
+           sourceColor,
+           destinationColor,
+           sourceAlpha,
+           destinationAlpha);
+}
+
+void RecordingRenderDevice::polygonOffset(float factor, float units) {
+    record(RenderCommand::PolygonOffset);
+}
+
+void RecordingRenderDevice::viewport(int x, int y, int width, int height) {
+    currentViewport[0] = x;
+    currentViewport[1] = y;
+    currentViewport[2] = width;
+    currentViewport[3] = height;
+    record(RenderCommand::Viewport, arg(x), arg(y), arg(width), arg(height));
+}
+
+// --- Drawing ---
+void RecordingRenderDevice::clear(const glm::vec4& color, GLbitfield mask) {
+    record(RenderCommand::Clear, mask);
+}
+
+void RecordingRenderDevice::drawArrays(GLenum mode, int first, GLsizei count) {
+    vertexCount += static_cast<uint64_t>(count);
+    record(RenderCommand::DrawArrays, mode, arg(first), arg(count));
+}
+
+void RecordingRenderDevice::drawArraysInstanced(GLenum mode,
+                                                int first,
+                                                GLsizei count,
+                                                GLsizei instances) {
+    vertexCount += static_cast<uint64_t>(count) * instances;
+    record(RenderCommand::DrawArraysInstanced, mode, arg(first), arg(count), arg(instances));
+}
+
+void RecordingRenderDevice::beginTransformFeedback(GLenum primitiveMode) {
+    record(RenderCommand::BeginTransformFeedback, primitiveMode);
+}
+
+void RecordingRenderDevice::endTransformFeedback() {
+    record(RenderCommand::EndTransformFeedback);
+}
+
+void RecordingRenderDevice::finish() {
+    record(RenderCommand::Finish);
+}
+
+int RecordingRenderDevice::getInteger(GLenum name) {
+    record(RenderCommand::GetInteger, name);
+    switch (name) {
+    case GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT:
+        return 256;
+    case GL_MAX_TEXTURE_SIZE:
+        return 16384;
+    case GL_MAX_TEXTURE_BUFFER_SIZE:
+        return 1 << 27;
+    case GL_MAX_UNIFORM_BLOCK_SIZE:
+        return 65536;
+    case GL_MAX_ARRAY_TEXTURE_LAYERS:
+        return 2048;
+    default:
+        return 0;
+    }
+}
+
+void RecordingRenderDevice::getViewport(int viewport[4]) {
+    record(RenderCommand::GetViewport);
+    std::copy(std::begin(currentViewport), std::end(currentViewport), viewport);
+}
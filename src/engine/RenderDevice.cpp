@@ -0,0 +1,516 @@
+#include "engine/RenderDevice.h"
+
+#include <cstring>
+#include <engine/GLState.h>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace {
+GLRenderDevice glDevice;
+RenderDevice* currentDevice = &glDevice;
+
+using BufferStorageProc = void(APIENTRYP)(GLenum, GLsizeiptr, const void*, GLbitfield);
+BufferStorageProc bufferStorageProc = nullptr;
+
+bool hasExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension != nullptr && std::strcmp(extension, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+} // namespace
+
+void GLRenderDevice::loadExtensions(GLADloadproc loader) {
+    bufferStorageProc = nullptr;
+    bool core = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 4);
+    if (core || hasExtension("GL_ARB_buffer_storage")) {
+        bufferStorageProc = reinterpret_cast<BufferStorageProc>(loader("glBufferStorage"));
+    }
+}
+
+RenderDevice& RenderDevice::current() {
+    return *currentDevice;
+}
+
+void RenderDevice::setCurrent(RenderDevice* device) {
+    currentDevice = device != nullptr ? device : &glDevice;
+}
+
+// --- Buffers ---
+unsigned int GLRenderDevice::createBuffer() {
+    unsigned int buffer = 0;
+    glGenBuffers(1, &buffer);
+    return buffer;
+}
+
+void GLRenderDevice::deleteBuffer(unsigned int buffer) {
+    GLState::deleteBuffer(buffer);
+}
+
+void GLRenderDevice::bindBuffer(GLenum target, unsigned int buffer) {
+    GLState::bindBuffer(target, buffer);
+}
+
+void GLRenderDevice::bindBufferRange(
+    GLenum target, unsigned int index, unsigned int buffer, GLintptr offset, GLsizeiptr size) {
+    GLState::bindBufferRange(target, index, buffer, offset, size);
+}
+
+void GLRenderDevice::bufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+    glBufferData(target, size, data, usage);
+}
+
+void GLRenderDevice::bufferSubData(GLenum target,
+                                   GLintptr offset,
+                                   GLsizeiptr size,
+                                   const void* data) {
+    glBufferSubData(target, offset, size, data);
+}
+
+bool GLRenderDevice::bufferStorage(GLenum target,
+                                   GLsizeiptr size,
+                                   const void* data,
+                                   GLbitfield flags) {
+    if (bufferStorageProc == nullptr) {
+        return false;
+    }
+    bufferStorageProc(target, size, data, flags);
+    return true;
+}
+
+bool GLRenderDevice::supportsBufferStorage() const {
+    return bufferStorageProc != nullptr;
+}
+
+void* GLRenderDevice::mapBufferRange(GLenum target,
+                                     GLintptr offset,
+                                     GLsizeiptr length,
+                                     GLbitfield access) {
+    return glMapBufferRange(target, offset, length, access);
+}
+
+void GLRenderDevice::flushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr length) {
+    glFlushMappedBufferRange(target, offset, length);
+}
+
+void GLRenderDevice::unmapBuffer(GLenum target) {
+    glUnmapBuffer(target);
+}
+
+// --- Synchronization ---
+GLsync GLRenderDevice::fenceSync() {
+    return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool GLRenderDevice::clientWaitSync(GLsync fence, uint64_t timeout) {
+    GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    return result != GL_TIMEOUT_EXPIRED;
+}
+
+void GLRenderDevice::deleteSync(GLsync fence) {
+    glDeleteSync(fence);
+}
+
+// --- Queries ---
+unsigned int GLRenderDevice::createQuery() {
+    unsigned int query = 0;
+    glGenQueries(1, &query);
+    return query;
+}
+
+void GLRenderDevice::deleteQuery(unsigned int query) {
+    glDeleteQueries(1, &query);
+}
+
+void GLRenderDevice::beginQuery(GLenum target, unsigned int query) {
+    glBeginQuery(target, query);
+}
+
+void GLRenderDevice::endQuery(GLenum target) {
+    glEndQuery(target);
+}
+
+void GLRenderDevice::queryCounter(unsigned int query) {
+    glQueryCounter(query, GL_TIMESTAMP);
+}
+
+bool GLRenderDevice::queryResult(unsigned int query, uint64_t& result) {
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available == GL_FALSE) {
+        return false;
+    }
+    GLuint64 value = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &value);
+    result = value;
+    return true;
+}
+
+uint64_t GLRenderDevice::waitQueryResult(unsigned int query) {
+    GLuint64 value = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &value);
+    return value;
+}
+
+// --- Vertex arrays ---
+unsigned int GLRenderDevice::createVertexArray() {
+    unsigned int vao = 0;
+    glGenVertexArrays(1, &vao);
+    return vao;
+}
+
+void GLRenderDevice::deleteVertexArray(unsigned int vao) {
+    GLState::deleteVertexArray(vao);
+}
+
+void GLRenderDevice::bindVertexArray(unsigned int vao) {
+    GLState::bindVertexArray(vao);
+}
+
+void GLRenderDevice::vertexAttribPointer(
+    unsigned int index, int size, GLenum type, bool normalized, GLsizei stride, size_t offset) {
+    glVertexAttribPointer(
+        index, size, type, normalized ? GL_TRUE : GL_FALSE, stride, (void*)offset);
+}
+
+void GLRenderDevice::enableVertexAttribArray(unsigned int index) {
+    glEnableVertexAttribArray(index);
+}
+
+void GLRenderDevice::vertexAttribDivisor(unsigned int index, unsigned int divisor) {
+    glVertexAttribDivisor(index, divisor);
+}
+
+// --- Textures ---
+unsigned int GLRenderDevice::createTexture() {
+    unsigned int texture = 0;
+    glGenTextures(1, &texture);
+    return texture;
+}
+
+void GLRenderDevice::deleteTexture(unsigned int texture) {
+    GLState::deleteTexture(texture);
+}
+
+void GLRenderDevice::bindTexture(unsigned int unit, GLenum target, unsigned int texture) {
+    GLState::bindTexture(unit, target, texture);
+}
+
+void GLRenderDevice::texParameter(GLenum target, GLenum name, int value) {
+    glTexParameteri(target, name, value);
+}
+
+void GLRenderDevice::texImage2D(GLenum target,
+                                int level,
+                                int internalFormat,
+                                int width,
+                                int height,
+                                GLenum format,
+                                GLenum type,
+                                const void* pixels) {
+    glTexImage2D(target, level, internalFormat, width, height, 0, format, type, pixels);
+}
+
+void GLRenderDevice::texImage3D(GLenum target,
+                                int level,
+                                int internalFormat,
+                                int width,
+                                int height,
+                                int depth,
+                                GLenum format,
+                                GLenum type,
+                                const void* pixels) {
+    glTexImage3D(target, level, internalFormat, width, height, depth, 0, format, type, pixels);
+}
+
+void GLRenderDevice::texSubImage2D(unsigned int unit,
+                                   unsigned int texture,
+                                   int level,
+                                   int x,
+                                   int y,
+                                   int width,
+                                   int height,
+                                   GLenum format,
+                                   GLenum type,
+                                   const void* pixels) {
+    GLState::bindTexture(unit, GL_TEXTURE_2D, texture);
+    GLState::activeTexture(unit); // The bind may have been elided on another active unit
+    glTexSubImage2D(GL_TEXTURE_2D, level, x, y, width, height, format, type, pixels);
+}
+
+void GLRenderDevice::texSubImage3D(unsigned int unit,
+                                   unsigned int texture,
+                                   int level,
+                                   int layer,
+                                   int width,
+                                   int height,
+                                   GLenum format,
+                                   GLenum type,
+                                   const void* pixels) {
+    GLState::bindTexture(unit, GL_TEXTURE_2D_ARRAY, texture);
+    GLState::activeTexture(unit); // The bind may have been elided on another active unit
+    glTexSubImage3D(
+        GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1, format, type, pixels);
+}
+
+void GLRenderDevice::generateMipmap(GLenum target) {
+    glGenerateMipmap(target);
+}
+
+void GLRenderDevice::texBuffer(unsigned int unit,
+                               unsigned int texture,
+                               GLenum internalFormat,
+                               unsigned int buffer) {
+    GLState::bindTexture(unit, GL_TEXTURE_BUFFER, texture);
+    GLState::activeTexture(unit); // The bind may have been elided on another active unit
+    glTexBuffer(GL_TEXTURE_BUFFER, internalFormat, buffer);
+}
+
+// --- Framebuffers ---
+unsigned int GLRenderDevice::createFramebuffer() {
+    unsigned int framebuffer = 0;
+    glGenFramebuffers(1, &framebuffer);
+    return framebuffer;
+}
+
+void GLRenderDevice::deleteFramebuffer(unsigned int framebuffer) {
+    GLState::deleteFramebuffer(framebuffer);
+}
+
+void GLRenderDevice::bindFramebuffer(unsigned int framebuffer) {
+    GLState::bindFramebuffer(framebuffer != 0 ? framebuffer : GLState::defaultFramebuffer());
+}
+
+void GLRenderDevice::framebufferTextureLayer(GLenum attachment,
+                                             unsigned int texture,
+                                             int level,
+                                             int layer) {
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, attachment, texture, level, layer);
+}
+
+void GLRenderDevice::framebufferTexture(GLenum attachment, unsigned int texture, int level) {
+    glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, texture, level);
+}
+
+void GLRenderDevice::drawBuffer(GLenum buffer) {
+    glDrawBuffer(buffer);
+}
+
+void GLRenderDevice::drawBuffers(GLsizei count, const GLenum* buffers) {
+    glDrawBuffers(count, buffers);
+}
+
+void GLRenderDevice::readBuffer(GLenum buffer) {
+    glReadBuffer(buffer);
+}
+
+GLenum GLRenderDevice::checkFramebufferStatus() {
+    return glCheckFramebufferStatus(GL_FRAMEBUFFER);
+}
+
+void GLRenderDevice::blitFramebuffer(unsigned int source,
+                                     unsigned int destination,
+                                     const int sourceRect[4],
+                                     const int destinationRect[4],
+                                     GLbitfield mask,
+                                     GLenum filter) {
+    unsigned int backBuffer = GLState::defaultFramebuffer();
+    GLState::bindFramebuffer(GL_READ_FRAMEBUFFER, source != 0 ? source : backBuffer);
+    GLState::bindFramebuffer(GL_DRAW_FRAMEBUFFER, destination != 0 ? destination : backBuffer);
+    glBlitFramebuffer(sourceRect[0],
+                      sourceRect[1],
+                      sourceRect[0] + sourceRect[2],
+                      sourceRect[1] + sourceRect[3],
+                      destinationRect[0],
+                      destinationRect[1],
+                      destinationRect[0] + destinationRect[2],
+                      destinationRect[1] + destinationRect[3],
+                      mask,
+                      filter);
+}
+
+// --- Programs ---
+unsigned int GLRenderDevice::compileShader(GLenum type, const char* source, std::string& log) {
+    unsigned int shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    int success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (success == 0) {
+        char infoLog[512];
+        glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+        log = infoLog;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+unsigned int GLRenderDevice::linkProgram(unsigned int vertex,
+                                         unsigned int fragment,
+                                         std::string& log) {
+    unsigned int program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    glLinkProgram(program);
+
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (success == 0) {
+        char infoLog[512];
+        glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+        log = infoLog;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+unsigned int GLRenderDevice::linkFeedbackProgram(unsigned int vertex,
+                                                 unsigned int geometry,
+                                                 const char* const* varyings,
+                                                 int varyingCount,
+                                                 std::string& log) {
+    unsigned int program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, geometry);
+    glTransformFeedbackVaryings(program, varyingCount, varyings, GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(program);
+
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (success == 0) {
+        char infoLog[512];
+        glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+        log = infoLog;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+void GLRenderDevice::deleteShader(unsigned int shader) {
+    glDeleteShader(shader);
+}
+
+void GLRenderDevice::deleteProgram(unsigned int program) {
+    GLState::deleteProgram(program);
+}
+
+void GLRenderDevice::useProgram(unsigned int program) {
+    GLState::useProgram(program);
+}
+
+int GLRenderDevice::getUniformLocation(unsigned int program, const char* name) {
+    return glGetUniformLocation(program, name);
+}
+
+void GLRenderDevice::uniformBlockBinding(unsigned int program,
+                                         const char* blockName,
+                                         unsigned int binding) {
+    unsigned int blockIndex = glGetUniformBlockIndex(program, blockName);
+    if (blockIndex != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, blockIndex, binding);
+    }
+}
+
+void GLRenderDevice::setUniform(int location, int value) {
+    glUniform1i(location, value);
+}
+
+void GLRenderDevice::setUniform(int location, float value) {
+    glUniform1f(location, value);
+}
+
+void GLRenderDevice::setUniform(int location, const glm::vec2& value) {
+    glUniform2f(location, value.x, value.y);
+}
+
+void GLRenderDevice::setUniform(int location, const glm::vec4& value) {
+    glUniform4f(location, value.x, value.y, value.z, value.w);
+}
+
+void GLRenderDevice::setUniform(int location, const glm::mat4& value) {
+    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+// --- Fixed-function state ---
+void GLRenderDevice::setEnabled(GLenum capability, bool enabled) {
+    GLState::setEnabled(capability, enabled);
+}
+
+void GLRenderDevice::depthMask(bool enabled) {
+    GLState::depthMask(enabled);
+}
+
+void GLRenderDevice::colorMask(bool enabled) {
+    GLState::colorMask(enabled);
+}
+
+void GLRenderDevice::depthFunc(GLenum func) {
+    GLState::depthFunc(func);
+}
+
+void GLRenderDevice::blendFunc(GLenum source, GLenum destination) {
+    GLState::blendFunc(source, destination);
+}
+
+void GLRenderDevice::blendFuncSeparate(GLenum sourceColor,
+                                       GLenum destinationColor,
+                                       GLenum sourceAlpha,
+                                       GLenum destinationAlpha) {
+    GLState::blendFuncSeparate(sourceColor, destinationColor, sourceAlpha, destinationAlpha);
+}
+
+void GLRenderDevice::polygonOffset(float factor, float units) {
+    glPolygonOffset(factor, units);
+}
+
+void GLRenderDevice::viewport(int x, int y, int width, int height) {
+    GLState::viewport(x, y, width, height);
+}
+
+// --- Drawing ---
+void GLRenderDevice::clear(const glm::vec4& color, GLbitfield mask) {
+    glClearColor(color.r, color.g, color.b, color.a);
+    glClear(mask);
+}
+
+void GLRenderDevice::drawArrays(GLenum mode, int first, GLsizei count) {
+    glDrawArrays(mode, first, count);
+}
+
+void GLRenderDevice::drawArraysInstanced(GLenum mode,
+                                         int first,
+                                         GLsizei count,
+                                         GLsizei instances) {
+    glDrawArraysInstanced(mode, first, count, instances);
+}
+
+void GLRenderDevice::beginTransformFeedback(GLenum primitiveMode) {
+    glBeginTransformFeedback(primitiveMode);
+}
+
+void GLRenderDevice::endTransformFeedback() {
+    glEndTransformFeedback();
+}
+
+void GLRenderDevice::finish() {
+    glFinish();
+}
+
+int GLRenderDevice::getInteger(GLenum name) {
+    GLint value = 0;
+    glGetIntegerv(name, &value);
+    return value;
+}
+
+void GLRenderDevice::getViewport(int viewport[4]) {
+    // Queried rather than shadowed: GLState can't know the window's initial viewport
+    glGetIntegerv(GL_VIEWPORT, viewport);
+}
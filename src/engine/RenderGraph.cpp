@@ -0,0 +1,466 @@
+#include "engine/RenderGraph.h"
+
+#include <algorithm>
+#include <iostream>
+#include <engine/RenderDevice.h>
+
+namespace {
+// No sampler uses it, so creating a texture disturbs no binding a pass relies on
+constexpr unsigned int UPLOAD_UNIT = 15;
+
+uint64_t bytesPerPixel(int internalFormat) {
+    switch (internalFormat) {
+    case GL_R8:
+        return 1;
+    case GL_R16F:
+    case GL_RG8:
+        return 2;
+    case GL_RGBA16F:
+    case GL_RG32F:
+        return 8;
+    case GL_RGBA32F:
+        return 16;
+    default:
+        return 4; // RGBA8, R32F, DEPTH_COMPONENT24/32F, DEPTH24_STENCIL8
+    }
+}
+} // namespace
+
+// --- PassBuilder ---
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::read(Resource resource) {
+    graph.addAccess(pass, resource, Access::Read);
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::write(Resource resource) {
+    graph.addAccess(pass, resource, Access::Write);
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::writeDepth(Resource resource) {
+    graph.addAccess(pass, resource, Access::WriteDepth);
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::readDepth(Resource resource) {
+    graph.addAccess(pass, resource, Access::ReadDepth);
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::modify(Resource resource) {
+    graph.addAccess(pass, resource, Access::Modify);
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::viewport(int width, int height) {
+    graph.passes[pass].viewportWidth = width;
+    graph.passes[pass].viewportHeight = height;
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::sideEffect() {
+    graph.passes[pass].sideEffect = true;
+    return *this;
+}
+
+// --- RenderGraph ---
+void RenderGraph::beginFrame(const int viewport[4]) {
+    passCount = 0;
+    resources.clear();
+    std::copy(viewport, viewport + 4, backBufferViewport);
+
+    ResourceEntry backBuffer;
+    backBuffer.name = "backBuffer";
+    backBuffer.desc.width = viewport[2];
+    backBuffer.desc.height = viewport[3];
+    backBuffer.imported = true;
+    resources.push_back(backBuffer);
+}
+
+RenderGraph::Resource
+RenderGraph::importTexture(const char* name, unsigned int texture, int width, int height) {
+    ResourceEntry entry;
+    entry.name = name;
+    entry.desc.width = width;
+    entry.desc.height = height;
+    entry.texture = texture;
+    entry.imported = true;
+    resources.push_back(entry);
+    return static_cast<Resource>(resources.size() - 1);
+}
+
+RenderGraph::Resource RenderGraph::createTexture(const char* name, const RenderTargetDesc& desc) {
+    ResourceEntry entry;
+    entry.name = name;
+    entry.desc = desc;
+    entry.desc.width = std::max(desc.width, 1);
+    entry.desc.height = std::max(desc.height, 1);
+    resources.push_back(entry);
+    return static_cast<Resource>(resources.size() - 1);
+}
+
+RenderGraph::PassBuilder RenderGraph::addPass(const char* name,
+                                              std::function<void(RenderGraph&)> execute) {
+    if (passCount == passes.size()) {
+        passes.emplace_back();
+    }
+    Pass& pass = passes[passCount];
+    pass.name = name;
+    pass.execute = std::move(execute);
+    pass.accesses.clear();
+    pass.producers.clear();
+    pass.viewportWidth = 0;
+    pass.viewportHeight = 0;
+    pass.sideEffect = false;
+    pass.live = false;
+    return PassBuilder(*this, passCount++);
+}
+
+void RenderGraph::addAccess(uint32_t index, Resource resource, Access access) {
+    if (resource >= resources.size()) {
+        std::cerr << "ERROR::RENDER_GRAPH::UNKNOWN_RESOURCE " << resource << " in pass "
+                  << passes[index].name << "\n";
+        return;
+    }
+
+    Pass& pass = passes[index];
+    pass.accesses.push_back(PassAccess{resource, access});
+    ResourceEntry& entry = resources[resource];
+    // Writes load what is there, so readers and writers alike depend on the last writer
+    if (entry.lastWriter >= 0 && uint32_t(entry.lastWriter) != index) {
+        pass.producers.push_back(uint32_t(entry.lastWriter));
+    }
+    if (isWrite(access)) {
+        entry.lastWriter = static_cast<int>(index);
+    }
+}
+
+void RenderGraph::cull() {
+    std::vector<uint32_t>& pending = schedule; // Reused as the work list, rebuilt afterwards
+    pending.clear();
+    for (uint32_t i = 0; i < passCount; ++i) {
+        Pass& pass = passes[i];
+        pass.live = pass.sideEffect;
+        for (const PassAccess& access : pass.accesses) {
+            if (isWrite(access.access) && resources[access.resource].imported) {
+                pass.live = true;
+            }
+        }
+        if (pass.live) {
+            pending.push_back(i);
+        }
+    }
+
+    while (!pending.empty()) {
+        uint32_t index = pending.back();
+        pending.pop_back();
+        for (uint32_t producer : passes[index].producers) {
+            if (!passes[producer].live) {
+                passes[producer].live = true;
+                pending.push_back(producer);
+            }
+        }
+    }
+
+    culledCount = 0;
+    for (uint32_t i = 0; i < passCount; ++i) {
+        culledCount += passes[i].live ? 0 : 1;
+    }
+}
+
+void RenderGraph::buildSchedule() {
+    flow.clear();
+    for (uint32_t i = 0; i < passCount; ++i) {
+        if (!passes[i].live) {
+            continue;
+        }
+        flow.bind(i);
+        for (const PassAccess& access : passes[i].accesses) {
+            if (isWrite(access.access)) {
+                flow.rw(access.resource);
+            } else {
+                flow.ro(access.resource);
+            }
+        }
+    }
+
+    // Kahn's algorithm, always taking the earliest declared pass that is ready
+    const auto graph = flow.graph();
+    size_t count = flow.size();
+    std::vector<uint32_t> inDegree(count, 0);
+    for (auto [from, to] : graph.edges()) {
+        (void)from;
+        ++inDegree[to];
+    }
+    std::vector<bool> done(count, false);
+    schedule.clear();
+    while (schedule.size() < count) {
+        size_t next = count;
+        for (size_t vertex = 0; vertex < count; ++vertex) {
+            if (!done[vertex] && inDegree[vertex] == 0) {
+                next = vertex;
+                break;
+            }
+        }
+        if (next == count) {
+            // Can't happen with accesses declared in order, but don't spin if it ever does
+            std::cerr << "ERROR::RENDER_GRAPH::CYCLE\n";
+            break;
+        }
+        done[next] = true;
+        schedule.push_back(static_cast<uint32_t>(flow[next]));
+        for (auto [from, to] : graph.out_edges(next)) {
+            (void)from;
+            --inDegree[to];
+        }
+    }
+}
+
+void RenderGraph::execute() {
+    cull();
+    buildSchedule();
+
+    for (ResourceEntry& entry : resources) {
+        entry.firstUse = -1;
+        entry.lastUse = -1;
+    }
+    for (size_t position = 0; position < schedule.size(); ++position) {
+        for (const PassAccess& access : passes[schedule[position]].accesses) {
+            ResourceEntry& entry = resources[access.resource];
+            if (entry.firstUse < 0) {
+                entry.firstUse = static_cast<int>(position);
+            }
+            entry.lastUse = static_cast<int>(position);
+        }
+    }
+
+    executedCount = 0;
+    for (size_t position = 0; position < schedule.size(); ++position) {
+        Pass& pass = passes[schedule[position]];
+        for (const PassAccess& access : pass.accesses) {
+            ResourceEntry& entry = resources[access.resource];
+            if (!entry.imported && entry.firstUse == int(position) && entry.pooled < 0) {
+                acquire(entry);
+            }
+        }
+
+        if (bindAttachments(pass)) {
+            GpuProfiler::Scope scope(profiler, pass.name);
+            pass.execute(*this);
+            ++executedCount;
+        }
+
+        // Hand back whatever no later pass uses, so it can alias the next transient
+        for (const PassAccess& access : pass.accesses) {
+            ResourceEntry& entry = resources[access.resource];
+            if (!entry.imported && entry.lastUse == int(position) && entry.pooled >= 0) {
+                releaseTransient(entry);
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < passCount; ++i) {
+        passes[i].execute = nullptr; // Don't hold on to the frame's captures
+    }
+    evict();
+    ++frame;
+}
+
+unsigned int RenderGraph::getTexture(Resource resource) const {
+    return resource < resources.size() ? resources[resource].texture : 0;
+}
+
+unsigned int RenderGraph::getReadFramebuffer(Resource resource) {
+    unsigned int texture = getTexture(resource);
+    if (texture == 0) {
+        return 0;
+    }
+    const CachedFramebuffer* cached = findFramebuffer(&texture, 1, 0);
+    return cached->complete ? cached->framebuffer : 0;
+}
+
+uint64_t RenderGraph::getPoolBytes() const {
+    uint64_t bytes = 0;
+    for (const PooledTexture& slot : pool) {
+        bytes += uint64_t(slot.desc.width) * uint64_t(slot.desc.height) *
+                 bytesPerPixel(slot.desc.internalFormat);
+    }
+    return bytes;
+}
+
+void RenderGraph::acquire(ResourceEntry& entry) {
+    for (size_t i = 0; i < pool.size(); ++i) {
+        if (!pool[i].inUse && pool[i].desc == entry.desc) {
+            pool[i].inUse = true;
+            pool[i].lastUsed = frame;
+            entry.pooled = static_cast<int>(i);
+            entry.texture = pool[i].texture;
+            return;
+        }
+    }
+
+    RenderDevice& device = RenderDevice::current();
+    const RenderTargetDesc& desc = entry.desc;
+    PooledTexture slot;
+    slot.desc = desc;
+    slot.texture = device.createTexture();
+    slot.lastUsed = frame;
+    slot.inUse = true;
+    device.bindTexture(UPLOAD_UNIT, GL_TEXTURE_2D, slot.texture);
+    device.texImage2D(GL_TEXTURE_2D,
+                      0,
+                      desc.internalFormat,
+                      desc.width,
+                      desc.height,
+                      desc.format,
+                      desc.type,
+                      nullptr);
+    device.texParameter(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, desc.filter);
+    device.texParameter(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, desc.filter);
+    device.texParameter(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    device.texParameter(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    pool.push_back(slot);
+    entry.pooled = static_cast<int>(pool.size() - 1);
+    entry.texture = slot.texture;
+}
+
+void RenderGraph::releaseTransient(ResourceEntry& entry) {
+    pool[entry.pooled].inUse = false;
+    entry.pooled = -1;
+}
+
+void RenderGraph::evict() {
+    RenderDevice& device = RenderDevice::current();
+    auto stale = [this](const PooledTexture& slot) {
+        return !slot.inUse && frame - slot.lastUsed >= EVICT_FRAMES;
+    };
+    for (const PooledTexture& slot : pool) {
+        if (!stale(slot)) {
+            continue;
+        }
+        auto attached = [&slot](const CachedFramebuffer& cached) {
+            return cached.depth == slot.texture ||
+                   std::find(cached.colors, cached.colors + cached.colorCount, slot.texture) !=
+                       cached.colors + cached.colorCount;
+        };
+        for (const CachedFramebuffer& cached : framebuffers) {
+            if (attached(cached)) {
+                device.deleteFramebuffer(cached.framebuffer);
+            }
+        }
+        framebuffers.erase(std::remove_if(framebuffers.begin(), framebuffers.end(), attached),
+                           framebuffers.end());
+        device.deleteTexture(slot.texture);
+    }
+    pool.erase(std::remove_if(pool.begin(), pool.end(), stale), pool.end());
+}
+
+bool RenderGraph::bindAttachments(const Pass& pass) {
+    unsigned int colors[MAX_COLOR_ATTACHMENTS] = {};
+    int colorCount = 0;
+    unsigned int depth = 0;
+    bool backBuffer = false;
+    const ResourceEntry* sized = nullptr; // First attachment, gives the viewport size
+    for (const PassAccess& access : pass.accesses) {
+        if (access.access == Access::Read || access.access == Access::Modify) {
+            continue;
+        }
+        const ResourceEntry& entry = resources[access.resource];
+        if (access.resource == BACK_BUFFER) {
+            backBuffer = true;
+        } else if (access.access != Access::Write) {
+            depth = entry.texture;
+        } else if (colorCount < MAX_COLOR_ATTACHMENTS) {
+            colors[colorCount++] = entry.texture;
+        } else {
+            std::cerr << "ERROR::RENDER_GRAPH::TOO_MANY_ATTACHMENTS in pass " << pass.name << "\n";
+            return false;
+        }
+        sized = sized != nullptr ? sized : &entry;
+    }
+    if (sized == nullptr) {
+        return true; // The pass binds its own targets, if any
+    }
+
+    RenderDevice& device = RenderDevice::current();
+    if (backBuffer) {
+        if (colorCount > 0 || depth != 0) {
+            std::cerr << "ERROR::RENDER_GRAPH::BACK_BUFFER_MIXED_WITH_TEXTURES in pass "
+                      << pass.name << "\n";
+            return false;
+        }
+        device.bindFramebuffer(0);
+        device.viewport(backBufferViewport[0],
+                        backBufferViewport[1],
+                        pass.viewportWidth > 0 ? pass.viewportWidth : backBufferViewport[2],
+                        pass.viewportHeight > 0 ? pass.viewportHeight : backBufferViewport[3]);
+        return true;
+    }
+
+    const CachedFramebuffer* cached = findFramebuffer(colors, colorCount, depth);
+    if (!cached->complete) {
+        return false;
+    }
+    device.bindFramebuffer(cached->framebuffer);
+    device.viewport(0,
+                    0,
+                    pass.viewportWidth > 0 ? pass.viewportWidth : sized->desc.width,
+                    pass.viewportHeight > 0 ? pass.viewportHeight : sized->desc.height);
+    return true;
+}
+
+const RenderGraph::CachedFramebuffer*
+RenderGraph::findFramebuffer(const unsigned int* colors, int colorCount, unsigned int depth) {
+    for (const CachedFramebuffer& cached : framebuffers) {
+        if (cached.colorCount == colorCount && cached.depth == depth &&
+            std::equal(colors, colors + colorCount, cached.colors)) {
+            return &cached;
+        }
+    }
+
+    RenderDevice& device = RenderDevice::current();
+    CachedFramebuffer cached;
+    std::copy(colors, colors + colorCount, cached.colors);
+    cached.colorCount = colorCount;
+    cached.depth = depth;
+    cached.framebuffer = device.createFramebuffer();
+    device.bindFramebuffer(cached.framebuffer);
+
+    GLenum drawBuffers[MAX_COLOR_ATTACHMENTS];
+    for (int i = 0; i < colorCount; ++i) {
+        device.framebufferTexture(GL_COLOR_ATTACHMENT0 + i, colors[i], 0);
+        drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+    }
+    if (depth != 0) {
+        device.framebufferTexture(GL_DEPTH_ATTACHMENT, depth, 0);
+    }
+    if (colorCount > 0) {
+        device.drawBuffers(colorCount, drawBuffers);
+    } else {
+        device.drawBuffer(GL_NONE);
+        device.readBuffer(GL_NONE);
+    }
+
+    // Kept even when incomplete, so the error is reported once rather than every frame
+    cached.complete = device.checkFramebufferStatus() == GL_FRAMEBUFFER_COMPLETE;
+    if (!cached.complete) {
+        std::cerr << "ERROR::RENDER_GRAPH::FRAMEBUFFER_INCOMPLETE\n";
+    }
+    framebuffers.push_back(cached);
+    return &framebuffers.back();
+}
+
+void RenderGraph::release() {
+    RenderDevice& device = RenderDevice::current();
+    for (const CachedFramebuffer& cached : framebuffers) {
+        device.deleteFramebuffer(cached.framebuffer);
+    }
+    framebuffers.clear();
+    for (const PooledTexture& slot : pool) {
+        device.deleteTexture(slot.texture);
+    }
+    pool.clear();
+    for (ResourceEntry& entry : resources) {
+        entry.pooled = -1;
+    }
+}
@@ -0,0 +1,69 @@
+#include "engine/SceneTarget.h"
+
+#include <algorithm>
+#include <cmath>
+#include <engine/RenderDevice.h>
+#include <engine/Shader.h>
+
+void SceneTarget::declare(RenderGraph& graph, const int backBufferViewport[4], float scale) {
+    std::copy(backBufferViewport, backBufferViewport + 4, viewport);
+    width = std::max(viewport[2], 1);
+    height = std::max(viewport[3], 1);
+    scale = std::max(0.0f, std::min(scale, 1.0f));
+    renderWidth = std::max(1, int(std::floor(width * scale + 0.5f)));
+    renderHeight = std::max(1, int(std::floor(height * scale + 0.5f)));
+
+    // Color is filtered when it is upscaled
+    RenderTargetDesc desc;
+    desc.width = width;
+    desc.height = height;
+    desc.filter = GL_LINEAR;
+    color = graph.createTexture("sceneColor", desc);
+    desc.internalFormat = GL_DEPTH_COMPONENT24;
+    desc.format = GL_DEPTH_COMPONENT;
+    desc.type = GL_FLOAT;
+    desc.filter = GL_NEAREST;
+    depth = graph.createTexture("sceneDepth", desc);
+}
+
+void SceneTarget::addPresentPass(RenderGraph& graph, const Shader* upscale) {
+    graph.addPass("present", [this, upscale](RenderGraph& frame) { present(frame, upscale); })
+        .read(color)
+        .write(RenderGraph::BACK_BUFFER);
+}
+
+void SceneTarget::present(RenderGraph& graph, const Shader* upscale) {
+    RenderDevice& device = RenderDevice::current();
+    bool scaled = renderWidth != viewport[2] || renderHeight != viewport[3];
+    if (!scaled || upscale == nullptr) {
+        const int source[4] = {0, 0, renderWidth, renderHeight};
+        device.blitFramebuffer(graph.getReadFramebuffer(color),
+                               0,
+                               source,
+                               viewport,
+                               GL_COLOR_BUFFER_BIT,
+                               scaled ? GL_LINEAR : GL_NEAREST);
+        device.bindFramebuffer(0);
+        return;
+    }
+
+    if (emptyVAO == 0) {
+        emptyVAO = device.createVertexArray();
+    }
+    device.setEnabled(GL_DEPTH_TEST, false);
+    upscale->use();
+    upscale->setVec2("sourceSize", glm::vec2(renderWidth, renderHeight));
+    upscale->setVec2("textureScale",
+                     glm::vec2(float(renderWidth) / width, float(renderHeight) / height));
+    device.bindTexture(COLOR_UNIT, GL_TEXTURE_2D, graph.getTexture(color));
+    device.bindVertexArray(emptyVAO);
+    device.drawArrays(GL_TRIANGLES, 0, 3); // One triangle covering the screen, see the shader
+    device.setEnabled(GL_DEPTH_TEST, true);
+}
+
+void SceneTarget::release() {
+    if (emptyVAO != 0) {
+        RenderDevice::current().deleteVertexArray(emptyVAO);
+        emptyVAO = 0;
+    }
+}
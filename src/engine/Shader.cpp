@@ -1,4 +1,11 @@
 #include "engine/Shader.h"
+#include "engine/FrameUniforms.h"
+#include "engine/ClusteredLighting.h"
+#include "engine/ShadowMaps.h"
+#include "engine/Transparency.h"
+#include "engine/SceneTarget.h"
+#include "engine/TextureArray.h"
+#include "engine/RenderDevice.h"
 
 std::stringstream Shader::readShaderFile(const char* shaderPath) {
     std::ifstream shaderFile;
@@ -16,15 +23,9 @@ std::stringstream Shader::readShaderFile(const char* shaderPath) {
 }
 
 ShaderType Shader::compileShader(const char* shaderCode, GLenum shaderType) {
-    unsigned int shader = glCreateShader(shaderType);
-    glShaderSource(shader, 1, &shaderCode, NULL);
-    glCompileShader(shader);
-
-    int success;
-    char infoLog[Shader::INFOLOG_SIZE];
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (success == 0) {
-        glGetShaderInfoLog(shader, Shader::INFOLOG_SIZE, NULL, infoLog);
+    std::string infoLog;
+    unsigned int shader = RenderDevice::current().compileShader(shaderType, shaderCode, infoLog);
+    if (shader == 0) {
         std::cerr << "ERROR::SHADER::COMPILATION_FAILED\n" << infoLog << '\n';
         return ShaderType{0, shaderType}; // Return an invalid ShaderType on failure
     }
@@ -33,39 +34,31 @@ ShaderType Shader::compileShader(const char* shaderCode, GLenum shaderType) {
 }
 
 unsigned int Shader::createShaderProgram(const ShaderType& vertex, const ShaderType& fragment) {
-    unsigned int programId = glCreateProgram();
-    char infoLog[Shader::INFOLOG_SIZE];
-    int success;
-
-    glAttachShader(programId, vertex.id);
-    glAttachShader(programId, fragment.id);
-    glLinkProgram(programId);
-
-    glGetProgramiv(programId, GL_LINK_STATUS, &success);
-    if (success == 0) {
-        glGetProgramInfoLog(programId, Shader::INFOLOG_SIZE, NULL, infoLog);
+    RenderDevice& device = RenderDevice::current();
+    std::string infoLog;
+    unsigned int programId = device.linkProgram(vertex.id, fragment.id, infoLog);
+    if (programId == 0) {
         std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << '\n';
         return 0; // Return 0 on failure
     }
 
-    glDeleteShader(vertex.id);
-    glDeleteShader(fragment.id);
+    device.deleteShader(vertex.id);
+    device.deleteShader(fragment.id);
 
     return programId;
 }
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath) {
-    unsigned int programId;
-    std::string vertexCode;
-    std::string fragmentCode;
-    std::stringstream vShaderStream = readShaderFile(vertexPath);
-    std::stringstream fShaderStream = readShaderFile(fragmentPath);
+ShaderSource Shader::readSource(const char* vertexPath, const char* fragmentPath) {
+    return ShaderSource{readShaderFile(vertexPath).str(), readShaderFile(fragmentPath).str()};
+}
 
-    vertexCode = vShaderStream.str();
-    fragmentCode = fShaderStream.str();
+Shader::Shader(const char* vertexPath, const char* fragmentPath)
+    : Shader(readSource(vertexPath, fragmentPath)) {}
 
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
+Shader::Shader(const ShaderSource& source) {
+    unsigned int programId;
+    const char* vShaderCode = source.vertex.c_str();
+    const char* fShaderCode = source.fragment.c_str();
 
     // Next we need to compile the shaders
     ShaderType vertex;
@@ -91,13 +84,30 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath) {
 
     this->SHADERPROGRAMID = programId;
 
+    // Every program reads per-frame data from the same UBO binding
+    bindUniformBlock(FrameUniformBuffer::BLOCK_NAME, FrameUniformBuffer::BINDING);
+
+    // Clustered lighting, shadow, transparency and scene inputs sit at fixed units too; unused
+    // names are ignored
+    bindUniformBlock(LightBuffers::BLOCK_NAME, LightBuffers::BINDING);
+    bindUniformBlock(ShadowMaps::BLOCK_NAME, ShadowMaps::BINDING);
+    use();
+    setInt(LightBuffers::CLUSTER_SAMPLER, LightBuffers::CLUSTER_UNIT);
+    setInt(LightBuffers::INDEX_SAMPLER, LightBuffers::INDEX_UNIT);
+    setInt(LightBuffers::LIGHT_SAMPLER, LightBuffers::LIGHT_UNIT);
+    setInt(ShadowMaps::SAMPLER, ShadowMaps::UNIT);
+    setInt(WeightedTransparency::ACCUMULATION_SAMPLER, WeightedTransparency::ACCUMULATION_UNIT);
+    setInt(WeightedTransparency::WEIGHT_SAMPLER, WeightedTransparency::WEIGHT_UNIT);
+    setInt(SceneTarget::COLOR_SAMPLER, SceneTarget::COLOR_UNIT);
+    setInt(TextureArrayPool::SAMPLER, TextureArrayPool::UNIT);
+
     std::cout << "Shader program created successfully with SHADERPROGRAMID: "
               << this->SHADERPROGRAMID << '\n';
 }
 
 Shader::~Shader() {
     if (SHADERPROGRAMID != 0) {
-        glDeleteProgram(SHADERPROGRAMID);
+        RenderDevice::current().deleteProgram(SHADERPROGRAMID);
     }
 }
 
@@ -108,26 +118,45 @@ void Shader::use() const {
                "the shader "
                "was compiled and linked successfully.\n";
     }
-    glUseProgram(this->SHADERPROGRAMID);
+    RenderDevice::current().useProgram(this->SHADERPROGRAMID);
 }
 
 void Shader::setBool(const std::string& name, bool value) const {
-    glUniform1i(glGetUniformLocation(this->SHADERPROGRAMID, name.c_str()), (int)value);
+    RenderDevice::current().setUniform(getUniformLocation(name), (int)value);
 }
 
 void Shader::setInt(const std::string& name, int value) const {
-    glUniform1i(glGetUniformLocation(this->SHADERPROGRAMID, name.c_str()), value);
+    RenderDevice::current().setUniform(getUniformLocation(name), value);
 }
 
 void Shader::setFloat(const std::string& name, float value) const {
-    glUniform1f(glGetUniformLocation(this->SHADERPROGRAMID, name.c_str()), value);
+    RenderDevice::current().setUniform(getUniformLocation(name), value);
+}
+
+void Shader::setVec2(const std::string& name, const glm::vec2& value) const {
+    RenderDevice::current().setUniform(getUniformLocation(name), value);
+}
+
+void Shader::setVec4(const std::string& name, const glm::vec4& value) const {
+    RenderDevice::current().setUniform(getUniformLocation(name), value);
 }
 
 void Shader::setMat4(const std::string& name, const glm::mat4& mat) const {
-    glUniformMatrix4fv(glGetUniformLocation(this->SHADERPROGRAMID, name.c_str()),
-                       1,
-                       GL_FALSE,
-                       glm::value_ptr(mat));
+    RenderDevice::current().setUniform(getUniformLocation(name), mat);
+}
+
+void Shader::bindUniformBlock(const char* blockName, unsigned int binding) const {
+    RenderDevice::current().uniformBlockBinding(this->SHADERPROGRAMID, blockName, binding);
+}
+
+int Shader::getUniformLocation(const std::string& name) const {
+    auto it = uniformLocations.find(name);
+    if (it != uniformLocations.end()) {
+        return it->second;
+    }
+    int location = RenderDevice::current().getUniformLocation(this->SHADERPROGRAMID, name.c_str());
+    uniformLocations.emplace(name, location);
+    return location;
 }
 
 unsigned int Shader::getShaderProgramID() const {
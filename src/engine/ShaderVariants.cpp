@@ -0,0 +1,90 @@
+#include "engine/ShaderVariants.h"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+ShaderVariants::ShaderVariants(const char* vertexPath, const char* fragmentPath)
+    : source(Shader::readSource(vertexPath, fragmentPath)) {
+    parseKeywords(source.vertex);
+    parseKeywords(source.fragment);
+}
+
+uint32_t ShaderVariants::getFeature(const std::string& keyword) const {
+    auto it = std::find(keywords.begin(), keywords.end(), keyword);
+    if (it == keywords.end()) {
+        std::cerr << "ERROR::SHADER_VARIANTS::UNKNOWN_FEATURE: " << keyword << '\n';
+        return 0;
+    }
+    return uint32_t(1) << (it - keywords.begin());
+}
+
+uint32_t ShaderVariants::getFeatures(std::initializer_list<const char*> keywords) const {
+    uint32_t features = 0;
+    for (const char* keyword : keywords) {
+        features |= getFeature(keyword);
+    }
+    return features;
+}
+
+Shader& ShaderVariants::get(uint32_t features) {
+    if (keywords.size() < MAX_FEATURES) {
+        features &= (uint32_t(1) << keywords.size()) - 1;
+    }
+    std::unique_ptr<Shader>& variant = variants[features];
+    if (!variant) {
+        ShaderSource code{inject(source.vertex, features), inject(source.fragment, features)};
+        variant = std::make_unique<Shader>(code);
+    }
+    return *variant;
+}
+
+void ShaderVariants::parseKeywords(const std::string& code) {
+    std::istringstream lines(code);
+    std::string line;
+    while (std::getline(lines, line)) {
+        std::istringstream words(line);
+        std::string directive;
+        std::string pragma;
+        if (!(words >> directive >> pragma) || directive != "#pragma" || pragma != "features") {
+            continue;
+        }
+        std::string keyword;
+        while (words >> keyword) {
+            if (std::find(keywords.begin(), keywords.end(), keyword) != keywords.end()) {
+                continue; // Declared by both stages
+            }
+            if (keywords.size() == MAX_FEATURES) {
+                std::cerr << "ERROR::SHADER_VARIANTS::TOO_MANY_FEATURES: " << keyword << '\n';
+                continue;
+            }
+            keywords.push_back(keyword);
+        }
+    }
+}
+
+std::string ShaderVariants::inject(const std::string& code, uint32_t features) const {
+    if (features == 0) {
+        return code;
+    }
+
+    // #version has to stay first; #line keeps compiler messages pointing at the file's lines
+    size_t versionEnd = 0;
+    size_t version = code.find("#version");
+    if (version != std::string::npos) {
+        versionEnd = code.find('\n', version);
+        versionEnd = versionEnd == std::string::npos ? code.size() : versionEnd + 1;
+    }
+    long line = 1 + std::count(code.begin(), code.begin() + versionEnd, '\n');
+    std::string defines;
+    for (size_t bit = 0; bit < keywords.size(); ++bit) {
+        if (features & (uint32_t(1) << bit)) {
+            defines += "#define " + keywords[bit] + '\n';
+        }
+    }
+    defines += "#line " + std::to_string(line) + '\n';
+
+    std::string result = code;
+    result.insert(versionEnd, defines);
+    return result;
+}
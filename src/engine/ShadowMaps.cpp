@@ -0,0 +1,194 @@
+#include "engine/ShadowMaps.h"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <engine/RenderDevice.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+constexpr float SNAP_FRACTION = 0.125f; ///< Cascade boxes move in steps of this much of their width
+constexpr float DEPTH_BIAS = 0.0005f;
+constexpr float NORMAL_OFFSET_TEXELS = 1.5f;
+
+// Maps clip space [-1, 1] to texture coordinates and depth [0, 1]
+const glm::mat4 CLIP_TO_TEXTURE = glm::scale(
+    glm::translate(glm::mat4(1.0f), glm::vec3(0.5f)), glm::vec3(0.5f));
+
+float snap(float value, float step) {
+    return std::floor(value / step + 0.5f) * step;
+}
+
+bool sameCasters(const std::vector<ShadowCaster>& a, const std::vector<ShadowCaster>& b) {
+    return a.size() == b.size() &&
+           (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(ShadowCaster)) == 0);
+}
+} // namespace
+
+// --- CascadedShadowMap ---
+void CascadedShadowMap::fit(const glm::mat4& view,
+                            float fovY,
+                            float aspect,
+                            float nearPlane,
+                            const glm::vec3& lightDirection,
+                            ShadowFrame& out) const {
+    glm::mat4 cameraToWorld = glm::inverse(view);
+    glm::vec3 direction = glm::normalize(lightDirection);
+    glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+    // Anchored at the origin so snapped positions mean the same thing every frame
+    glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), direction, up);
+
+    float farPlane = std::max(shadowDistance, nearPlane * 2.0f);
+    float tanY = std::tan(fovY * 0.5f);
+    float tanX = tanY * aspect;
+    float slope = tanX * tanX + tanY * tanY; // Squared corner offset per unit of depth
+
+    float sliceNear = nearPlane;
+    for (int cascade = 0; cascade < CASCADE_COUNT; ++cascade) {
+        float t = float(cascade + 1) / CASCADE_COUNT;
+        float logarithmic = nearPlane * std::pow(farPlane / nearPlane, t);
+        float uniform = nearPlane + (farPlane - nearPlane) * t;
+        float sliceFar = splitLambda * logarithmic + (1.0f - splitLambda) * uniform;
+
+        // Smallest sphere through the slice's near and far corners, centered on the view axis;
+        // it only depends on the projection, so it doesn't change as the camera turns
+        float centerDepth = std::min((1.0f + slope) * (sliceNear + sliceFar) * 0.5f, sliceFar);
+        float toNear = sliceNear - centerDepth;
+        float toFar = sliceFar - centerDepth;
+        float radius = std::sqrt(std::max(slope * sliceNear * sliceNear + toNear * toNear,
+                                          slope * sliceFar * sliceFar + toFar * toFar));
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+
+        // Snapping moves the box up to half a step (a sixteenth of its width) on each axis;
+        // grow it by as much so the sphere always stays inside
+        float extent = radius / (1.0f - SNAP_FRACTION);
+        float step = 2.0f * extent * SNAP_FRACTION;
+        glm::vec3 center = cameraToWorld * glm::vec4(0.0f, 0.0f, -centerDepth, 1.0f);
+        glm::vec3 lightCenter = lightView * glm::vec4(center, 1.0f);
+        lightCenter = glm::vec3(
+            snap(lightCenter.x, step), snap(lightCenter.y, step), snap(lightCenter.z, step));
+
+        // Light space looks down -Z; the near plane reaches back to casters between the
+        // slice and the light
+        glm::mat4 projection = glm::ortho(lightCenter.x - extent,
+                                          lightCenter.x + extent,
+                                          lightCenter.y - extent,
+                                          lightCenter.y + extent,
+                                          -lightCenter.z - extent - casterDistance,
+                                          -lightCenter.z + extent);
+        out.lightViewProj[cascade] = projection * lightView;
+        out.data.cascades[cascade] = CLIP_TO_TEXTURE * out.lightViewProj[cascade] * cameraToWorld;
+        out.data.splits[cascade] = sliceFar;
+        out.data.texelSizes[cascade] = 2.0f * extent / RESOLUTION;
+        sliceNear = sliceFar;
+    }
+
+    out.data.params.y = CASCADE_COUNT;
+    out.data.bias = glm::vec4(DEPTH_BIAS, 1.0f / RESOLUTION, NORMAL_OFFSET_TEXELS, 0.0f);
+}
+
+bool CascadedShadowMap::update(int cascade,
+                               const glm::mat4& viewProj,
+                               const std::vector<ShadowCaster>& casters) {
+    CachedCascade& cached = cache[cascade];
+    if (cached.valid && cached.viewProj == viewProj && sameCasters(cached.casters, casters)) {
+        return false;
+    }
+    cached.valid = true;
+    cached.viewProj = viewProj;
+    cached.casters = casters;
+    return true;
+}
+
+void CascadedShadowMap::invalidate() {
+    for (CachedCascade& cached : cache) {
+        cached.valid = false;
+        cached.casters.clear();
+    }
+}
+
+// --- ShadowMaps ---
+bool ShadowMaps::create() {
+    RenderDevice& device = RenderDevice::current();
+    texture = device.createTexture();
+    device.bindTexture(UNIT, GL_TEXTURE_2D_ARRAY, texture);
+    device.texImage3D(GL_TEXTURE_2D_ARRAY,
+                      0,
+                      GL_DEPTH_COMPONENT24,
+                      CascadedShadowMap::RESOLUTION,
+                      CascadedShadowMap::RESOLUTION,
+                      CascadedShadowMap::CASCADE_COUNT,
+                      GL_DEPTH_COMPONENT,
+                      GL_FLOAT,
+                      nullptr);
+    // Linear filtering with comparison gives 2x2 PCF for free
+    device.texParameter(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    device.texParameter(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    device.texParameter(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    device.texParameter(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    device.texParameter(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    device.texParameter(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+    framebuffer = device.createFramebuffer();
+    device.bindFramebuffer(framebuffer);
+    device.framebufferTextureLayer(GL_DEPTH_ATTACHMENT, texture, 0, 0);
+    device.drawBuffer(GL_NONE);
+    device.readBuffer(GL_NONE);
+    if (device.checkFramebufferStatus() != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "ERROR::SHADOWS::FRAMEBUFFER_INCOMPLETE, shadows disabled\n";
+        release();
+        failed = true;
+        return false;
+    }
+    return true;
+}
+
+bool ShadowMaps::beginCascade(int cascade) {
+    if (failed || (framebuffer == 0 && !create())) {
+        return false;
+    }
+
+    RenderDevice& device = RenderDevice::current();
+    device.bindFramebuffer(framebuffer);
+    device.framebufferTextureLayer(GL_DEPTH_ATTACHMENT, texture, 0, cascade);
+    device.viewport(0, 0, CascadedShadowMap::RESOLUTION, CascadedShadowMap::RESOLUTION);
+    device.clear(glm::vec4(0.0f), GL_DEPTH_BUFFER_BIT);
+    return true;
+}
+
+void ShadowMaps::bind(const ShadowData& data) {
+    RenderDevice& device = RenderDevice::current();
+    if (alignment == 0) {
+        alignment = std::max(device.getInteger(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT), 1);
+    }
+    uniforms.beginFrame(sizeof(ShadowData) + alignment);
+    StreamAllocation allocation = uniforms.allocate(sizeof(ShadowData), alignment);
+    if (!allocation) {
+        return;
+    }
+    std::memcpy(allocation.data, &data, sizeof(ShadowData));
+    if (texture == 0) {
+        // Nothing drawn yet (or the framebuffer failed): the shaders must not sample
+        static_cast<ShadowData*>(allocation.data)->params.x = -1;
+    }
+    uniforms.flush();
+    device.bindBufferRange(
+        GL_UNIFORM_BUFFER, BINDING, allocation.buffer, allocation.offset, sizeof(ShadowData));
+
+    if (texture != 0) {
+        device.bindTexture(UNIT, GL_TEXTURE_2D_ARRAY, texture);
+    }
+}
+
+void ShadowMaps::release() {
+    RenderDevice& device = RenderDevice::current();
+    if (framebuffer != 0) {
+        device.deleteFramebuffer(framebuffer);
+        framebuffer = 0;
+    }
+    if (texture != 0) {
+        device.deleteTexture(texture);
+        texture = 0;
+    }
+    uniforms.release();
+}
@@ -0,0 +1,105 @@
+#include "engine/StaticBatching.h"
+
+#include <algorithm>
+#include <cmath>
+#include <engine/JobSystem.h>
+
+void StaticMerger::merge(const std::vector<StaticInstance>& instances,
+                         std::vector<StaticBatch>& batches) {
+    batches.clear();
+    JobSystem& jobs = JobSystem::shared();
+    size_t count = instances.size();
+
+    origin = glm::vec3(0.0f);
+    if (count > 0) {
+        origin = glm::vec3(instances[0].model[3]);
+        for (const StaticInstance& instance : instances) {
+            origin = glm::min(origin, glm::vec3(instance.model[3]));
+        }
+    }
+
+    entries.resize(count);
+    jobs.parallelFor(count, GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const StaticInstance& instance = instances[i];
+            entries[i] = Entry{
+                instance.material, cellKey(glm::vec3(instance.model[3])), uint32_t(i)};
+        }
+    });
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        if (a.material != b.material) {
+            return a.material < b.material;
+        }
+        return a.cell != b.cell ? a.cell < b.cell : a.instance < b.instance;
+    });
+
+    // Runs of one material and cell become batches; only the offsets are worked out here
+    placements.resize(count);
+    std::vector<size_t> batchVertices;
+    for (size_t i = 0; i < count; ++i) {
+        const Entry& entry = entries[i];
+        size_t vertexCount = instances[entry.instance].vertexCount;
+        bool sameBucket = i > 0 && entry.material == entries[i - 1].material &&
+                          entry.cell == entries[i - 1].cell;
+        if (!sameBucket || batchVertices.back() + vertexCount > MAX_BATCH_VERTICES) {
+            batches.emplace_back();
+            batches.back().material = entry.material;
+            batchVertices.push_back(0);
+        }
+        placements[i] = Placement{uint32_t(batches.size() - 1), batchVertices.back()};
+        batchVertices.back() += vertexCount;
+    }
+    for (size_t batch = 0; batch < batches.size(); ++batch) {
+        batches[batch].vertices.resize(batchVertices[batch] * STRIDE);
+    }
+
+    jobs.parallelFor(count, GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const StaticInstance& instance = instances[entries[i].instance];
+            const float* source = instance.vertices;
+            float* out = batches[placements[i].batch].vertices.data() +
+                         placements[i].vertex * STRIDE;
+            for (uint32_t vertex = 0; vertex < instance.vertexCount; ++vertex) {
+                glm::vec4 position =
+                    instance.model * glm::vec4(source[0], source[1], source[2], 1.0f);
+                out[0] = position.x;
+                out[1] = position.y;
+                out[2] = position.z;
+                out[3] = source[3];
+                out[4] = source[4];
+                out[5] = source[5];
+                out[6] = source[6] * instance.uvTransform.x + instance.uvTransform.z;
+                out[7] = source[7] * instance.uvTransform.y + instance.uvTransform.w;
+                source += STRIDE;
+                out += STRIDE;
+            }
+        }
+    });
+
+    jobs.parallelFor(batches.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t batch = begin; batch < end; ++batch) {
+            const std::vector<float>& vertices = batches[batch].vertices;
+            AABB& bounds = batches[batch].bounds;
+            if (vertices.empty()) {
+                continue;
+            }
+            bounds.min = bounds.max = glm::vec3(vertices[0], vertices[1], vertices[2]);
+            for (size_t i = STRIDE; i < vertices.size(); i += STRIDE) {
+                glm::vec3 position(vertices[i], vertices[i + 1], vertices[i + 2]);
+                bounds.min = glm::min(bounds.min, position);
+                bounds.max = glm::max(bounds.max, position);
+            }
+        }
+    });
+}
+
+// 21 bits per axis, enough for two million cells from the origin
+uint64_t StaticMerger::cellKey(const glm::vec3& position) const {
+    constexpr int64_t limit = (int64_t(1) << 21) - 1;
+    uint64_t key = 0;
+    for (int axis = 0; axis < 3; ++axis) {
+        int64_t cell = int64_t(std::floor((position[axis] - origin[axis]) / cellSize));
+        key = (key << 21) | uint64_t(std::clamp<int64_t>(cell, 0, limit));
+    }
+    return key;
+}
@@ -0,0 +1,179 @@
+#include "engine/StreamBuffer.h"
+
+#include <algorithm>
+#include <engine/RenderDevice.h>
+
+namespace {
+constexpr GLsizeiptr CAPACITY_GRANULARITY = 256;
+constexpr uint64_t FENCE_POLL_NS = 1000000; // 1 ms
+
+GLsizeiptr roundUp(GLsizeiptr value, GLsizeiptr multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+} // namespace
+
+StreamBuffer::StreamBuffer(GLenum target, GLsizeiptr capacity, Mode preferred)
+    : target(target), capacity(roundUp(std::max<GLsizeiptr>(capacity, 1), CAPACITY_GRANULARITY)),
+      preferred(preferred), mode(preferred) {}
+
+void StreamBuffer::create() {
+    RenderDevice& device = RenderDevice::current();
+    buffer = device.createBuffer();
+    device.bindBuffer(target, buffer);
+
+    mode = preferred;
+    if (mode == Mode::Persistent) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLsizeiptr total = capacity * REGION_COUNT;
+        if (device.bufferStorage(target, total, nullptr, flags)) {
+            void* data = device.mapBufferRange(target, 0, total, flags);
+            persistent = static_cast<unsigned char*>(data);
+            if (persistent != nullptr) {
+                return;
+            }
+            // Immutable storage can't be respecified, start over with a fresh buffer
+            device.deleteBuffer(buffer);
+            buffer = device.createBuffer();
+            device.bindBuffer(target, buffer);
+        }
+        mode = Mode::Unsynchronized;
+    }
+
+    if (mode == Mode::Unsynchronized) {
+        device.bufferData(target, capacity * REGION_COUNT, nullptr, GL_STREAM_DRAW);
+    } else {
+        device.bufferData(target, capacity, nullptr, GL_STREAM_DRAW);
+        staging.resize(static_cast<size_t>(capacity));
+    }
+}
+
+void StreamBuffer::beginFrame(GLsizeiptr required) {
+    RenderDevice& device = RenderDevice::current();
+    if (frameOpen) {
+        flush();
+        if (mode != Mode::Orphan) {
+            fences[region] = device.fenceSync();
+        }
+        frameOpen = false;
+    }
+
+    if (required > capacity) {
+        for (int i = 0; i < REGION_COUNT; ++i) {
+            waitForRegion(i);
+        }
+        release();
+        capacity = roundUp(std::max(required, capacity * 2), CAPACITY_GRANULARITY);
+    }
+    if (buffer == 0) {
+        create();
+    }
+
+    region = (region + 1) % REGION_COUNT;
+    waitForRegion(region);
+    cursor = 0;
+    flushed = 0;
+    frameOpen = true;
+}
+
+StreamAllocation StreamBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment) {
+    if (!frameOpen) {
+        beginFrame(size);
+    }
+
+    GLintptr base = regionStart();
+    GLsizeiptr start = roundUp(base + cursor, std::max<GLsizeiptr>(alignment, 1)) - base;
+    if (size <= 0 || start + size > capacity) {
+        return StreamAllocation{};
+    }
+
+    unsigned char* data = nullptr;
+    switch (mode) {
+    case Mode::Persistent:
+        data = persistent + base + start;
+        break;
+    case Mode::Unsynchronized:
+        if (mapped == nullptr) {
+            // The fence on this region already passed, so no implicit sync is needed
+            RenderDevice& device = RenderDevice::current();
+            GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+                                GL_MAP_FLUSH_EXPLICIT_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+            device.bindBuffer(target, buffer);
+            mapped = static_cast<unsigned char*>(
+                device.mapBufferRange(target, base + flushed, capacity - flushed, access));
+            if (mapped == nullptr) {
+                return StreamAllocation{};
+            }
+        }
+        data = mapped + (start - flushed);
+        break;
+    case Mode::Orphan:
+        data = staging.data() + start;
+        break;
+    }
+
+    cursor = start + size;
+    return StreamAllocation{data, buffer, base + start, size};
+}
+
+void StreamBuffer::flush() {
+    if (cursor == flushed) {
+        return;
+    }
+
+    RenderDevice& device = RenderDevice::current();
+    if (mode == Mode::Unsynchronized && mapped != nullptr) {
+        device.bindBuffer(target, buffer);
+        device.flushMappedBufferRange(target, 0, cursor - flushed);
+        device.unmapBuffer(target);
+        mapped = nullptr;
+    } else if (mode == Mode::Orphan) {
+        device.bindBuffer(target, buffer);
+        if (flushed == 0) {
+            // New storage for this frame; draws still reading the old one keep it alive
+            device.bufferData(target, capacity, nullptr, GL_STREAM_DRAW);
+        }
+        device.bufferSubData(target, flushed, cursor - flushed, staging.data() + flushed);
+    }
+    flushed = cursor;
+}
+
+void StreamBuffer::waitForRegion(int index) {
+    GLsync fence = fences[index];
+    if (fence == nullptr) {
+        return;
+    }
+
+    RenderDevice& device = RenderDevice::current();
+    if (!device.clientWaitSync(fence, 0)) {
+        ++stalls;
+        while (!device.clientWaitSync(fence, FENCE_POLL_NS)) {
+        }
+    }
+    device.deleteSync(fence);
+    fences[index] = nullptr;
+}
+
+void StreamBuffer::release() {
+    RenderDevice& device = RenderDevice::current();
+    for (GLsync& fence : fences) {
+        if (fence != nullptr) {
+            device.deleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (buffer != 0) {
+        if (mapped != nullptr) {
+            device.bindBuffer(target, buffer);
+            device.unmapBuffer(target);
+        }
+        device.deleteBuffer(buffer); // Also ends a persistent mapping
+        buffer = 0;
+    }
+    persistent = nullptr;
+    mapped = nullptr;
+    staging.clear();
+    region = REGION_COUNT - 1;
+    cursor = 0;
+    flushed = 0;
+    frameOpen = false;
+}
@@ -0,0 +1,161 @@
+#include "engine/TextureArray.h"
+
+#include <algorithm>
+#include <engine/RenderDevice.h>
+
+namespace {
+int mipLevels(int width, int height) {
+    int levels = 1;
+    while ((width | height) > 1) {
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+        ++levels;
+    }
+    return levels;
+}
+} // namespace
+
+void downsampleRGBA(const uint8_t* source, int width, int height, std::vector<uint8_t>& out) {
+    int outWidth = std::max(width / 2, 1);
+    int outHeight = std::max(height / 2, 1);
+    out.resize(size_t(outWidth) * outHeight * 4);
+    for (int y = 0; y < outHeight; ++y) {
+        int y0 = std::min(y * 2, height - 1);
+        int y1 = std::min(y * 2 + 1, height - 1);
+        for (int x = 0; x < outWidth; ++x) {
+            int x0 = std::min(x * 2, width - 1);
+            int x1 = std::min(x * 2 + 1, width - 1);
+            for (int channel = 0; channel < 4; ++channel) {
+                int sum = source[(size_t(y0) * width + x0) * 4 + channel] +
+                          source[(size_t(y0) * width + x1) * 4 + channel] +
+                          source[(size_t(y1) * width + x0) * 4 + channel] +
+                          source[(size_t(y1) * width + x1) * 4 + channel];
+                out[(size_t(y) * outWidth + x) * 4 + channel] = uint8_t((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+void TextureArrayPool::reserve(int width, int height, int layers) {
+    for (Reservation& reservation : reservations) {
+        if (reservation.width == width && reservation.height == height) {
+            reservation.layers = layers;
+            return;
+        }
+    }
+    reservations.push_back(Reservation{width, height, layers});
+}
+
+TextureLayer TextureArrayPool::add(const unsigned char* rgba, int width, int height) {
+    if (rgba == nullptr || width <= 0 || height <= 0) {
+        return TextureLayer{};
+    }
+
+    Array* target = nullptr;
+    for (Array& array : arrays) {
+        if (array.width == width && array.height == height &&
+            array.usedCount < int(array.used.size())) {
+            target = &array;
+            break;
+        }
+    }
+    if (target == nullptr) {
+        target = &create(width, height);
+    }
+
+    int layer = int(std::find(target->used.begin(), target->used.end(), false) -
+                    target->used.begin());
+    target->used[layer] = true;
+    ++target->usedCount;
+
+    RenderDevice& device = RenderDevice::current();
+    const uint8_t* pixels = rgba;
+    int levelWidth = width;
+    int levelHeight = height;
+    for (int level = 0; level < target->levels; ++level) {
+        device.texSubImage3D(UNIT,
+                             target->texture,
+                             level,
+                             layer,
+                             levelWidth,
+                             levelHeight,
+                             GL_RGBA,
+                             GL_UNSIGNED_BYTE,
+                             pixels);
+        if (level + 1 < target->levels) {
+            std::vector<uint8_t>& next = mipmaps[level % 2];
+            downsampleRGBA(pixels, levelWidth, levelHeight, next);
+            pixels = next.data();
+            levelWidth = std::max(levelWidth / 2, 1);
+            levelHeight = std::max(levelHeight / 2, 1);
+        }
+    }
+    return TextureLayer{target->texture, layer};
+}
+
+void TextureArrayPool::remove(const TextureLayer& layer) {
+    for (size_t i = 0; i < arrays.size(); ++i) {
+        Array& array = arrays[i];
+        if (array.texture != layer.array || layer.layer < 0 ||
+            layer.layer >= int(array.used.size()) || !array.used[layer.layer]) {
+            continue;
+        }
+        array.used[layer.layer] = false;
+        if (--array.usedCount == 0) {
+            RenderDevice::current().deleteTexture(array.texture);
+            arrays.erase(arrays.begin() + i);
+        }
+        return;
+    }
+}
+
+void TextureArrayPool::release() {
+    RenderDevice& device = RenderDevice::current();
+    for (const Array& array : arrays) {
+        device.deleteTexture(array.texture);
+    }
+    arrays.clear();
+}
+
+TextureArrayPool::Array& TextureArrayPool::create(int width, int height) {
+    int levels = mipLevels(width, height);
+    // Every level together takes about a third more than the top one
+    size_t layerBytes = size_t(width) * height * 4 * 4 / 3;
+    int layers = int(std::max<size_t>(ARRAY_BUDGET / layerBytes, 1));
+    for (const Reservation& reservation : reservations) {
+        if (reservation.width == width && reservation.height == height) {
+            layers = reservation.layers;
+        }
+    }
+    layers = std::max(1, std::min(layers, MAX_LAYERS));
+
+    RenderDevice& device = RenderDevice::current();
+    Array array;
+    array.texture = device.createTexture();
+    array.width = width;
+    array.height = height;
+    array.levels = levels;
+    array.used.assign(layers, false);
+    device.bindTexture(UNIT, GL_TEXTURE_2D_ARRAY, array.texture);
+    int levelWidth = width;
+    int levelHeight = height;
+    for (int level = 0; level < levels; ++level) {
+        device.texImage3D(GL_TEXTURE_2D_ARRAY,
+                          level,
+                          GL_RGBA8,
+                          levelWidth,
+                          levelHeight,
+                          layers,
+                          GL_RGBA,
+                          GL_UNSIGNED_BYTE,
+                          nullptr);
+        levelWidth = std::max(levelWidth / 2, 1);
+        levelHeight = std::max(levelHeight / 2, 1);
+    }
+    device.texParameter(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    device.texParameter(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    device.texParameter(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    device.texParameter(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    arrays.push_back(std::move(array));
+    return arrays.back();
+}
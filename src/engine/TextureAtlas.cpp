@@ -0,0 +1,180 @@
+#include "engine/TextureAtlas.h"
+
+#include <algorithm>
+#include <climits>
+#include <engine/RenderDevice.h>
+#include <engine/TextureArray.h>
+
+namespace {
+int alignUp(int value, int alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+AtlasRegion TextureAtlas::add(const unsigned char* rgba, int width, int height) {
+    if (rgba == nullptr || width <= 0 || height <= 0 || width > MAX_IMAGE_SIZE ||
+        height > MAX_IMAGE_SIZE) {
+        return AtlasRegion{};
+    }
+
+    // Sizes stay multiples of BORDER, so every block starts on a texel at each level
+    int blockWidth = alignUp(width, BORDER) + 2 * BORDER;
+    int blockHeight = alignUp(height, BORDER) + 2 * BORDER;
+    int x = 0;
+    int y = 0;
+    Page* target = nullptr;
+    for (Page& page : pages) {
+        if (place(page, blockWidth, blockHeight, x, y)) {
+            target = &page;
+            break;
+        }
+    }
+    if (target == nullptr) {
+        target = &create();
+        place(*target, blockWidth, blockHeight, x, y);
+    }
+    ++target->regionCount;
+
+    upload(*target, rgba, width, height, x, y, blockWidth, blockHeight);
+    AtlasRegion region;
+    region.page = target->texture;
+    region.uvTransform = glm::vec4(float(width) / PAGE_SIZE,
+                                   float(height) / PAGE_SIZE,
+                                   float(x + BORDER) / PAGE_SIZE,
+                                   float(y + BORDER) / PAGE_SIZE);
+    return region;
+}
+
+void TextureAtlas::remove(const AtlasRegion& region) {
+    for (size_t i = 0; i < pages.size(); ++i) {
+        if (pages[i].texture != region.page) {
+            continue;
+        }
+        if (--pages[i].regionCount == 0) {
+            RenderDevice::current().deleteTexture(pages[i].texture);
+            pages.erase(pages.begin() + i);
+        }
+        return;
+    }
+}
+
+void TextureAtlas::release() {
+    RenderDevice& device = RenderDevice::current();
+    for (const Page& page : pages) {
+        device.deleteTexture(page.texture);
+    }
+    pages.clear();
+}
+
+// Bottom-left rule: the lowest top edge wins, then the leftmost position
+bool TextureAtlas::place(Page& page, int width, int height, int& x, int& y) {
+    std::vector<Segment>& skyline = page.skyline;
+    size_t best = skyline.size();
+    int bestTop = INT_MAX;
+    int bestY = 0;
+    for (size_t i = 0; i < skyline.size() && skyline[i].x + width <= PAGE_SIZE; ++i) {
+        // Resting on the highest segment under the whole width
+        int top = 0;
+        int covered = 0;
+        for (size_t j = i; covered < width; ++j) {
+            top = std::max(top, skyline[j].y);
+            covered += skyline[j].width;
+        }
+        if (top + height <= PAGE_SIZE && top + height < bestTop) {
+            best = i;
+            bestTop = top + height;
+            bestY = top;
+        }
+    }
+    if (best == skyline.size()) {
+        return false;
+    }
+
+    x = skyline[best].x;
+    y = bestY;
+
+    // The new span replaces what it covers; a segment sticking out on the right is trimmed
+    size_t end = best;
+    while (end < skyline.size() && skyline[end].x + skyline[end].width <= x + width) {
+        ++end;
+    }
+    if (end < skyline.size() && skyline[end].x < x + width) {
+        skyline[end].width -= x + width - skyline[end].x;
+        skyline[end].x = x + width;
+    }
+    skyline.erase(skyline.begin() + best, skyline.begin() + end);
+    skyline.insert(skyline.begin() + best, Segment{x, bestTop, width});
+
+    // Merge neighbours at the same height so the skyline stays short
+    for (size_t i = 0; i + 1 < skyline.size();) {
+        if (skyline[i].y == skyline[i + 1].y) {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+        } else {
+            ++i;
+        }
+    }
+    return true;
+}
+
+TextureAtlas::Page& TextureAtlas::create() {
+    RenderDevice& device = RenderDevice::current();
+    Page page;
+    page.texture = device.createTexture();
+    page.skyline.push_back(Segment{0, 0, PAGE_SIZE});
+    device.bindTexture(UPLOAD_UNIT, GL_TEXTURE_2D, page.texture);
+    int size = PAGE_SIZE;
+    for (int level = 0; level < LEVELS; ++level) {
+        device.texImage2D(
+            GL_TEXTURE_2D, level, GL_RGBA8, size, size, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        size /= 2;
+    }
+    device.texParameter(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, LEVELS - 1);
+    device.texParameter(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    device.texParameter(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    device.texParameter(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    device.texParameter(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    pages.push_back(std::move(page));
+    return pages.back();
+}
+
+void TextureAtlas::upload(const Page& page,
+                          const unsigned char* rgba,
+                          int width,
+                          int height,
+                          int x,
+                          int y,
+                          int blockWidth,
+                          int blockHeight) {
+    // The image at (BORDER, BORDER), every texel around it a copy of the nearest edge texel
+    block.resize(size_t(blockWidth) * blockHeight * 4);
+    for (int row = 0; row < blockHeight; ++row) {
+        int sourceRow = std::max(0, std::min(row - BORDER, height - 1));
+        const unsigned char* source = rgba + size_t(sourceRow) * width * 4;
+        uint8_t* out = block.data() + size_t(row) * blockWidth * 4;
+        for (int column = 0; column < blockWidth; ++column) {
+            int sourceColumn = std::max(0, std::min(column - BORDER, width - 1));
+            std::copy_n(source + sourceColumn * 4, 4, out + column * 4);
+        }
+    }
+
+    RenderDevice& device = RenderDevice::current();
+    const uint8_t* pixels = block.data();
+    for (int level = 0; level < LEVELS; ++level) {
+        device.texSubImage2D(UPLOAD_UNIT,
+                             page.texture,
+                             level,
+                             x >> level,
+                             y >> level,
+                             blockWidth >> level,
+                             blockHeight >> level,
+                             GL_RGBA,
+                             GL_UNSIGNED_BYTE,
+                             pixels);
+        if (level + 1 < LEVELS) {
+            std::vector<uint8_t>& next = mipmaps[level % 2];
+            downsampleRGBA(pixels, blockWidth >> level, blockHeight >> level, next);
+            pixels = next.data();
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#include "engine/Transparency.h"
+
+#include <engine/RenderDevice.h>
+#include <engine/SceneTarget.h>
+#include <engine/Shader.h>
+
+void WeightedTransparency::declare(RenderGraph& graph, const SceneTarget& scene) {
+    // Targets are only ever read with texelFetch, so filtering and mipmaps don't matter
+    RenderTargetDesc desc;
+    desc.width = scene.getWidth();
+    desc.height = scene.getHeight();
+    desc.internalFormat = GL_RGBA16F;
+    desc.format = GL_RGBA;
+    desc.type = GL_HALF_FLOAT;
+    accumulation = graph.createTexture("accumulation", desc);
+    desc.internalFormat = GL_R16F;
+    desc.format = GL_RED;
+    weights = graph.createTexture("weights", desc);
+}
+
+void WeightedTransparency::beginAccumulation() {
+    RenderDevice& device = RenderDevice::current();
+    // Both targets: no color and no weight yet, everything behind fully revealed
+    device.clear(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), GL_COLOR_BUFFER_BIT);
+    device.blendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void WeightedTransparency::composite(const Shader& shader, const RenderGraph& graph) {
+    RenderDevice& device = RenderDevice::current();
+    if (emptyVAO == 0) {
+        emptyVAO = device.createVertexArray();
+    }
+
+    device.setEnabled(GL_BLEND, true);
+    device.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    device.setEnabled(GL_DEPTH_TEST, false);
+    shader.use();
+    device.bindTexture(ACCUMULATION_UNIT, GL_TEXTURE_2D, graph.getTexture(accumulation));
+    device.bindTexture(WEIGHT_UNIT, GL_TEXTURE_2D, graph.getTexture(weights));
+    device.bindVertexArray(emptyVAO);
+    device.drawArrays(GL_TRIANGLES, 0, 3); // One triangle covering the screen, see the shader
+    device.setEnabled(GL_DEPTH_TEST, true);
+    device.setEnabled(GL_BLEND, false);
+}
+
+void WeightedTransparency::release() {
+    if (emptyVAO != 0) {
+        RenderDevice::current().deleteVertexArray(emptyVAO);
+        emptyVAO = 0;
+    }
+}
@@ -8,6 +8,17 @@
 #include <engine/stb_image.h>
 #include <engine/simpleMeshes.h>
 #include <engine/DeltaTime.h>
+#include <engine/GLState.h>
+#include <engine/RenderThread.h>
+#include <engine/Headless.h>
+#include <engine/RecordingRenderDevice.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <random>
 
 // TODO: Improve our onUpdate ? Maybe we can have for example, the shader and camera inside the
 // SceneManager loop Since we will always have to loop though them, right ? Easy/Medium
@@ -23,9 +34,9 @@
 
 // TODO: Implement fbx animation system
 
-// TODO: Implement lights / shadows
+// TODO: Implement shadows for point and spot lights
 
-// TODO: Implement glass
+// TODO: Glass only tints; add refraction and a Fresnel term
 
 // TODO: Implement sound ?
 
@@ -35,8 +46,59 @@ float LAST_FRAME = 0.0f;
 int SCR_WIDTH = 1280; // Window width
 int SCR_HEIGHT = 720; // Window height
 
+// render thread (--render-thread): owns the GL context, draws the previous frame's snapshot
+bool USE_RENDER_THREAD = false;
+RenderThread<FrameSnapshot> RENDER_THREAD;
+std::atomic<int> FRAMEBUFFER_WIDTH{0}; // Applied by the render thread, GL calls can't run here
+std::atomic<int> FRAMEBUFFER_HEIGHT{0};
+
+// lighting stress test (--lights N): extra random point lights around the cubes
+int EXTRA_LIGHTS = 0;
+
+// particle stress test (--particles N): fountains around the cubes keeping about N particles alive
+int PARTICLES = 0;
+
+// depth prepass (--depth-prepass off|on|auto)
+DepthPrepassMode DEPTH_PREPASS = DepthPrepassMode::Auto;
+
+// dynamic resolution (--frame-budget MS [--min-scale S]): 0 keeps full resolution
+float FRAME_BUDGET = 0.0f;
+float MIN_RENDER_SCALE = 0.5f;
+
+// texture arrays (--texture-arrays on|off): same-size textures share one array and one batch
+bool TEXTURE_ARRAYS = true;
+
+// static batching (--static-batching on|off): Static meshes merged into chunks at load
+bool STATIC_BATCHING = true;
+
+// LOD bias (--lod-bias B): above 1 every MeshLOD switches to coarser levels sooner
+float LOD_BIAS = 1.0f;
+
+// occlusion culling (--occlusion on|off): Occluder meshes hide what is fully behind them
+bool OCCLUSION_CULLING = false;
+
+// GPU culling (--culling cpu|gpu): frustum test of instanced draws in transform feedback
+CullingMode CULLING_MODE = CullingMode::Cpu;
+
+// renderer counters and timings of the latest frame, reported at the end of headless runs
+RenderStats LAST_STATS;
+
+// headless (--headless [--frames N] [--size WxH] [--output image.ppm] [--null-device])
+struct HeadlessOptions {
+    int frames = 300;
+    int width = 1280;
+    int height = 720;
+    std::string output;
+    bool nullDevice = false; ///< No GL context at all, only count the device commands
+};
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);
+    if (USE_RENDER_THREAD) {
+        FRAMEBUFFER_WIDTH = width;
+        FRAMEBUFFER_HEIGHT = height;
+        return;
+    }
+    RenderDevice::current().viewport(0, 0, width, height);
 }
 
 GLFWwindow* initWindow(int width, int height, const char* title) {
@@ -63,10 +125,451 @@ bool initGlad() {
         std::cout << "Failed to initialize GLAD" << "\n";
         return false;
     }
+    GLRenderDevice::loadExtensions((GLADloadproc)glfwGetProcAddress);
     return true;
 }
 
-int main() {
+Scene createPrototypeScene() {
+    return Scene{
+        "Prototype",
+        // onLoad
+        [](entt::registry& reg) {
+            // Camera
+            auto camEnt = reg.create();
+            reg.emplace<Camera>(camEnt);
+            reg.emplace<CameraController>(camEnt);
+
+            // Shaders
+            auto& basic = ResourceManager<ShaderVariants>::load(
+                "basic", "shaders/shader.vert.glsl;shaders/shader.frag.glsl", shaderVariantsLoader);
+            auto& shader = basic.get();
+            shader.use();
+            shader.setInt("texture1", 0);
+            ResourceManager<Shader>::load(
+                "shadow", "shaders/shadow.vert.glsl;shaders/shadow.frag.glsl", shaderLoader);
+            ResourceManager<Shader>::load(
+                "depth", "shaders/depth.vert.glsl;shaders/depth.frag.glsl", shaderLoader);
+            auto& upscale = ResourceManager<Shader>::load(
+                "upscale", "shaders/upscale.vert.glsl;shaders/upscale.frag.glsl", shaderLoader);
+            upscale.use();
+            upscale.setFloat("sharpness", 0.35f);
+            ResourceManager<Shader>::load("composite",
+                                          "shaders/composite.vert.glsl;shaders/composite.frag.glsl",
+                                          shaderLoader);
+            ResourceManager<Shader>::load(
+                "particle", "shaders/particle.vert.glsl;shaders/particle.frag.glsl", shaderLoader);
+
+            // Input
+            auto inputEnt = reg.create();
+            reg.emplace<Input>(inputEnt);
+
+            // Mesh; both textures are 512x512, so with arrays they end up in one
+            auto* loader = TEXTURE_ARRAYS ? layeredTextureLoader : textureLoader;
+            TextureArrayPool::shared().reserve(512, 512, 2);
+            auto& texture = ResourceManager<Texture>::load("brick", "textures/bricks.png", loader);
+            auto& crateTexture =
+                ResourceManager<Texture>::load("container", "textures/container.png", loader);
+
+            MeshRenderer cubeMesh = MeshSystem::createCube(CUBE_VERTICES, sizeof(CUBE_VERTICES));
+            MeshSystem::setTexture(cubeMesh, texture, basic);
+            MeshRenderer crateMesh = cubeMesh;
+            MeshSystem::setTexture(crateMesh, crateTexture, basic);
+            Bounds cubeBounds = MeshSystem::computeBounds(CUBE_VERTICES, sizeof(CUBE_VERTICES));
+
+            // Spawn cubes, every other one a crate
+            for (size_t i = 0; i < std::size(CUBE_POSITIONS); ++i) {
+                auto e = reg.create();
+                Transform transform;
+                transform.position = CUBE_POSITIONS[i];
+                reg.emplace<Transform>(e, transform);
+                reg.emplace<MeshRenderer>(e, i % 2 == 0 ? cubeMesh : crateMesh);
+                reg.emplace<Bounds>(e, cubeBounds);
+                reg.emplace<Static>(e);
+            }
+
+            // Small props; their 128x128 textures pack into one atlas page, so the props share an
+            // instanced draw and tell their images apart by uvTransform
+            const char* propTextures[] = {
+                "textures/bricks_128.png", "textures/container_128.png", "textures/emogi_128.png"};
+            MeshRenderer propMeshes[std::size(propTextures)];
+            for (size_t i = 0; i < std::size(propTextures); ++i) {
+                auto& propTexture = ResourceManager<Texture>::load(
+                    propTextures[i], propTextures[i], atlasTextureLoader);
+                propMeshes[i] = cubeMesh;
+                MeshSystem::setTexture(propMeshes[i], propTexture, basic);
+            }
+            for (int i = 0; i < 6; ++i) {
+                auto prop = reg.create();
+                Transform propTransform;
+                propTransform.position = glm::vec3(-2.5f + 1.0f * i, -1.2f, -1.0f);
+                propTransform.rotation = glm::vec3(0.0f, 25.0f * i, 0.0f);
+                propTransform.scale = glm::vec3(0.4f);
+                reg.emplace<Transform>(prop, propTransform);
+                reg.emplace<MeshRenderer>(prop, propMeshes[i % std::size(propMeshes)]);
+                reg.emplace<Bounds>(prop, cubeBounds);
+            }
+
+            // Back wall; as an Occluder it hides the crates stacked behind it
+            auto wall = reg.create();
+            Transform wallTransform;
+            wallTransform.position = glm::vec3(0.0f, 0.0f, -22.0f);
+            wallTransform.scale = glm::vec3(30.0f, 10.0f, 0.5f);
+            reg.emplace<Transform>(wall, wallTransform);
+            reg.emplace<MeshRenderer>(wall, cubeMesh);
+            reg.emplace<Bounds>(wall, cubeBounds);
+            reg.emplace<Occluder>(
+                wall, MeshSystem::createOccluder(CUBE_VERTICES, sizeof(CUBE_VERTICES)));
+            reg.emplace<Static>(wall);
+            for (int i = 0; i < 4; ++i) {
+                auto hidden = reg.create();
+                Transform hiddenTransform;
+                hiddenTransform.position = glm::vec3(-4.5f + 3.0f * i, -2.5f, -25.0f);
+                reg.emplace<Transform>(hidden, hiddenTransform);
+                reg.emplace<MeshRenderer>(hidden, crateMesh);
+                reg.emplace<Bounds>(hidden, cubeBounds);
+            }
+
+            // Spheres receding along the right side, each drawn at the MeshLOD level its
+            // projected size calls for
+            const int sphereDetail[][2] = {{32, 16}, {16, 8}, {8, 4}};
+            const float sphereMinSizes[] = {0.2f, 0.1f, 0.0f};
+            MeshLOD sphereLOD;
+            for (int level = 0; level < 3; ++level) {
+                std::vector<float> vertices =
+                    sphereVertices(sphereDetail[level][0], sphereDetail[level][1]);
+                sphereLOD.levels.push_back(MeshSystem::createLODLevel(
+                    vertices.data(), vertices.size() * sizeof(float), sphereMinSizes[level]));
+            }
+            MeshRenderer sphereMesh = cubeMesh;
+            sphereMesh.VAO = sphereLOD.levels[0].VAO;
+            sphereMesh.VBO = sphereLOD.levels[0].VBO;
+            sphereMesh.vertexCount = sphereLOD.levels[0].vertexCount;
+            sphereMesh.vertices.reset();
+            for (int i = 0; i < 4; ++i) {
+                auto sphere = reg.create();
+                Transform sphereTransform;
+                sphereTransform.position = glm::vec3(4.0f, -3.25f, -3.0f - 5.0f * i);
+                reg.emplace<Transform>(sphere, sphereTransform);
+                reg.emplace<MeshRenderer>(sphere, sphereMesh);
+                reg.emplace<Bounds>(sphere, cubeBounds);
+                reg.emplace<MeshLOD>(sphere, sphereLOD);
+            }
+
+            // Ground slab under the cubes, to catch their shadows
+            auto ground = reg.create();
+            Transform groundTransform;
+            groundTransform.position = glm::vec3(0.0f, -4.0f, -6.0f);
+            groundTransform.scale = glm::vec3(30.0f, 0.5f, 30.0f);
+            reg.emplace<Transform>(ground, groundTransform);
+            reg.emplace<MeshRenderer>(ground, cubeMesh);
+            reg.emplace<Bounds>(ground, cubeBounds);
+            reg.emplace<Static>(ground);
+
+            // Glass panes in front of the cubes; the last one overlaps the others and takes the
+            // exact sorted path
+            MeshRenderer glassMesh = crateMesh;
+            glassMesh.translucent = true;
+            const glm::vec3 panePositions[] = {
+                {-0.8f, 0.3f, 1.6f}, {0.4f, -0.2f, 1.2f}, {1.4f, 0.5f, 0.8f}};
+            const float paneOpacities[] = {0.45f, 0.3f, 0.5f};
+            for (int i = 0; i < 3; ++i) {
+                auto pane = reg.create();
+                Transform paneTransform;
+                paneTransform.position = panePositions[i];
+                paneTransform.rotation = glm::vec3(0.0f, -20.0f + 20.0f * i, 0.0f);
+                paneTransform.scale = glm::vec3(1.4f, 1.4f, 0.05f);
+                reg.emplace<Transform>(pane, paneTransform);
+                MeshRenderer paneMesh = glassMesh;
+                paneMesh.opacity = paneOpacities[i];
+                paneMesh.sortedBlending = i == 2;
+                reg.emplace<MeshRenderer>(pane, paneMesh);
+                reg.emplace<Bounds>(pane, cubeBounds);
+            }
+
+            // Lights
+            auto sun = reg.create();
+            Transform sunTransform;
+            sunTransform.rotation = glm::vec3(-50.0f, 30.0f, 0.0f);
+            reg.emplace<Transform>(sun, sunTransform);
+            Light sunLight{Light::Type::Directional, glm::vec3(1.0f, 0.95f, 0.85f), 0.6f};
+            sunLight.castShadows = true;
+            reg.emplace<Light>(sun, sunLight);
+
+            const glm::vec3 lampColors[] = {
+                {1.0f, 0.4f, 0.2f}, {0.2f, 0.5f, 1.0f}, {0.3f, 1.0f, 0.4f}};
+            const glm::vec3 lampPositions[] = {
+                {0.0f, 1.5f, 1.5f}, {-2.5f, 0.5f, -4.0f}, {2.0f, 3.0f, -8.0f}};
+            for (int i = 0; i < 3; ++i) {
+                auto lamp = reg.create();
+                Transform lampTransform;
+                lampTransform.position = lampPositions[i];
+                reg.emplace<Transform>(lamp, lampTransform);
+                reg.emplace<Light>(lamp, Light{Light::Type::Point, lampColors[i], 8.0f, 8.0f});
+            }
+
+            std::mt19937 random(42);
+            std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+            for (int i = 0; i < EXTRA_LIGHTS; ++i) {
+                auto light = reg.create();
+                Transform lightTransform;
+                lightTransform.position = glm::vec3(-8.0f + 16.0f * unit(random),
+                                                    -5.0f + 10.0f * unit(random),
+                                                    2.0f - 20.0f * unit(random));
+                reg.emplace<Transform>(light, lightTransform);
+                glm::vec3 color(unit(random), unit(random), unit(random));
+                reg.emplace<Light>(light, Light{Light::Type::Point, color, 2.0f, 1.5f});
+            }
+
+            // Fountains; spawning as fast as the shortest life keeps them at maxParticles
+            const int fountainCount = 8;
+            for (int i = 0; PARTICLES > 0 && i < fountainCount; ++i) {
+                auto fountain = reg.create();
+                Transform fountainTransform;
+                float angle = glm::two_pi<float>() * i / fountainCount;
+                fountainTransform.position =
+                    glm::vec3(6.0f * std::cos(angle), -3.5f, -6.0f + 6.0f * std::sin(angle));
+                reg.emplace<Transform>(fountain, fountainTransform);
+                ParticleEmitter emitter;
+                emitter.maxParticles = static_cast<size_t>(PARTICLES / fountainCount);
+                emitter.minLifetime = 1.5f;
+                emitter.maxLifetime = 2.5f;
+                emitter.rate = emitter.maxParticles / emitter.minLifetime;
+                emitter.extent = glm::vec3(0.2f, 0.0f, 0.2f);
+                emitter.velocity = glm::vec3(0.0f, 6.0f, 0.0f);
+                emitter.spread = 1.5f;
+                emitter.drag = 0.2f;
+                emitter.colorA = glm::vec4(1.0f, 0.6f, 0.2f, 0.8f);
+                emitter.colorB = glm::vec4(0.3f, 0.5f, 1.0f, 0.8f);
+                emitter.seed = 1u + i;
+                reg.emplace<ParticleEmitter>(fountain, std::move(emitter));
+            }
+
+            if (STATIC_BATCHING) {
+                StaticBatchSystem::build(reg);
+            }
+        },
+        // onUnload
+        [](entt::registry& reg) {
+            StaticBatchSystem::clear(reg);        // chunk buffers aren't owned by a resource
+            reg.clear();                          // remove all entities
+            ResourceManager<Shader>::clearAll();  // shaders free automatically
+            ResourceManager<ShaderVariants>::clearAll();
+            ResourceManager<Texture>::clearAll(); // textures deleted in ~Texture
+        },
+        // onUpdate
+        [](entt::registry& reg) {
+            // Register our systems
+            static RenderingSystem renderingSystem{reg};
+            static CameraSystem cameraSystem{reg};
+            static InputSystem inputSystem{reg};
+
+            // Get Needed Instances
+            auto& ShaderInstance = ResourceManager<ShaderVariants>::get("basic").get();
+            renderingSystem.setShadowShader(&ResourceManager<Shader>::get("shadow"));
+            renderingSystem.setCompositeShader(&ResourceManager<Shader>::get("composite"));
+            renderingSystem.setDepthShader(&ResourceManager<Shader>::get("depth"));
+            renderingSystem.setDepthPrepass(DEPTH_PREPASS);
+            renderingSystem.setUpscaleShader(&ResourceManager<Shader>::get("upscale"));
+            renderingSystem.setParticleShader(&ResourceManager<Shader>::get("particle"));
+            static bool configured = false;
+            if (!configured) {
+                DynamicResolution& resolution = renderingSystem.getDynamicResolution();
+                resolution.setEnabled(FRAME_BUDGET > 0.0f);
+                resolution.setScaleRange(MIN_RENDER_SCALE, 1.0f);
+                resolution.setController(std::make_unique<FrameBudgetController>(FRAME_BUDGET));
+                renderingSystem.getGpuCuller().setSources("shaders/cull.vert.glsl",
+                                                          "shaders/cull.geom.glsl");
+                renderingSystem.getCulling().setMode(CULLING_MODE);
+                renderingSystem.getCulling().setOcclusionCulling(OCCLUSION_CULLING);
+                renderingSystem.getLOD().setBias(LOD_BIAS);
+                configured = true;
+            }
+            auto& dtManager = reg.ctx().get<DeltaTime>();
+            auto camView = reg.view<Camera>();
+
+            cameraSystem.update(dtManager.getTime().deltaTime);
+            inputSystem.resetDeltas();
+            if (camView.empty()) {
+                return;
+            }
+            auto& cam = camView.get<Camera>(camView.front());
+            if (!USE_RENDER_THREAD) {
+                renderingSystem.update(ShaderInstance, cam, SCR_WIDTH, SCR_HEIGHT);
+                LAST_STATS = renderingSystem.getStats();
+                return;
+            }
+
+            // Hand the context over on the first frame; from here on this thread makes no GL calls
+            if (!RENDER_THREAD.isRunning()) {
+                GLFWwindow* window = glfwGetCurrentContext();
+                glfwMakeContextCurrent(nullptr);
+                RENDER_THREAD.start(
+                    [window] { glfwMakeContextCurrent(window); },
+                    [window](const FrameSnapshot& snapshot) {
+                        GLState::resetFrameStats();
+                        RenderDevice::current().viewport(
+                            0, 0, FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT);
+                        renderingSystem.submit(snapshot);
+                        glfwSwapBuffers(window);
+                    },
+                    [] {
+                        renderingSystem.release();
+                        glfwMakeContextCurrent(nullptr);
+                    });
+            }
+            renderingSystem.record(
+                ShaderInstance, cam, SCR_WIDTH, SCR_HEIGHT, RENDER_THREAD.acquire());
+            RENDER_THREAD.publish();
+            LAST_STATS = renderingSystem.getStats();
+        }};
+}
+
+// Offscreen benchmark: fixed frame count, frame-time report, optional final image
+int runHeadless(const HeadlessOptions& options) {
+    HeadlessContext headless;
+    RecordingRenderDevice nullDevice;
+    if (options.nullDevice) {
+        nullDevice.setCapture(false);
+        RenderDevice::setCurrent(&nullDevice);
+    } else if (!headless.create(options.width, options.height)) {
+        return -1;
+    }
+    RenderDevice& device = RenderDevice::current();
+    SCR_WIDTH = options.width;
+    SCR_HEIGHT = options.height;
+    device.viewport(0, 0, options.width, options.height); // The null device has no default
+    device.setEnabled(GL_DEPTH_TEST, true);
+
+    entt::registry registry;
+    registry.ctx().emplace<DeltaTime>();
+
+    SceneManager sceneManager;
+    sceneManager.addScene(createPrototypeScene());
+    sceneManager.switchTo("Prototype", registry);
+
+    auto& dtManager = registry.ctx().get<DeltaTime>();
+    FrameTimeStats frameTimes;
+    nullDevice.reset(); // Only count per-frame work, not the scene load
+    for (int frame = 0; frame < options.frames; ++frame) {
+        auto frameStart = std::chrono::steady_clock::now();
+        dtManager.calculateDeltaTime();
+        GLState::resetFrameStats();
+        sceneManager.update(registry);
+        device.finish(); // Stands in for the swap, so the time includes the GPU work
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - frameStart;
+        frameTimes.add(elapsed.count());
+    }
+    frameTimes.report(std::cout);
+    LAST_STATS.cpuTimings.report(std::cout, "cpu");
+    LAST_STATS.gpuTimings.report(std::cout, "gpu");
+    std::cout << "state calls: " << LAST_STATS.stateCalls.issued << " issued, "
+              << LAST_STATS.stateCalls.elided << " elided\n";
+    std::cout << "culled: " << LAST_STATS.frustumCulled << " frustum, "
+              << LAST_STATS.occlusionCulled << " occlusion\n";
+    std::cout << "lod levels:";
+    for (uint32_t count : LAST_STATS.lodLevels) {
+        std::cout << " " << count;
+    }
+    std::cout << "\n";
+    if (options.nullDevice) {
+        nullDevice.report(std::cout, options.frames);
+    }
+
+    if (!options.output.empty() && headless.saveImage(options.output)) {
+        std::cout << "Saved last frame to " << options.output << "\n";
+    }
+
+    // Resources must go while the context is still alive
+    StaticBatchSystem::clear(registry);
+    registry.clear();
+    ResourceManager<Shader>::clearAll();
+    ResourceManager<ShaderVariants>::clearAll();
+    ResourceManager<Texture>::clearAll();
+    RenderDevice::setCurrent(nullptr);
+    return 0;
+}
+
+// Read an on|off flag value into @p enabled; anything else is reported and returns false
+bool parseSwitch(const char* flag, const char* value, bool& enabled) {
+    if (std::strcmp(value, "on") == 0 || std::strcmp(value, "off") == 0) {
+        enabled = value[1] == 'n';
+        return true;
+    }
+    std::cout << "Unknown " << flag << " mode '" << value << "', expected off|on\n";
+    return false;
+}
+
+int main(int argc, char** argv) {
+    bool headless = false;
+    HeadlessOptions headlessOptions;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--render-thread") == 0) {
+            USE_RENDER_THREAD = true;
+        } else if (std::strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        } else if (std::strcmp(argv[i], "--frames") == 0 && hasValue) {
+            headlessOptions.frames = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--size") == 0 && hasValue) {
+            std::sscanf(argv[++i], "%dx%d", &headlessOptions.width, &headlessOptions.height);
+        } else if (std::strcmp(argv[i], "--output") == 0 && hasValue) {
+            headlessOptions.output = argv[++i];
+        } else if (std::strcmp(argv[i], "--lights") == 0 && hasValue) {
+            EXTRA_LIGHTS = std::max(std::atoi(argv[++i]), 0);
+        } else if (std::strcmp(argv[i], "--particles") == 0 && hasValue) {
+            PARTICLES = std::max(std::atoi(argv[++i]), 0);
+        } else if (std::strcmp(argv[i], "--frame-budget") == 0 && hasValue) {
+            FRAME_BUDGET = std::max(float(std::atof(argv[++i])), 0.0f);
+        } else if (std::strcmp(argv[i], "--min-scale") == 0 && hasValue) {
+            MIN_RENDER_SCALE = float(std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--depth-prepass") == 0 && hasValue) {
+            const char* mode = argv[++i];
+            if (std::strcmp(mode, "on") == 0) {
+                DEPTH_PREPASS = DepthPrepassMode::On;
+            } else if (std::strcmp(mode, "off") == 0) {
+                DEPTH_PREPASS = DepthPrepassMode::Off;
+            } else if (std::strcmp(mode, "auto") == 0) {
+                DEPTH_PREPASS = DepthPrepassMode::Auto;
+            } else {
+                std::cout << "Unknown --depth-prepass mode '" << mode
+                          << "', expected off|on|auto\n";
+                return -1;
+            }
+        } else if (std::strcmp(argv[i], "--texture-arrays") == 0 && hasValue) {
+            if (!parseSwitch("--texture-arrays", argv[++i], TEXTURE_ARRAYS)) {
+                return -1;
+            }
+        } else if (std::strcmp(argv[i], "--static-batching") == 0 && hasValue) {
+            if (!parseSwitch("--static-batching", argv[++i], STATIC_BATCHING)) {
+                return -1;
+            }
+        } else if (std::strcmp(argv[i], "--lod-bias") == 0 && hasValue) {
+            LOD_BIAS = float(std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--occlusion") == 0 && hasValue) {
+            if (!parseSwitch("--occlusion", argv[++i], OCCLUSION_CULLING)) {
+                return -1;
+            }
+        } else if (std::strcmp(argv[i], "--culling") == 0 && hasValue) {
+            const char* mode = argv[++i];
+            if (std::strcmp(mode, "cpu") == 0) {
+                CULLING_MODE = CullingMode::Cpu;
+            } else if (std::strcmp(mode, "gpu") == 0) {
+                CULLING_MODE = CullingMode::Gpu;
+            } else {
+                std::cout << "Unknown --culling mode '" << mode << "', expected cpu|gpu\n";
+                return -1;
+            }
+        } else if (std::strcmp(argv[i], "--null-device") == 0) {
+            headlessOptions.nullDevice = true;
+            headless = true;
+        }
+    }
+    if (headless) {
+        USE_RENDER_THREAD = false; // The benchmark loop owns its context
+        return runHeadless(headlessOptions);
+    }
+
     // --- Initialize GLFW and GLAD ---
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -90,9 +593,15 @@ int main() {
         std::cout << "Failed to initialize GLAD\n";
         return -1;
     }
+    GLRenderDevice::loadExtensions((GLADloadproc)glfwGetProcAddress);
 
-    glEnable(GL_DEPTH_TEST);
+    RenderDevice::current().setEnabled(GL_DEPTH_TEST, true);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    int framebufferWidth = 0;
+    int framebufferHeight = 0;
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    FRAMEBUFFER_WIDTH = framebufferWidth;
+    FRAMEBUFFER_HEIGHT = framebufferHeight;
 
     // --- ECS registry ---
     entt::registry registry;
@@ -126,66 +635,7 @@ int main() {
     });
 
     // --- Create our scene ---
-    Scene prototypeScene{
-        "Prototype",
-        // onLoad
-        [](entt::registry& reg) {
-            // Camera
-            auto camEnt = reg.create();
-            reg.emplace<Camera>(camEnt);
-            reg.emplace<CameraController>(camEnt);
-
-            // Shaders
-            auto& shader = ResourceManager<Shader>::load(
-                "basic", "shaders/shader.vert.glsl;shaders/shader.frag.glsl", shaderLoader);
-            shader.use();
-            shader.setInt("texture1", 0);
-
-            // Input
-            auto inputEnt = reg.create();
-            reg.emplace<Input>(inputEnt);
-
-            // Mesh
-            auto& texture =
-                ResourceManager<Texture>::load("brick", "textures/bricks.png", textureLoader);
-
-            MeshRenderer cubeMesh =
-                MeshSystem::createCube(CUBE_VERTICES, sizeof(CUBE_VERTICES), texture.getId());
-
-            // Spawn cubes
-            for (auto& pos : CUBE_POSITIONS) {
-                auto e = reg.create();
-                Transform transform;
-                transform.position = pos;
-                reg.emplace<Transform>(e, transform);
-                reg.emplace<MeshRenderer>(e, cubeMesh);
-            }
-        },
-        // onUnload
-        [](entt::registry& reg) {
-            reg.clear();                          // remove all entities
-            ResourceManager<Shader>::clearAll();  // shaders free automatically
-            ResourceManager<Texture>::clearAll(); // textures deleted in ~Texture
-        },
-        // onUpdate
-        [](entt::registry& reg) {
-            // Register our systems
-            static RenderingSystem renderingSystem{reg};
-            static CameraSystem cameraSystem{reg};
-            static InputSystem inputSystem{reg};
-
-            // Get Needed Instances
-            auto& ShaderInstance = ResourceManager<Shader>::get("basic");
-            auto& dtManager = reg.ctx().get<DeltaTime>();
-            auto camView = reg.view<Camera>();
-
-            cameraSystem.update(dtManager.getTime().deltaTime);
-            inputSystem.resetDeltas();
-            if (!camView.empty()) {
-                auto& cam = camView.get<Camera>(camView.front());
-                renderingSystem.update(ShaderInstance, cam, SCR_WIDTH, SCR_HEIGHT);
-            }
-        }};
+    Scene prototypeScene = createPrototypeScene();
 
     // --- SceneManager setup ---
     SceneManager sceneManager;
@@ -198,12 +648,21 @@ int main() {
         dtManager.calculateDeltaTime();
 
         // update scene (input + camera + rendering are handled in onUpdate)
-        sceneManager.update(registry);
-
-        glfwSwapBuffers(window);
+        if (!USE_RENDER_THREAD) {
+            GLState::resetFrameStats();
+            sceneManager.update(registry);
+            glfwSwapBuffers(window);
+        } else {
+            sceneManager.update(registry); // Records a snapshot, the render thread presents it
+        }
         glfwPollEvents();
     }
 
+    // Drain the frames in flight and take the context back before GLFW goes away
+    if (RENDER_THREAD.isRunning()) {
+        RENDER_THREAD.stop();
+        glfwMakeContextCurrent(window);
+    }
     glfwTerminate();
     return 0;
 }
\ No newline at end of file